@@ -336,6 +336,8 @@ int main(int /* argc */, char** /* argv */)
         }
     }
 
+    // Make sure the last readings are out before disconnecting
+    wolk->publishFuture().wait();
     wolk->disconnect();
     return 0;
 }
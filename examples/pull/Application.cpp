@@ -136,6 +136,7 @@ int main(int /* argc */, char** /* argv */)
                   .caCertPath(CA_CERT_PATH)
                   .feedUpdateHandler(feedHandler)
                   .parameterHandler(parameterHandler)
+                  .withPublishSchedule(wolkabout::connect::PublishSchedule{0, 0, std::chrono::milliseconds(500)})
                   .buildWolkSingle();
 
     // And now we will periodically connect, pull values, maybe even send some of our own, and then disconnect
@@ -148,15 +149,14 @@ int main(int /* argc */, char** /* argv */)
         wolk->pullFeedValues();
         wolk->pullParameters();
 
-        // Sleep a bit, and wait to send some of our own
+        // Sleep a bit, and send some of our own
         std::this_thread::sleep_for(std::chrono::seconds(2));
         wolk->addReading("SW", false);
-        wolk->publish();
 
-        // And then we disconnect
-        std::this_thread::sleep_for(std::chrono::seconds(8));
+        // And then we disconnect, as soon as the reading is out, and stay offline for a while
+        wolk->publishFuture().wait();
         wolk->disconnect();
-        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        std::this_thread::sleep_for(std::chrono::seconds(8));
     }
     wolk->disconnect();
     return 0;
@@ -54,15 +54,18 @@ int main(int /* argc */, char** /* argv */)
     auto device = wolkabout::Device(DEVICE_KEY, DEVICE_PASSWORD, wolkabout::OutboundDataMode::PUSH);
 
     // And here we create the wolk session
-    auto wolk = wolkabout::connect::WolkSingle::newBuilder(device).host(PLATFORM_HOST).buildWolkSingle();
+    // The readings will be published automatically, at the latest a second after they were added
+    auto wolk = wolkabout::connect::WolkSingle::newBuilder(device)
+                  .host(PLATFORM_HOST)
+                  .withPublishSchedule(wolkabout::connect::PublishSchedule{0, 0, std::chrono::milliseconds(1000)})
+                  .buildWolkSingle();
     wolk->connect();
 
-    // And now we will periodically (and endlessly) send a random temperature value.
+    // And now we will periodically (and endlessly) add a random temperature value.
     while (true)
     {
         wolk->addReading("T", generateRandomValue());
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        wolk->publish();
     }
     return 0;
 }
@@ -50,12 +50,13 @@ int main(int /* argc */, char** /* argv */)
                   .buildWolkMulti();
     wolk->connect();
     wolk->addReading(deviceOne.getKey(), "π", 3.14);
-    wolk->publish();
     wolk->pullFeedValues(deviceTwo.getKey());
     wolk->pullParameters(deviceTwo.getKey());
 
-    // Now we can sleep a little bit
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    // Instead of sleeping, we can wait for the publish to be done, and see how it went
+    const auto result = wolk->publishFuture().get();
+    LOG(INFO) << "Published " << result.sentReadings << " reading(s) in " << result.sentMessages << " message(s), "
+              << result.failedMessages << " message(s) failed.";
     wolk->addDevice(deviceThree);
 
     // Put them in an array
@@ -65,9 +66,12 @@ int main(int /* argc */, char** /* argv */)
     {
         // Now let's add a new device
         wolk->addReading(deviceThree.getKey(), "APM", 400);
-        wolk->publish();
+        wolk->publishAsync([](const wolkabout::connect::PublishResult& published) {
+            if (published.failedMessages > 0)
+                LOG(WARN) << "Failed to publish " << published.failedMessages << " message(s).";
+        });
 
-        // We can sleep again
+        // We can sleep until the next reading
         std::this_thread::sleep_for(std::chrono::seconds(5));
     }
 
@@ -0,0 +1,112 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <sstream>
+
+#define private public
+#define protected public
+#include "wolk/service/data/BatchSizeController.h"
+#undef private
+#undef protected
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout::connect;
+
+TEST(BatchSizeControllerTests, FixedBatchSizeNeverChanges)
+{
+    auto controller = BatchSizeController{20};
+    EXPECT_FALSE(controller.isAdaptive());
+    EXPECT_EQ(controller.getBatchSize(), 20);
+
+    controller.reportSuccess(20, 1000);
+    EXPECT_EQ(controller.getBatchSize(), 20);
+    controller.reportFailure();
+    EXPECT_EQ(controller.getBatchSize(), 20);
+    controller.reportOversized(20, 1000000);
+    EXPECT_EQ(controller.getBatchSize(), 20);
+}
+
+TEST(BatchSizeControllerTests, DefaultBatchSize)
+{
+    EXPECT_EQ(BatchSizeController{}.getBatchSize(), BatchSizeController::DEFAULT_BATCH_SIZE);
+    EXPECT_EQ(BatchSizeController{0}.getBatchSize(), 1);
+}
+
+TEST(BatchSizeControllerTests, AdaptiveInitialIsClamped)
+{
+    EXPECT_EQ((BatchSizeController{1, 10, 100, 0}.getBatchSize()), 10);
+    EXPECT_EQ((BatchSizeController{1000, 10, 100, 0}.getBatchSize()), 100);
+    EXPECT_EQ((BatchSizeController{50, 100, 10, 0}.getBatchSize()), 100);
+}
+
+TEST(BatchSizeControllerTests, AdaptiveGrowsOnFullBatches)
+{
+    auto controller = BatchSizeController{10, 1, 100, 0};
+    ASSERT_TRUE(controller.isAdaptive());
+
+    // A batch that was not full does not tell us anything
+    controller.reportSuccess(5, 50);
+    EXPECT_EQ(controller.getBatchSize(), 10);
+
+    controller.reportSuccess(10, 100);
+    EXPECT_EQ(controller.getBatchSize(), 20);
+    controller.reportSuccess(20, 200);
+    controller.reportSuccess(40, 400);
+    controller.reportSuccess(80, 800);
+    EXPECT_EQ(controller.getBatchSize(), 100);
+}
+
+TEST(BatchSizeControllerTests, AdaptiveGrowthIsCappedByPacketSize)
+{
+    auto controller = BatchSizeController{10, 1, 1000, 250};
+    controller.reportSuccess(10, 100);
+    EXPECT_EQ(controller.getBatchSize(), 20);
+    controller.reportSuccess(20, 200);
+    EXPECT_EQ(controller.getBatchSize(), 25);
+}
+
+TEST(BatchSizeControllerTests, AdaptiveShrinksOnFailure)
+{
+    auto controller = BatchSizeController{64, 10, 100, 0};
+    controller.reportFailure();
+    EXPECT_EQ(controller.getBatchSize(), 32);
+    controller.reportFailure();
+    controller.reportFailure();
+    EXPECT_EQ(controller.getBatchSize(), 10);
+}
+
+TEST(BatchSizeControllerTests, AdaptiveShrinksWhenOversized)
+{
+    auto controller = BatchSizeController{100, 1, 100, 1000};
+    controller.reportOversized(100, 4000);
+    EXPECT_EQ(controller.getBatchSize(), 25);
+    controller.reportOversized(25, 1200);
+    EXPECT_EQ(controller.getBatchSize(), 12);
+}
+
+TEST(BatchSizeControllerTests, CopyKeepsState)
+{
+    auto controller = BatchSizeController{10, 1, 100, 500};
+    controller.reportSuccess(10, 100);
+    auto copy = BatchSizeController{};
+    copy = controller;
+    EXPECT_TRUE(copy.isAdaptive());
+    EXPECT_EQ(copy.getBatchSize(), 20);
+    EXPECT_EQ(copy.getMaxPacketSize(), 500);
+}
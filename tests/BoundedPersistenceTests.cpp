@@ -0,0 +1,231 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <limits>
+#include <map>
+#include <sstream>
+
+#define private public
+#define protected public
+#include "wolk/persistence/BoundedPersistence.h"
+#undef private
+#undef protected
+
+#include "core/persistence/inmemory/InMemoryPersistence.h"
+#include "wolk/persistence/BatchPersistence.h"
+#include "wolk/persistence/ReadingSize.h"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout;
+using namespace wolkabout::connect;
+
+namespace
+{
+std::unique_ptr<BoundedPersistence> makePersistence(EvictionPolicy policy, std::uint64_t maxReadings,
+                                                    std::uint64_t maxBytes = 0, std::uint64_t parameter = 0)
+{
+    return std::unique_ptr<BoundedPersistence>{new BoundedPersistence{
+      std::unique_ptr<Persistence>{new InMemoryPersistence}, policy, maxReadings, maxBytes, parameter}};
+}
+
+// Counts how the bounded persistence reaches into the persistence it wraps
+class CountingPersistence : public InMemoryPersistence, public BatchPersistence
+{
+public:
+    bool putReadings(const std::string& key, std::vector<Reading>&& readings) override
+    {
+        for (const auto& reading : readings)
+            if (!InMemoryPersistence::putReading(key, reading))
+                return false;
+        return true;
+    }
+
+    bool visitReadings(const std::string& key, const std::function<void(const Reading&)>& visitor) override
+    {
+        ++visits;
+        for (const auto& reading :
+             InMemoryPersistence::getReadings(key, std::numeric_limits<std::uint_fast64_t>::max()))
+            visitor(*reading);
+        return true;
+    }
+
+    std::vector<std::shared_ptr<Reading>> getReadings(const std::string& key, std::uint_fast64_t count) override
+    {
+        ++gets;
+        return InMemoryPersistence::getReadings(key, count);
+    }
+
+    void removeReadings(const std::string& key, std::uint_fast64_t count) override
+    {
+        removals.emplace_back(key, count);
+        InMemoryPersistence::removeReadings(key, count);
+    }
+
+    int visits = 0;
+    int gets = 0;
+    std::vector<std::pair<std::string, std::uint_fast64_t>> removals;
+};
+}    // namespace
+
+TEST(BoundedPersistenceTests, DropOldestKeepsTheNewestReadings)
+{
+    auto persistence = makePersistence(EvictionPolicy::DropOldest, 3);
+    ASSERT_TRUE(persistence->putReading("D+A", Reading{"A", std::string{"1"}, 1}));
+    ASSERT_TRUE(persistence->putReading("D+B", Reading{"B", std::string{"2"}, 2}));
+    ASSERT_TRUE(persistence->putReading("D+A", Reading{"A", std::string{"3"}, 3}));
+    ASSERT_TRUE(persistence->putReading("D+B", Reading{"B", std::string{"4"}, 4}));
+    ASSERT_TRUE(persistence->putReading("D+B", Reading{"B", std::string{"5"}, 5}));
+
+    EXPECT_EQ(persistence->getBufferedReadings(), 3);
+    EXPECT_EQ(persistence->getCounters().evictedReadings, 2);
+    const auto a = persistence->getReadings("D+A", 10);
+    ASSERT_EQ(a.size(), 1);
+    EXPECT_EQ(a.front()->getStringValue(), "3");
+    EXPECT_EQ(persistence->getReadings("D+B", 10).size(), 2);
+}
+
+TEST(BoundedPersistenceTests, ByteLimit)
+{
+    const auto size = estimateReadingSize(Reading{"T", std::string{"1"}, 1});
+    auto persistence = makePersistence(EvictionPolicy::DropOldest, 0, 4 * size);
+    for (auto i = 0; i < 10; ++i)
+        ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::to_string(i), std::uint64_t(i)}));
+
+    EXPECT_EQ(persistence->getBufferedReadings(), 4);
+    EXPECT_EQ(persistence->getBufferedBytes(), 4 * size);
+    EXPECT_EQ(persistence->getCounters().evictedBytes, 6 * size);
+    EXPECT_EQ(persistence->getReadings("D+T", 10).front()->getStringValue(), "6");
+}
+
+TEST(BoundedPersistenceTests, RemovedReadingsFreeTheSpace)
+{
+    auto persistence = makePersistence(EvictionPolicy::DropOldest, 2);
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"1"}, 1}));
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"2"}, 2}));
+    persistence->removeReadings("D+T", 2);
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"3"}, 3}));
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"4"}, 4}));
+
+    EXPECT_EQ(persistence->getCounters().evictedReadings, 0);
+    EXPECT_EQ(persistence->getBufferedReadings(), 2);
+    EXPECT_TRUE(persistence->m_heads.size() == 1);
+}
+
+TEST(BoundedPersistenceTests, DownsampleKeepsEveryNthReadingWhileFull)
+{
+    auto persistence = makePersistence(EvictionPolicy::Downsample, 2, 0, 3);
+    for (auto i = 0; i < 8; ++i)
+        ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::to_string(i), std::uint64_t(i)}));
+
+    // 0 and 1 fill the buffer, and then only 2 and 5 are kept from the rest
+    const auto readings = persistence->getReadings("D+T", 10);
+    ASSERT_EQ(readings.size(), 2);
+    EXPECT_EQ(readings[0]->getStringValue(), "2");
+    EXPECT_EQ(readings[1]->getStringValue(), "5");
+    EXPECT_EQ(persistence->getCounters().downsampledReadings, 4);
+    EXPECT_EQ(persistence->getCounters().evictedReadings, 2);
+}
+
+TEST(BoundedPersistenceTests, PerFeedQuota)
+{
+    auto persistence = makePersistence(EvictionPolicy::PerFeedQuota, 0, 0, 2);
+    for (auto i = 0; i < 5; ++i)
+        ASSERT_TRUE(persistence->putReading("D+F", Reading{"F", std::to_string(i), std::uint64_t(i)}));
+    ASSERT_TRUE(persistence->putReading("D+S", Reading{"S", std::string{"1"}, 1}));
+
+    EXPECT_EQ(persistence->getReadings("D+F", 10).size(), 2);
+    EXPECT_EQ(persistence->getReadings("D+F", 10).front()->getStringValue(), "3");
+    EXPECT_EQ(persistence->getReadings("D+S", 10).size(), 1);
+    EXPECT_EQ(persistence->getCounters().quotaEvictedReadings, 3);
+}
+
+TEST(BoundedPersistenceTests, ExistingReadingsAreCounted)
+{
+    auto inner = std::unique_ptr<Persistence>{new InMemoryPersistence};
+    for (auto i = 0; i < 5; ++i)
+        ASSERT_TRUE(inner->putReading("D+T", Reading{"T", std::to_string(i), std::uint64_t(i)}));
+
+    auto persistence = BoundedPersistence{std::move(inner), EvictionPolicy::DropOldest, 3};
+    EXPECT_EQ(persistence.getBufferedReadings(), 3);
+    EXPECT_EQ(persistence.getReadings("D+T", 10).front()->getStringValue(), "2");
+}
+
+TEST(BoundedPersistenceTests, ExistingReadingsAreVisitedAndEvictedOncePerKey)
+{
+    auto inner = std::unique_ptr<CountingPersistence>{new CountingPersistence};
+    for (auto i = 0; i < 5; ++i)
+        ASSERT_TRUE(inner->putReading("D+T", Reading{"T", std::to_string(i), std::uint64_t(i)}));
+    ASSERT_TRUE(inner->putReading("D+S", Reading{"S", std::string{"5"}, 5}));
+    auto& counting = *inner;
+
+    auto persistence = BoundedPersistence{std::move(inner), EvictionPolicy::DropOldest, 2};
+    EXPECT_EQ(counting.visits, 2);
+    EXPECT_EQ(counting.gets, 0);
+    auto removed = std::map<std::string, std::uint_fast64_t>{};
+    for (const auto& removal : counting.removals)
+        EXPECT_TRUE(removed.emplace(removal.first, removal.second).second);
+    EXPECT_EQ(removed["D+S"] + removed["D+T"], 4);
+    EXPECT_EQ(persistence.getBufferedReadings(), 2);
+}
+
+TEST(BoundedPersistenceTests, LargeReadingEvictsOncePerKey)
+{
+    const auto size = estimateReadingSize(Reading{"T", std::string{"1"}, 1});
+    auto inner = std::unique_ptr<CountingPersistence>{new CountingPersistence};
+    auto& counting = *inner;
+    auto persistence = BoundedPersistence{std::move(inner), EvictionPolicy::DropOldest, 0, 4 * size};
+    for (auto i = 0; i < 4; ++i)
+        ASSERT_TRUE(persistence.putReading("D+T", Reading{"T", std::to_string(i), std::uint64_t(i)}));
+    ASSERT_TRUE(counting.removals.empty());
+
+    ASSERT_TRUE(persistence.putReading("D+T", Reading{"T", std::string(2 * size, 'x'), std::uint64_t{4}}));
+    ASSERT_EQ(counting.removals.size(), 1);
+    EXPECT_EQ(counting.removals.front().second, 3);
+    EXPECT_EQ(persistence.getBufferedReadings(), 2);
+}
+
+TEST(BoundedPersistenceTests, PutReadingsEvictsLikePutReading)
+{
+    auto batched = makePersistence(EvictionPolicy::PerFeedQuota, 5, 0, 3);
+    auto single = makePersistence(EvictionPolicy::PerFeedQuota, 5, 0, 3);
+    for (const auto& persistence : {batched.get(), single.get()})
+    {
+        ASSERT_TRUE(persistence->putReading("D+A", Reading{"A", std::string{"A"}, 0}));
+        ASSERT_TRUE(persistence->putReading("D+A", Reading{"A", std::string{"B"}, 0}));
+    }
+
+    auto readings = std::vector<Reading>{};
+    for (auto i = 0; i < 6; ++i)
+        readings.emplace_back("T", std::to_string(i), std::uint64_t(i));
+    for (const auto& reading : readings)
+        ASSERT_TRUE(single->putReading("D+T", reading));
+    ASSERT_TRUE(batched->putReadings("D+T", std::move(readings)));
+
+    EXPECT_EQ(batched->getBufferedReadings(), single->getBufferedReadings());
+    EXPECT_EQ(batched->getCounters().evictedReadings, single->getCounters().evictedReadings);
+    EXPECT_EQ(batched->getCounters().quotaEvictedReadings, single->getCounters().quotaEvictedReadings);
+    for (const auto& key : {"D+A", "D+T"})
+    {
+        const auto expected = single->getReadings(key, 10);
+        const auto actual = batched->getReadings(key, 10);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (auto i = std::size_t{0}; i < actual.size(); ++i)
+            EXPECT_EQ(actual[i]->getStringValue(), expected[i]->getStringValue());
+    }
+}
@@ -0,0 +1,84 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "core/model/Message.h"
+#include "wolk/protocol/CompressedDataProtocol.h"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout;
+using namespace wolkabout::connect;
+
+namespace
+{
+FeedValuesMessage makeFeedValues(std::uint64_t count)
+{
+    auto readings = std::vector<Reading>{};
+    for (auto i = std::uint64_t{0}; i < count; ++i)
+        readings.emplace_back("T", std::to_string(i % 10), 1638537962000 + i);
+    return FeedValuesMessage{readings};
+}
+}    // namespace
+
+TEST(CompressedDataProtocolTests, CompressRoundTrip)
+{
+    auto data = std::string{};
+    for (auto i = 0; i < 1000; ++i)
+        data += R"({"T":)" + std::to_string(i % 7) + R"(,"timestamp":1638537962000},)";
+
+    auto compressed = std::string{};
+    ASSERT_TRUE(CompressedDataProtocol::compress(data, compressed));
+    EXPECT_LT(compressed.size() * 5, data.size());
+
+    auto decompressed = std::string{};
+    ASSERT_TRUE(CompressedDataProtocol::decompress(compressed, decompressed));
+    EXPECT_EQ(decompressed, data);
+
+    // Truncated data is not accepted
+    EXPECT_FALSE(CompressedDataProtocol::decompress(compressed.substr(0, compressed.size() / 2), decompressed));
+}
+
+TEST(CompressedDataProtocolTests, LargeFeedValuesAreCompressed)
+{
+    auto plainProtocol = WolkaboutDataProtocol{};
+    auto compressedProtocol = CompressedDataProtocol{};
+
+    const auto plain = plainProtocol.makeOutboundMessage("D", makeFeedValues(100));
+    const auto compressed = compressedProtocol.makeOutboundMessage("D", makeFeedValues(100));
+    ASSERT_NE(plain, nullptr);
+    ASSERT_NE(compressed, nullptr);
+    EXPECT_EQ(compressed->getChannel(), plain->getChannel() + CompressedDataProtocol::COMPRESSED_CHANNEL_SUFFIX);
+    EXPECT_LT(compressed->getContent().size(), plain->getContent().size());
+
+    auto decompressed = std::string{};
+    ASSERT_TRUE(CompressedDataProtocol::decompress(compressed->getContent(), decompressed));
+    EXPECT_EQ(decompressed, plain->getContent());
+}
+
+TEST(CompressedDataProtocolTests, SmallFeedValuesAreNotCompressed)
+{
+    auto plainProtocol = WolkaboutDataProtocol{};
+    auto compressedProtocol = CompressedDataProtocol{1024};
+
+    const auto plain = plainProtocol.makeOutboundMessage("D", makeFeedValues(1));
+    const auto compressed = compressedProtocol.makeOutboundMessage("D", makeFeedValues(1));
+    ASSERT_NE(plain, nullptr);
+    ASSERT_NE(compressed, nullptr);
+    EXPECT_EQ(compressed->getChannel(), plain->getChannel());
+    EXPECT_EQ(compressed->getContent(), plain->getContent());
+}
@@ -15,7 +15,9 @@
  */
 
 #include <any>
+#include <set>
 #include <sstream>
+#include <thread>
 #include <utility>
 
 #define private public
@@ -26,12 +28,15 @@
 
 #include "core/Types.h"
 #include "core/model/Feed.h"
+#include "core/persistence/inmemory/InMemoryPersistence.h"
 #include "core/utilities/Logger.h"
 #include "tests/mocks/ConnectivityServiceMock.h"
 #include "tests/mocks/DataProtocolMock.h"
 #include "tests/mocks/OutboundMessageHandlerMock.h"
 #include "tests/mocks/OutboundRetryMessageHandlerMock.h"
 #include "tests/mocks/PersistenceMock.h"
+#include "wolk/persistence/BoundedPersistence.h"
+#include "wolk/persistence/ReadingSize.h"
 
 #include <gtest/gtest.h>
 
@@ -52,10 +57,9 @@ public:
         persistenceMock = std::make_shared<PersistenceMock>();
 
         // Set up the callback
-        _internalFeedUpdateSetHandler = [&](const std::string& deviceKey,
-                                            const std::map<std::uint64_t, std::vector<Reading>>& readings) {
+        _internalFeedUpdateSetHandler = [&](const std::string& deviceKey, SharedFeedValues readings) {
             if (feedUpdateSetHandler)
-                feedUpdateSetHandler(deviceKey, readings);
+                feedUpdateSetHandler(deviceKey, std::move(readings));
         };
         _internalParameterSyncHandler = [&](const std::string& deviceKey, const std::vector<Parameter>& parameters) {
             if (parameterSyncHandler)
@@ -102,102 +106,130 @@ public:
     DetailsSyncHandler _internalDetailsSyncHandler;
 };
 
-TEST_F(DataServiceTests, MakePersistenceKey)
-{
-    EXPECT_EQ(service->makePersistenceKey(DEVICE_KEY, "T"), DEVICE_KEY + "+T");
-}
-
-TEST_F(DataServiceTests, ParsePersistenceKeyInvalid)
-{
-    auto pair = std::pair<std::string, std::string>{};
-    ASSERT_NO_FATAL_FAILURE(pair = service->parsePersistenceKey("AB"));
-    EXPECT_TRUE(pair.first.empty());
-    EXPECT_TRUE(pair.second.empty());
-}
-
-TEST_F(DataServiceTests, ParsePersistenceKey)
-{
-    auto pair = std::pair<std::string, std::string>{};
-    ASSERT_NO_FATAL_FAILURE(pair = service->parsePersistenceKey("A+B"));
-    EXPECT_EQ(pair.first, "A");
-    EXPECT_EQ(pair.second, "B");
-}
-
 TEST_F(DataServiceTests, PublishReadingsFromPersistenceEmptyPersistence)
 {
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T"}));
     EXPECT_CALL(*persistenceMock, getReadings).WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
     EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>())).Times(0);
-    ASSERT_NO_FATAL_FAILURE(service->publishReadingsForPersistenceKey(""));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
 }
 
 TEST_F(DataServiceTests, PublishReadingsEmptyDeviceKey)
 {
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{""}));
     EXPECT_CALL(*persistenceMock, getReadings)
       .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "TestValue", 123456789)}));
     EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>())).Times(0);
-    ASSERT_NO_FATAL_FAILURE(service->publishReadingsForPersistenceKey(""));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
 }
 
 TEST_F(DataServiceTests, PublishReadingsFailsToParse)
 {
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T"}));
     EXPECT_CALL(*persistenceMock, getReadings)
       .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "TestValue", 123456789)}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "TestValue", 123456789)}));
+    EXPECT_CALL(*persistenceMock, removeReadings(DEVICE_KEY + "+T", 1)).Times(1);
     EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
       .WillOnce(Return(ByMove(nullptr)));
-    ASSERT_NO_FATAL_FAILURE(service->publishReadingsForPersistenceKey(DEVICE_KEY + "+" + "T"));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
 }
 
 TEST_F(DataServiceTests, PublishReadingsHappyFlow)
 {
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T"}));
     EXPECT_CALL(*persistenceMock, getReadings)
       .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "TestValue", 123456789)}))
       .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    // The published readings are looked up again, to remove only the ones that were not evicted in the meantime
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "TestValue", 123456789)}));
     EXPECT_CALL(*persistenceMock, removeReadings).Times(1);
     EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
       .WillOnce(Return(ByMove(std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}})));
     EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(true));
-    ASSERT_NO_FATAL_FAILURE(service->publishReadingsForPersistenceKey(DEVICE_KEY + "+" + "T"));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
 }
 
 TEST_F(DataServiceTests, CheckIfSubscriptionExistButItsEmpty)
 {
-    ASSERT_FALSE(service->checkIfSubscriptionIsWaiting(ParametersUpdateMessage{{}}));
+    ASSERT_FALSE(service->checkIfSubscriptionIsWaiting(DEVICE_KEY, ParametersUpdateMessage{{}}));
 }
 
 TEST_F(DataServiceTests, CheckIfSubscriptionExistTwoSubscription)
 {
     // Add the two subscriptions
-    service->m_parameterSubscriptions.emplace(
-      0, DataService::ParameterSubscription{
-           {ParameterName::FIRMWARE_UPDATE_REPOSITORY, ParameterName::FIRMWARE_UPDATE_CHECK_TIME},
-           [](const std::vector<Parameter>&) {}});
-    service->m_parameterSubscriptions.emplace(
-      1, DataService::ParameterSubscription{{ParameterName::FILE_TRANSFER_PLATFORM_ENABLED},
-                                            [](const std::vector<Parameter>&) {}});
+    service->addParameterSubscription(
+      DEVICE_KEY, {ParameterName::FIRMWARE_UPDATE_REPOSITORY, ParameterName::FIRMWARE_UPDATE_CHECK_TIME},
+      [](const std::vector<Parameter>&) {});
+    service->addParameterSubscription(DEVICE_KEY, {ParameterName::FILE_TRANSFER_PLATFORM_ENABLED},
+                                      [](const std::vector<Parameter>&) {});
     std::atomic_bool callbackCalled{false};
     std::mutex mutex;
     std::condition_variable conditionVariable;
-    service->m_parameterSubscriptions.emplace(
-      2, DataService::ParameterSubscription{{ParameterName::EXTERNAL_ID}, [&](const std::vector<Parameter>&) {
-                                                callbackCalled = true;
-                                                conditionVariable.notify_one();
-                                            }});
+    service->addParameterSubscription(DEVICE_KEY, {ParameterName::EXTERNAL_ID}, [&](const std::vector<Parameter>&) {
+        callbackCalled = true;
+        conditionVariable.notify_one();
+    });
 
     // Now parse the subscription
-    ASSERT_TRUE(
-      service->checkIfSubscriptionIsWaiting(ParametersUpdateMessage{{{ParameterName::EXTERNAL_ID, "TestValue"}}}));
+    ASSERT_TRUE(service->checkIfSubscriptionIsWaiting(
+      DEVICE_KEY, ParametersUpdateMessage{{{ParameterName::EXTERNAL_ID, "TestValue"}}}));
     if (!callbackCalled)
     {
         std::unique_lock<std::mutex> lock{mutex};
         conditionVariable.wait_for(lock, std::chrono::milliseconds{100});
     }
     EXPECT_TRUE(callbackCalled);
+    EXPECT_EQ(service->m_parameterSubscriptions.size(), 2);
+    EXPECT_EQ(service->m_subscriptionDeadlines.size(), 2);
+}
+
+TEST_F(DataServiceTests, CheckIfSubscriptionIgnoresTheOrderOfNames)
+{
+    service->addParameterSubscription(DEVICE_KEY,
+                                      {ParameterName::FIRMWARE_UPDATE_REPOSITORY, ParameterName::FIRMWARE_VERSION},
+                                      [](const std::vector<Parameter>&) {});
+
+    EXPECT_FALSE(service->checkIfSubscriptionIsWaiting(
+      DEVICE_KEY, ParametersUpdateMessage{{{ParameterName::FIRMWARE_VERSION, "1.0.0"}}}));
+    EXPECT_TRUE(service->checkIfSubscriptionIsWaiting(
+      DEVICE_KEY, ParametersUpdateMessage{{{ParameterName::FIRMWARE_VERSION, "1.0.0"},
+                                           {ParameterName::FIRMWARE_UPDATE_REPOSITORY, "repository"}}}));
+    EXPECT_TRUE(service->m_parameterSubscriptions.empty());
+    EXPECT_TRUE(service->m_subscriptionDeadlines.empty());
+}
+
+TEST_F(DataServiceTests, CheckIfSubscriptionIsScopedToTheDevice)
+{
+    service->addParameterSubscription(DEVICE_KEY, {ParameterName::EXTERNAL_ID}, [](const std::vector<Parameter>&) {});
+
+    EXPECT_FALSE(service->checkIfSubscriptionIsWaiting(
+      "OTHER_DEVICE", ParametersUpdateMessage{{{ParameterName::EXTERNAL_ID, "TestValue"}}}));
+    EXPECT_TRUE(service->checkIfSubscriptionIsWaiting(
+      DEVICE_KEY, ParametersUpdateMessage{{{ParameterName::EXTERNAL_ID, "TestValue"}}}));
+}
+
+TEST_F(DataServiceTests, CheckIfSubscriptionTimesOut)
+{
+    service->setParameterSubscriptionTimeout(std::chrono::milliseconds{0});
+    service->addParameterSubscription(DEVICE_KEY, {ParameterName::EXTERNAL_ID}, [](const std::vector<Parameter>&) {});
+    service->setParameterSubscriptionTimeout(std::chrono::milliseconds{60000});
+    service->addParameterSubscription(DEVICE_KEY, {ParameterName::FIRMWARE_VERSION},
+                                      [](const std::vector<Parameter>&) {});
+
+    // The expired subscription was dropped once the next one was added
+    EXPECT_EQ(service->m_parameterSubscriptions.size(), 1);
+    EXPECT_EQ(service->m_subscriptionDeadlines.size(), 1);
+    EXPECT_FALSE(service->checkIfSubscriptionIsWaiting(
+      DEVICE_KEY, ParametersUpdateMessage{{{ParameterName::EXTERNAL_ID, "TestValue"}}}));
 }
 
 TEST_F(DataServiceTests, CheckIfCallbackNoCallbacks)
 {
     ASSERT_TRUE(service->m_detailsCallbacks.empty());
-    ASSERT_FALSE(service->checkIfCallbackIsWaiting({{}, {}}));
+    ASSERT_FALSE(service->checkIfCallbackIsWaiting(DEVICE_KEY, {{}, {}}));
 }
 
 TEST_F(DataServiceTests, CheckIfCallbackFinallyACallback)
@@ -205,18 +237,64 @@ TEST_F(DataServiceTests, CheckIfCallbackFinallyACallback)
     std::atomic_bool called{false};
     std::mutex mutex;
     std::condition_variable conditionVariable;
-    ASSERT_NO_FATAL_FAILURE(
-      service->m_detailsCallbacks.push([&](const std::vector<std::string>&, const std::vector<std::string>&) {
+    ASSERT_NO_FATAL_FAILURE(service->addDetailsCallback(
+      DEVICE_KEY, [&](const std::vector<std::string>&, const std::vector<std::string>&) {
           called = true;
           conditionVariable.notify_one();
       }));
-    ASSERT_TRUE(service->checkIfCallbackIsWaiting({{}, {}}));
+    ASSERT_TRUE(service->checkIfCallbackIsWaiting(DEVICE_KEY, {{}, {}}));
     if (!called)
     {
         std::unique_lock<std::mutex> lock{mutex};
         conditionVariable.wait_for(lock, std::chrono::milliseconds{100});
     }
     EXPECT_TRUE(called);
+    EXPECT_TRUE(service->m_detailsCallbacks.empty());
+    EXPECT_TRUE(service->m_detailsDeadlines.empty());
+}
+
+TEST_F(DataServiceTests, CheckIfCallbackIsCorrelatedToTheDevice)
+{
+    std::mutex mutex;
+    std::condition_variable conditionVariable;
+    auto received = std::map<std::string, std::vector<std::string>>{};
+    const auto makeCallback = [&](const std::string& name) {
+        return [&, name](const std::vector<std::string>& feeds, const std::vector<std::string>&) {
+            std::lock_guard<std::mutex> lock{mutex};
+            received[name] = feeds;
+            conditionVariable.notify_one();
+        };
+    };
+    service->addDetailsCallback("D1", makeCallback("first"));
+    service->addDetailsCallback("D2", makeCallback("second"));
+    service->addDetailsCallback("D1", makeCallback("third"));
+
+    // The response of the second device goes to its own callback, even though the first device requested earlier
+    ASSERT_TRUE(service->checkIfCallbackIsWaiting("D2", {{"F2"}, {}}));
+    ASSERT_TRUE(service->checkIfCallbackIsWaiting("D1", {{"F1"}, {}}));
+    ASSERT_FALSE(service->checkIfCallbackIsWaiting("D3", {{"F3"}, {}}));
+
+    std::unique_lock<std::mutex> lock{mutex};
+    conditionVariable.wait_for(lock, std::chrono::milliseconds{100}, [&] { return received.size() == 2; });
+    EXPECT_EQ(received["second"], std::vector<std::string>{"F2"});
+    EXPECT_EQ(received["first"], std::vector<std::string>{"F1"});
+    EXPECT_EQ(received.count("third"), 0);
+    EXPECT_EQ(service->m_detailsCallbacks.size(), 1);
+}
+
+TEST_F(DataServiceTests, CheckIfCallbackTimesOut)
+{
+    service->addDetailsCallback(DEVICE_KEY, [](const std::vector<std::string>&, const std::vector<std::string>&) {});
+    ASSERT_EQ(service->m_detailsDeadlines.size(), 1);
+
+    // Move the deadline into the past
+    const auto entry = service->m_detailsDeadlines.begin()->second;
+    service->m_detailsDeadlines.clear();
+    service->m_detailsDeadlines.emplace(std::chrono::steady_clock::now() - std::chrono::seconds{1}, entry);
+
+    EXPECT_FALSE(service->checkIfCallbackIsWaiting(DEVICE_KEY, {{}, {}}));
+    EXPECT_TRUE(service->m_detailsCallbacks.empty());
+    EXPECT_TRUE(service->m_detailsDeadlines.empty());
 }
 
 TEST_F(DataServiceTests, AddReadingSingleStringReading)
@@ -246,6 +324,191 @@ TEST_F(DataServiceTests, AddReadings)
                                                             {"T", std::uint64_t{789}, 1234567892}}));
 }
 
+TEST_F(DataServiceTests, AddReadingsUsesBatchPersistence)
+{
+    // Unlimited, so it only stores the readings in batches
+    BoundedPersistence persistence{std::unique_ptr<Persistence>{new InMemoryPersistence}, EvictionPolicy::DropOldest,
+                                   0};
+    service = std::make_shared<DataService>(*dataProtocolMock, persistence, *connectivityServiceMock,
+                                            *outboundRetryMessageHandlerMock, _internalFeedUpdateSetHandler,
+                                            _internalParameterSyncHandler, _internalDetailsSyncHandler);
+    ASSERT_EQ(service->m_batchPersistence, &persistence);
+
+    auto readings = std::vector<Reading>{{"T", std::uint64_t{1}, 1}, {"H", std::uint64_t{2}, 2},
+                                         {"T", std::uint64_t{3}, 3}, {"H", std::uint64_t{4}, 4},
+                                         {"T", std::uint64_t{5}, 5}};
+    ASSERT_NO_FATAL_FAILURE(service->addReadings(DEVICE_KEY, std::move(readings)));
+
+    EXPECT_EQ(service->getIndexedReadingsKeys(DEVICE_KEY).size(), 2);
+    const auto temperature = persistence.getReadings(DEVICE_KEY + "+T", 10);
+    ASSERT_EQ(temperature.size(), 3);
+    EXPECT_EQ(temperature[0]->getTimestamp(), 1);
+    EXPECT_EQ(temperature[1]->getTimestamp(), 3);
+    EXPECT_EQ(temperature[2]->getTimestamp(), 5);
+    EXPECT_EQ(persistence.getReadings(DEVICE_KEY + "+H", 10).size(), 2);
+    service.reset();
+}
+
+TEST_F(DataServiceTests, EvictionWhilePublishingDoesNotLoseReadings)
+{
+    // Only two readings fit, so storing the third one while the first two are being published evicts one of them
+    BoundedPersistence persistence{std::unique_ptr<Persistence>{new InMemoryPersistence}, EvictionPolicy::DropOldest,
+                                   2};
+    service = std::make_shared<DataService>(*dataProtocolMock, persistence, *connectivityServiceMock,
+                                            *outboundRetryMessageHandlerMock, _internalFeedUpdateSetHandler,
+                                            _internalParameterSyncHandler, _internalDetailsSyncHandler);
+    service->addReading(DEVICE_KEY, Reading{"T", std::uint64_t{1}, 1});
+    service->addReading(DEVICE_KEY, Reading{"T", std::uint64_t{2}, 2});
+
+    auto published = std::set<std::uint64_t>{};
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(DEVICE_KEY, A<FeedValuesMessage>()))
+      .WillRepeatedly([&](const std::string&, const FeedValuesMessage& message) {
+          for (const auto& readings : message.getReadings())
+              published.emplace(readings.first);
+          return std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}};
+      });
+    auto producer = std::thread{};
+    std::atomic_bool stored{false};
+    auto storedWhilePublishing = false;
+    EXPECT_CALL(*connectivityServiceMock, publish)
+      .WillOnce([&](const std::shared_ptr<wolkabout::Message>&) {
+          producer = std::thread{[&] {
+              service->addReading(DEVICE_KEY, Reading{"T", std::uint64_t{3}, 3});
+              stored = true;
+          }};
+          // Storing is not held up by the publish
+          const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+          while (!stored && std::chrono::steady_clock::now() < deadline)
+              std::this_thread::sleep_for(std::chrono::milliseconds{1});
+          storedWhilePublishing = stored;
+          return true;
+      })
+      .WillRepeatedly(Return(true));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
+    producer.join();
+    EXPECT_TRUE(storedWhilePublishing);
+
+    // Every reading was either published, or is still waiting in persistence
+    for (const auto& reading : persistence.getReadings(DEVICE_KEY + "+T", 10))
+        published.emplace(reading->getTimestamp());
+    EXPECT_EQ(published, (std::set<std::uint64_t>{1, 2, 3}));
+    service.reset();
+}
+
+TEST_F(DataServiceTests, EvictionOfAllPublishedReadingsRemovesNothing)
+{
+    BoundedPersistence persistence{std::unique_ptr<Persistence>{new InMemoryPersistence}, EvictionPolicy::DropOldest,
+                                   2};
+    service = std::make_shared<DataService>(*dataProtocolMock, persistence, *connectivityServiceMock,
+                                            *outboundRetryMessageHandlerMock, _internalFeedUpdateSetHandler,
+                                            _internalParameterSyncHandler, _internalDetailsSyncHandler);
+    service->addReading(DEVICE_KEY, Reading{"T", std::uint64_t{1}, 1});
+    service->addReading(DEVICE_KEY, Reading{"T", std::uint64_t{2}, 2});
+
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(DEVICE_KEY, A<FeedValuesMessage>()))
+      .WillRepeatedly([](const std::string&, const FeedValuesMessage&) {
+          return std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}};
+      });
+    EXPECT_CALL(*connectivityServiceMock, publish)
+      .WillOnce([&](const std::shared_ptr<wolkabout::Message>&) {
+          // Both published readings are evicted before they are removed
+          service->addReading(DEVICE_KEY, Reading{"T", std::uint64_t{3}, 3});
+          service->addReading(DEVICE_KEY, Reading{"T", std::uint64_t{4}, 4});
+          return true;
+      })
+      .WillOnce(Return(false));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
+
+    // The readings stored in the meantime are not removed in place of the evicted ones
+    const auto readings = persistence.getReadings(DEVICE_KEY + "+T", 10);
+    ASSERT_EQ(readings.size(), 2);
+    EXPECT_EQ(readings[0]->getTimestamp(), 3);
+    EXPECT_EQ(readings[1]->getTimestamp(), 4);
+    service.reset();
+}
+
+TEST_F(DataServiceTests, ReadingsAddedListener)
+{
+    auto count = std::uint64_t{0};
+    auto bytes = std::uint64_t{0};
+    service->setReadingsAddedListener([&](std::uint64_t addedCount, std::uint64_t addedBytes) {
+        count += addedCount;
+        bytes += addedBytes;
+    });
+    EXPECT_CALL(*persistenceMock, putReading).Times(3);
+
+    service->addReading(DEVICE_KEY, "T", "1", 1);
+    service->addReadings(DEVICE_KEY, std::vector<Reading>{{"T", std::string{"2"}, 2}, {"H", std::string{"3"}, 3}});
+    EXPECT_EQ(count, 3);
+    EXPECT_EQ(bytes, estimateReadingSize(Reading{"T", std::string{"1"}, 1}) * 3);
+}
+
+TEST_F(DataServiceTests, FeedFilterIsAppliedBeforeStoring)
+{
+    auto filter = FeedFilter{};
+    filter.reportOnChange = true;
+    service->setFeedFilter(DEVICE_KEY, "T", filter);
+    EXPECT_CALL(*persistenceMock, putReading(DEVICE_KEY + "+T", _)).Times(2).WillRepeatedly(Return(true));
+    EXPECT_CALL(*persistenceMock, putReading(DEVICE_KEY + "+H", _)).Times(2).WillRepeatedly(Return(true));
+
+    service->addReading(DEVICE_KEY, "T", "1", 1);
+    service->addReading(DEVICE_KEY, "T", "1", 2);
+    service->addReadings(DEVICE_KEY, std::vector<Reading>{{"T", std::string{"1"}, 3},
+                                                          {"H", std::string{"1"}, 3},
+                                                          {"H", std::string{"1"}, 4},
+                                                          {"T", std::string{"2"}, 4}});
+
+    // Removing the feed removes the filter
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(_, A<FeedRemovalMessage>())).WillOnce(Return(ByMove(nullptr)));
+    service->removeFeed(DEVICE_KEY, "T");
+    EXPECT_TRUE(service->m_feedFilters.empty());
+}
+
+TEST_F(DataServiceTests, AggregatedFeedStoresOneReadingPerWindow)
+{
+    service->setFeedAggregation(DEVICE_KEY, "T",
+                                FeedAggregation{std::chrono::milliseconds{1000}, {AggregationStatistic::Max}});
+    auto stored = std::vector<Reading>{};
+    EXPECT_CALL(*persistenceMock, putReading(DEVICE_KEY + "+T", _))
+      .Times(2)
+      .WillRepeatedly([&](const std::string&, const Reading& reading) {
+          stored.emplace_back(reading);
+          return true;
+      });
+
+    service->addReading(DEVICE_KEY, "T", "1", 1000);
+    service->addReading(DEVICE_KEY, "T", "3", 1500);
+    service->addReadings(DEVICE_KEY,
+                         std::vector<Reading>{{"T", std::string{"2"}, 1999}, {"T", std::string{"7"}, 2000}});
+    ASSERT_EQ(stored.size(), 1);
+    EXPECT_EQ(stored.front().getStringValue(), "3");
+    EXPECT_EQ(stored.front().getTimestamp(), 1000);
+
+    // The window in progress is closed when the aggregation is removed
+    service->setFeedAggregation(DEVICE_KEY, "T", FeedAggregation{});
+    ASSERT_EQ(stored.size(), 2);
+    EXPECT_EQ(stored.back().getStringValue(), "7");
+    EXPECT_TRUE(service->m_aggregationWindows.empty());
+}
+
+TEST_F(DataServiceTests, AggregatedReadingsAreReportedAndClosedWindowsAreStored)
+{
+    auto count = std::uint64_t{0};
+    service->setReadingsAddedListener([&](std::uint64_t addedCount, std::uint64_t) { count += addedCount; });
+    service->setFeedAggregation(DEVICE_KEY, "T",
+                                FeedAggregation{std::chrono::milliseconds{1000}, {AggregationStatistic::Max}});
+
+    // The reading only goes into the window, but it is reported, so a scheduled publish gets to close the window
+    EXPECT_CALL(*persistenceMock, putReading).Times(0);
+    service->addReading(DEVICE_KEY, "T", "1", 1000);
+    EXPECT_EQ(count, 1);
+    ASSERT_TRUE(Mock::VerifyAndClearExpectations(persistenceMock.get()));
+
+    EXPECT_CALL(*persistenceMock, putReading(DEVICE_KEY + "+T", _)).WillOnce(Return(true));
+    service->closeAggregationWindows();
+    EXPECT_EQ(count, 2);
+}
+
 TEST_F(DataServiceTests, AddAttribute)
 {
     EXPECT_CALL(*persistenceMock, putAttribute).Times(1);
@@ -430,6 +693,236 @@ TEST_F(DataServiceTests, PublishReadings)
     ASSERT_NO_FATAL_FAILURE(service->publishReadings(DEVICE_KEY));
 }
 
+TEST_F(DataServiceTests, PublishReadingsForDeviceSeedsIndexFromPersistence)
+{
+    EXPECT_CALL(*persistenceMock, getReadingsKeys)
+      .WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T", "OTHER_DEVICE+T"}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", _))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    EXPECT_CALL(*persistenceMock, getReadings("OTHER_DEVICE+T", _)).Times(0);
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings(DEVICE_KEY));
+    EXPECT_EQ(service->m_readingsIndex.count(DEVICE_KEY), 0);
+    EXPECT_EQ(service->m_readingsIndex.count("OTHER_DEVICE"), 1);
+}
+
+TEST_F(DataServiceTests, PublishReadingsForDeviceUsesIndex)
+{
+    service->m_readingsIndexSeeded = true;
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).Times(0);
+    EXPECT_CALL(*persistenceMock, putReading).Times(2);
+    ASSERT_NO_FATAL_FAILURE(service->addReading(DEVICE_KEY, "T", "1", 1));
+    ASSERT_NO_FATAL_FAILURE(service->addReading("OTHER_DEVICE", "T", "2", 2));
+
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", _))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}));
+    EXPECT_CALL(*persistenceMock, getReadings("OTHER_DEVICE+T", _)).Times(0);
+    EXPECT_CALL(*persistenceMock, removeReadings(DEVICE_KEY + "+T", 1)).Times(1);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(DEVICE_KEY, A<FeedValuesMessage>()))
+      .WillOnce(Return(ByMove(std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}})));
+    EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(true));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings(DEVICE_KEY));
+    EXPECT_EQ(service->m_readingsIndex.count(DEVICE_KEY), 0);
+    EXPECT_EQ(service->m_readingsIndex["OTHER_DEVICE"].size(), 1);
+}
+
+TEST_F(DataServiceTests, PublishReadingsPerDeviceCoalescesFeeds)
+{
+    service->setReadingsPublishMode(ReadingsPublishMode::PerDevice);
+    EXPECT_CALL(*persistenceMock, getReadingsKeys)
+      .WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T", DEVICE_KEY + "+H", "OTHER_DEVICE+T"}));
+    auto served = std::set<std::string>{};
+    EXPECT_CALL(*persistenceMock, getReadings).WillRepeatedly([&](const std::string& key, std::uint_fast64_t count) {
+        // A single reading is only looked up to check the front before the published readings are removed
+        if (count != 1 && !served.insert(key).second)
+            return std::vector<std::shared_ptr<Reading>>{};
+        return std::vector<std::shared_ptr<Reading>>{
+          std::make_shared<Reading>(key.substr(key.size() - 1), "TestValue", 123456789)};
+    });
+    EXPECT_CALL(*persistenceMock, removeReadings(_, 1)).Times(3);
+    auto messageSizes = std::map<std::string, std::size_t>{};
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
+      .Times(2)
+      .WillRepeatedly([&](const std::string& deviceKey, const FeedValuesMessage& message) {
+          for (const auto& readings : message.getReadings())
+              messageSizes[deviceKey] += readings.second.size();
+          return std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}};
+      });
+    EXPECT_CALL(*connectivityServiceMock, publish).Times(2).WillRepeatedly(Return(true));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
+    EXPECT_EQ(messageSizes[DEVICE_KEY], 2);
+    EXPECT_EQ(messageSizes["OTHER_DEVICE"], 1);
+}
+
+TEST_F(DataServiceTests, PublishReadingsPerDeviceRespectsReadingsBudget)
+{
+    service->setReadingsPublishMode(ReadingsPublishMode::PerDevice, 2);
+    EXPECT_CALL(*persistenceMock, getReadingsKeys)
+      .WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T", DEVICE_KEY + "+H"}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", _))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1),
+                                                             std::make_shared<Reading>("T", "2", 2),
+                                                             std::make_shared<Reading>("T", "3", 3)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "3", 3)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+H", _))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("H", "4", 4)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "3", 3)}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+H", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("H", "4", 4)}));
+    EXPECT_CALL(*persistenceMock, removeReadings(DEVICE_KEY + "+T", 2)).Times(1);
+    EXPECT_CALL(*persistenceMock, removeReadings(DEVICE_KEY + "+T", 1)).Times(1);
+    EXPECT_CALL(*persistenceMock, removeReadings(DEVICE_KEY + "+H", 1)).Times(1);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
+      .Times(2)
+      .WillRepeatedly([&](const std::string&, const FeedValuesMessage& message) {
+          EXPECT_EQ(message.getReadings().size(), 2);
+          return std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}};
+      });
+    EXPECT_CALL(*connectivityServiceMock, publish).Times(2).WillRepeatedly(Return(true));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
+}
+
+TEST_F(DataServiceTests, PublishReadingsPerDeviceFailsToPublish)
+{
+    service->setReadingsPublishMode(ReadingsPublishMode::PerDevice);
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T"}));
+    EXPECT_CALL(*persistenceMock, getReadings)
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "TestValue", 123456789)}));
+    EXPECT_CALL(*persistenceMock, removeReadings).Times(0);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
+      .WillOnce(Return(ByMove(std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}})));
+    EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(false));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
+}
+
+TEST_F(DataServiceTests, PublishReadingsSliceStopsWhenBudgetIsSpent)
+{
+    EXPECT_CALL(*persistenceMock, getReadingsKeys)
+      .WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T", DEVICE_KEY + "+H"}));
+    EXPECT_CALL(*persistenceMock, getReadings)
+      .WillRepeatedly(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}));
+    EXPECT_CALL(*persistenceMock, removeReadings(_, 1)).Times(3);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
+      .Times(3)
+      .WillRepeatedly([](const std::string&, const FeedValuesMessage&) {
+          return std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"Payload", ""}};
+      });
+    EXPECT_CALL(*connectivityServiceMock, publish).Times(3).WillRepeatedly(Return(true));
+
+    auto result = PublishSliceResult{};
+    ASSERT_NO_FATAL_FAILURE(result = service->publishReadingsSlice(PublishBudget{3}));
+    EXPECT_EQ(result.sentMessages, 3);
+    EXPECT_EQ(result.sentReadings, 3);
+    EXPECT_EQ(result.sentBytes, 21);
+    EXPECT_EQ(result.failedMessages, 0);
+    EXPECT_TRUE(result.backlogRemaining);
+}
+
+TEST_F(DataServiceTests, PublishReadingsSliceDrainsEverything)
+{
+    EXPECT_CALL(*persistenceMock, getReadingsKeys)
+      .WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T", DEVICE_KEY + "+H"}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", _))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+H", _))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("H", "1", 1)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("H", "2", 2)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+H", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("H", "1", 1)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("H", "2", 2)}));
+    EXPECT_CALL(*persistenceMock, removeReadings(_, 1)).Times(3);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
+      .Times(3)
+      .WillRepeatedly([](const std::string&, const FeedValuesMessage&) {
+          return std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}};
+      });
+    EXPECT_CALL(*connectivityServiceMock, publish).Times(3).WillRepeatedly(Return(true));
+
+    auto result = PublishSliceResult{};
+    ASSERT_NO_FATAL_FAILURE(result = service->publishReadingsSlice(PublishBudget{10}));
+    EXPECT_EQ(result.sentMessages, 3);
+    EXPECT_FALSE(result.backlogRemaining);
+}
+
+TEST_F(DataServiceTests, PublishReadingsSliceFailsToPublish)
+{
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T"}));
+    EXPECT_CALL(*persistenceMock, getReadings)
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}));
+    EXPECT_CALL(*persistenceMock, removeReadings).Times(0);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
+      .WillOnce(Return(ByMove(std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}})));
+    EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(false));
+
+    auto result = PublishSliceResult{};
+    ASSERT_NO_FATAL_FAILURE(result = service->publishReadingsSlice(PublishBudget{10}));
+    EXPECT_EQ(result.sentMessages, 0);
+    EXPECT_EQ(result.failedMessages, 1);
+    EXPECT_FALSE(result.backlogRemaining);
+}
+
+TEST_F(DataServiceTests, PublishReadingsUsesConfiguredBatchSize)
+{
+    service->setBatchSizeController(BatchSizeController{5});
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T"}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 5))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
+}
+
+TEST_F(DataServiceTests, PublishReadingsAdaptiveBatchSizeGrows)
+{
+    service->setBatchSizeController(BatchSizeController{2, 1, 10, 0});
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T"}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 2))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1),
+                                                             std::make_shared<Reading>("T", "2", 2)}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 4))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}));
+    EXPECT_CALL(*persistenceMock, removeReadings(DEVICE_KEY + "+T", 2)).Times(1);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
+      .WillOnce(Return(ByMove(std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}})));
+    EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(true));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
+}
+
+TEST_F(DataServiceTests, PublishReadingsOversizedMessageIsTrimmed)
+{
+    service->setBatchSizeController(BatchSizeController{4, 1, 4, 10});
+    EXPECT_CALL(*persistenceMock, getReadingsKeys).WillOnce(Return(std::vector<std::string>{DEVICE_KEY + "+T"}));
+    EXPECT_CALL(*persistenceMock, getReadings)
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{
+        std::make_shared<Reading>("T", "1", 1), std::make_shared<Reading>("T", "2", 2),
+        std::make_shared<Reading>("T", "3", 3), std::make_shared<Reading>("T", "4", 4)}))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{}));
+    EXPECT_CALL(*persistenceMock, getReadings(DEVICE_KEY + "+T", 1))
+      .WillOnce(Return(std::vector<std::shared_ptr<Reading>>{std::make_shared<Reading>("T", "1", 1)}));
+    EXPECT_CALL(*persistenceMock, removeReadings(DEVICE_KEY + "+T", 2)).Times(1);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(A<const std::string&>(), A<FeedValuesMessage>()))
+      .Times(2)
+      .WillRepeatedly([](const std::string&, const FeedValuesMessage& message) {
+          auto count = std::size_t{0};
+          for (const auto& readings : message.getReadings())
+              count += readings.second.size();
+          return std::unique_ptr<wolkabout::Message>{new wolkabout::Message{std::string(count * 5, 'A'), ""}};
+      });
+    EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(true));
+    ASSERT_NO_FATAL_FAILURE(service->publishReadings());
+    EXPECT_EQ(service->m_batchSizeController.getBatchSize(), 2);
+}
+
 TEST_F(DataServiceTests, PublishAttributesNoAttributes)
 {
     EXPECT_CALL(*persistenceMock, getAttributes).WillOnce(Return(std::map<std::string, std::shared_ptr<Attribute>>()));
@@ -506,6 +999,51 @@ TEST_F(DataServiceTests, PublishAttributesForDeviceHappyFlow)
     ASSERT_NO_FATAL_FAILURE(service->publishAttributes(DEVICE_KEY));
 }
 
+TEST_F(DataServiceTests, PublishAttributesForDeviceUsesBuckets)
+{
+    EXPECT_CALL(*persistenceMock, getAttributes)
+      .WillOnce(Return(std::map<std::string, std::shared_ptr<Attribute>>{
+        {"OtherDevice+T", std::make_shared<Attribute>("T", DataType::STRING, "OtherValue")}}));
+    EXPECT_CALL(*persistenceMock, putAttribute).Times(1);
+    EXPECT_CALL(*persistenceMock, removeAttributes(DEVICE_KEY + "+T")).Times(1);
+    EXPECT_CALL(*persistenceMock, removeAttributes("OtherDevice+T")).Times(0);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(DEVICE_KEY, A<AttributeRegistrationMessage>()))
+      .WillOnce(Return(ByMove(std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}})));
+    EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(true));
+
+    // The persistence is only looked at once, every later call is served from the device bucket
+    ASSERT_NO_FATAL_FAILURE(service->addAttribute(DEVICE_KEY, Attribute{"T", DataType::STRING, "TestValue"}));
+    ASSERT_NO_FATAL_FAILURE(service->publishAttributes(DEVICE_KEY));
+    ASSERT_NO_FATAL_FAILURE(service->publishAttributes(DEVICE_KEY));
+    EXPECT_EQ(service->m_attributeBuckets.size(), 1);
+    EXPECT_EQ(service->m_attributeBuckets.count("OtherDevice"), 1);
+}
+
+TEST_F(DataServiceTests, PublishAttributesKeepsAttributesAddedMeanwhile)
+{
+    EXPECT_CALL(*persistenceMock, getAttributes)
+      .WillOnce(Return(std::map<std::string, std::shared_ptr<Attribute>>{
+        {DEVICE_KEY + "+T", std::make_shared<Attribute>("T", DataType::STRING, "OldValue")}}));
+    EXPECT_CALL(*persistenceMock, putAttribute).Times(2);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(DEVICE_KEY, A<AttributeRegistrationMessage>()))
+      .Times(2)
+      .WillRepeatedly([](const std::string&, const AttributeRegistrationMessage&) {
+          return std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}};
+      });
+    EXPECT_CALL(*connectivityServiceMock, publish).Times(2).WillRepeatedly(Return(false));
+
+    // A value added before the persistence is read is not replaced by the older one it holds
+    ASSERT_NO_FATAL_FAILURE(service->addAttribute(DEVICE_KEY, Attribute{"T", DataType::STRING, "NewValue"}));
+    ASSERT_NO_FATAL_FAILURE(service->publishAttributes());
+    ASSERT_EQ(service->m_attributeBuckets[DEVICE_KEY].size(), 1);
+    EXPECT_EQ(service->m_attributeBuckets[DEVICE_KEY][DEVICE_KEY + "+T"]->getValue(), "NewValue");
+
+    // And one added between two publishes is kept by the next one
+    ASSERT_NO_FATAL_FAILURE(service->addAttribute(DEVICE_KEY, Attribute{"U", DataType::STRING, "Value"}));
+    ASSERT_NO_FATAL_FAILURE(service->publishAttributes());
+    EXPECT_EQ(service->m_attributeBuckets[DEVICE_KEY].size(), 2);
+}
+
 TEST_F(DataServiceTests, PublishParametersNoAttributes)
 {
     EXPECT_CALL(*persistenceMock, getParameters).WillOnce(Return(std::map<std::string, Parameter>()));
@@ -582,6 +1120,64 @@ TEST_F(DataServiceTests, PublishParametersForDeviceHappyFlow)
     ASSERT_NO_FATAL_FAILURE(service->publishParameters(DEVICE_KEY));
 }
 
+TEST_F(DataServiceTests, PublishParametersForDeviceUsesBuckets)
+{
+    EXPECT_CALL(*persistenceMock, getParameters)
+      .WillOnce(Return(std::map<std::string, Parameter>{
+        {"OtherDevice+EXTERNAL_ID", Parameter{ParameterName::EXTERNAL_ID, "OtherExternalId"}}}));
+    EXPECT_CALL(*persistenceMock, putParameter).Times(1);
+    EXPECT_CALL(*persistenceMock, removeParameters(_)).Times(1);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(DEVICE_KEY, A<ParametersUpdateMessage>()))
+      .WillOnce(Return(ByMove(std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}})));
+    EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(true));
+
+    // The persistence is only looked at once, every later call is served from the device bucket
+    ASSERT_NO_FATAL_FAILURE(
+      service->updateParameter(DEVICE_KEY, Parameter{ParameterName::EXTERNAL_ID, "TestExternalId"}));
+    ASSERT_NO_FATAL_FAILURE(service->publishParameters(DEVICE_KEY));
+    ASSERT_NO_FATAL_FAILURE(service->publishParameters(DEVICE_KEY));
+    EXPECT_EQ(service->m_parameterBuckets.size(), 1);
+    EXPECT_EQ(service->m_parameterBuckets.count("OtherDevice"), 1);
+}
+
+TEST_F(DataServiceTests, UpdateParameterSkipsValuesThePlatformHas)
+{
+    EXPECT_CALL(*persistenceMock, getParameters).WillOnce(Return(std::map<std::string, Parameter>()));
+    EXPECT_CALL(*persistenceMock, putParameter).Times(2);
+    EXPECT_CALL(*persistenceMock, removeParameters(_)).Times(2);
+    EXPECT_CALL(*dataProtocolMock, makeOutboundMessage(DEVICE_KEY, A<ParametersUpdateMessage>()))
+      .WillOnce(Return(ByMove(std::unique_ptr<wolkabout::Message>{new wolkabout::Message{"", ""}})));
+    EXPECT_CALL(*connectivityServiceMock, publish).WillOnce(Return(true));
+
+    // Once published, the same value is not stored again
+    ASSERT_NO_FATAL_FAILURE(service->updateParameter(DEVICE_KEY, Parameter{ParameterName::FIRMWARE_VERSION, "1.0"}));
+    ASSERT_NO_FATAL_FAILURE(service->publishParameters(DEVICE_KEY));
+    ASSERT_NO_FATAL_FAILURE(service->updateParameter(DEVICE_KEY, Parameter{ParameterName::FIRMWARE_VERSION, "1.0"}));
+    EXPECT_TRUE(service->m_parameterBuckets.empty());
+
+    // And a change that is reverted before it is published is dropped
+    ASSERT_NO_FATAL_FAILURE(service->updateParameter(DEVICE_KEY, Parameter{ParameterName::FIRMWARE_VERSION, "2.0"}));
+    EXPECT_EQ(service->m_parameterBuckets.size(), 1);
+    ASSERT_NO_FATAL_FAILURE(service->updateParameter(DEVICE_KEY, Parameter{ParameterName::FIRMWARE_VERSION, "1.0"}));
+    EXPECT_TRUE(service->m_parameterBuckets.empty());
+}
+
+TEST_F(DataServiceTests, UpdateParameterSkipsValuesReceivedFromThePlatform)
+{
+    EXPECT_CALL(*dataProtocolMock, getDeviceKey).WillOnce(Return(DEVICE_KEY));
+    EXPECT_CALL(*dataProtocolMock, getMessageType).WillOnce(Return(MessageType::PARAMETER_SYNC));
+    EXPECT_CALL(*dataProtocolMock, parseParameters)
+      .WillOnce(Return(ByMove(std::unique_ptr<ParametersUpdateMessage>{
+        new ParametersUpdateMessage{std::vector<Parameter>{{ParameterName::EXTERNAL_ID, "TestExternalId"}}}})));
+    ASSERT_NO_FATAL_FAILURE(service->messageReceived(std::make_shared<wolkabout::Message>("", "")));
+
+    EXPECT_CALL(*persistenceMock, putParameter).Times(1);
+    ASSERT_NO_FATAL_FAILURE(
+      service->updateParameter(DEVICE_KEY, Parameter{ParameterName::EXTERNAL_ID, "TestExternalId"}));
+    ASSERT_NO_FATAL_FAILURE(
+      service->updateParameter("OtherDevice", Parameter{ParameterName::EXTERNAL_ID, "TestExternalId"}));
+}
+
 TEST_F(DataServiceTests, MessageReceivedMessageIsNull)
 {
     EXPECT_CALL(*dataProtocolMock, getDeviceKey).Times(0);
@@ -622,8 +1218,8 @@ TEST_F(DataServiceTests, MessageReceivedMessageFeedHappyFlow)
     std::atomic_bool callbackCalled{false};
     std::mutex mutex;
     std::condition_variable conditionVariable;
-    feedUpdateSetHandler = [&](const std::string&, const std::map<std::uint64_t, std::vector<Reading>>& readings) {
-        if (!readings.empty())
+    feedUpdateSetHandler = [&](const std::string&, SharedFeedValues readings) {
+        if (readings != nullptr && !readings->empty())
         {
             callbackCalled = true;
             conditionVariable.notify_one();
@@ -639,6 +1235,26 @@ TEST_F(DataServiceTests, MessageReceivedMessageFeedHappyFlow)
     EXPECT_TRUE(callbackCalled);
 }
 
+TEST_F(DataServiceTests, MessageReceivedMessageFeedIsNotCopied)
+{
+    auto parsedMessage = std::unique_ptr<FeedValuesMessage>{
+      new FeedValuesMessage{std::vector<Reading>{Reading{"T", std::uint64_t{123}, 1234567890}}}};
+    const auto* parsedReadings = &parsedMessage->getReadings();
+    EXPECT_CALL(*dataProtocolMock, getDeviceKey).WillOnce(Return(DEVICE_KEY));
+    EXPECT_CALL(*dataProtocolMock, getMessageType).WillOnce(Return(MessageType::FEED_VALUES));
+    EXPECT_CALL(*dataProtocolMock, parseFeedValues).WillOnce(Return(ByMove(std::move(parsedMessage))));
+
+    // The handler gets a view into the parsed message, that keeps it alive after the message is handled
+    auto received = SharedFeedValues{};
+    feedUpdateSetHandler = [&](const std::string&, SharedFeedValues readings) { received = std::move(readings); };
+
+    ASSERT_NO_FATAL_FAILURE(service->messageReceived(std::make_shared<wolkabout::Message>("", "")));
+    ASSERT_NE(received, nullptr);
+    EXPECT_EQ(received.get(), parsedReadings);
+    ASSERT_EQ(received->size(), 1);
+    EXPECT_EQ(received->begin()->second.front().getReference(), "T");
+}
+
 TEST_F(DataServiceTests, MessageReceivedMessageParameterFailedToParse)
 {
     EXPECT_CALL(*dataProtocolMock, getDeviceKey).WillOnce(Return(DEVICE_KEY));
@@ -688,15 +1304,14 @@ TEST_F(DataServiceTests, MessageReceivedMessageParameterHappyFlowAnswersSubscrip
     std::atomic_bool callbackCalled{false};
     std::mutex mutex;
     std::condition_variable conditionVariable;
-    service->m_parameterSubscriptions.emplace(
-      0,
-      DataService::ParameterSubscription{{ParameterName::EXTERNAL_ID}, [&](const std::vector<Parameter>& parameters) {
-                                             if (!parameters.empty())
-                                             {
-                                                 callbackCalled = true;
-                                                 conditionVariable.notify_one();
-                                             }
-                                         }});
+    service->addParameterSubscription(DEVICE_KEY, {ParameterName::EXTERNAL_ID},
+                                      [&](const std::vector<Parameter>& parameters) {
+                                          if (!parameters.empty())
+                                          {
+                                              callbackCalled = true;
+                                              conditionVariable.notify_one();
+                                          }
+                                      });
 
     ASSERT_NO_FATAL_FAILURE(service->messageReceived(std::make_shared<wolkabout::Message>("", "")));
     if (!callbackCalled)
@@ -726,7 +1341,7 @@ TEST_F(DataServiceTests, MessageReceivedMessageCallbackIsAwaiting)
       .WillOnce(Return(ByMove(
         std::unique_ptr<DetailsSynchronizationResponseMessage>{new DetailsSynchronizationResponseMessage{{}, {}}})));
 
-    service->m_detailsCallbacks.push([&](const std::vector<std::string>&, const std::vector<std::string>&) {
+    service->addDetailsCallback(DEVICE_KEY, [&](const std::vector<std::string>&, const std::vector<std::string>&) {
         callbackCalled = true;
         conditionVariable.notify_one();
     });
@@ -0,0 +1,87 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <sstream>
+
+#define private public
+#define protected public
+#include "wolk/service/data/FeedAggregation.h"
+#undef private
+#undef protected
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout;
+using namespace wolkabout::connect;
+
+TEST(FeedAggregationTests, WindowIsClosedByLaterReading)
+{
+    const auto statistics = std::vector<AggregationStatistic>{AggregationStatistic::Min, AggregationStatistic::Max,
+                                                              AggregationStatistic::Average, AggregationStatistic::Count};
+    auto window = AggregationWindow{FeedAggregation{std::chrono::milliseconds{1000}, statistics}};
+    auto closed = std::vector<Reading>{};
+
+    EXPECT_TRUE(window.add(Reading{"T", std::string{"2"}, 1000}, 0, closed));
+    EXPECT_TRUE(window.add(Reading{"T", std::string{"4"}, 1500}, 0, closed));
+    EXPECT_TRUE(window.add(Reading{"T", std::string{"9"}, 1999}, 0, closed));
+    EXPECT_TRUE(closed.empty());
+
+    EXPECT_TRUE(window.add(Reading{"T", std::string{"1"}, 2000}, 0, closed));
+    ASSERT_EQ(closed.size(), 1);
+    EXPECT_EQ(closed.front().getReference(), "T");
+    EXPECT_EQ(closed.front().getTimestamp(), 1000);
+    ASSERT_TRUE(closed.front().isMulti());
+    EXPECT_EQ(closed.front().getStringValues(), (std::vector<std::string>{"2", "9", "5", "3"}));
+}
+
+TEST(FeedAggregationTests, SingleStatisticIsSingleValue)
+{
+    auto window = AggregationWindow{FeedAggregation{std::chrono::milliseconds{100}, {AggregationStatistic::Average}}};
+    auto closed = std::vector<Reading>{};
+
+    EXPECT_TRUE(window.add(Reading{"T", std::string{"1.5"}, 250}, 0, closed));
+    EXPECT_TRUE(window.add(Reading{"T", std::string{"2.5"}, 260}, 0, closed));
+
+    // The window is not over yet
+    EXPECT_FALSE(window.close(299, closed));
+    EXPECT_TRUE(window.close(300, closed));
+    ASSERT_EQ(closed.size(), 1);
+    EXPECT_FALSE(closed.front().isMulti());
+    EXPECT_EQ(closed.front().getStringValue(), "2");
+    EXPECT_EQ(closed.front().getTimestamp(), 200);
+
+    // An empty window is not closed
+    EXPECT_FALSE(window.close(1000, closed, true));
+}
+
+TEST(FeedAggregationTests, NonNumericReadingsAreNotAggregated)
+{
+    auto window = AggregationWindow{FeedAggregation{std::chrono::milliseconds{100}, {AggregationStatistic::Count}}};
+    auto closed = std::vector<Reading>{};
+
+    EXPECT_FALSE(window.add(Reading{"T", std::string{"ON"}, 100}, 0, closed));
+    EXPECT_FALSE(window.add(Reading{"T", std::vector<std::string>{"1", "2"}, 100}, 0, closed));
+    EXPECT_TRUE(closed.empty());
+}
+
+TEST(FeedAggregationTests, DisabledAggregation)
+{
+    EXPECT_TRUE(FeedAggregation{}.isDisabled());
+    EXPECT_TRUE((FeedAggregation{std::chrono::milliseconds{100}, {}}.isDisabled()));
+    EXPECT_FALSE((FeedAggregation{std::chrono::milliseconds{100}, {AggregationStatistic::Max}}.isDisabled()));
+}
@@ -0,0 +1,97 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <sstream>
+
+#define private public
+#define protected public
+#include "wolk/service/data/FeedFilter.h"
+#undef private
+#undef protected
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout;
+using namespace wolkabout::connect;
+
+TEST(FeedFilterTests, NoRulesAcceptsEverything)
+{
+    auto state = FeedFilterState{FeedFilter{}};
+    EXPECT_TRUE(FeedFilter{}.isDisabled());
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"1"}, 1}, 0));
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"1"}, 1}, 0));
+}
+
+TEST(FeedFilterTests, AbsoluteDeadband)
+{
+    auto filter = FeedFilter{};
+    filter.absoluteDeadband = 0.5;
+    auto state = FeedFilterState{filter};
+
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"20.0"}, 1}, 0));
+    EXPECT_FALSE(state.accept(Reading{"T", std::string{"20.4"}, 2}, 0));
+    EXPECT_FALSE(state.accept(Reading{"T", std::string{"19.6"}, 3}, 0));
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"20.5"}, 4}, 0));
+    // The deadband is measured from the last stored reading
+    EXPECT_FALSE(state.accept(Reading{"T", std::string{"20.9"}, 5}, 0));
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"21.0"}, 6}, 0));
+}
+
+TEST(FeedFilterTests, PercentDeadband)
+{
+    auto filter = FeedFilter{};
+    filter.percentDeadband = 10.0;
+    auto state = FeedFilterState{filter};
+
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"100"}, 1}, 0));
+    EXPECT_FALSE(state.accept(Reading{"T", std::string{"109"}, 2}, 0));
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"89"}, 3}, 0));
+}
+
+TEST(FeedFilterTests, MinimumInterval)
+{
+    auto filter = FeedFilter{};
+    filter.minimumInterval = std::chrono::milliseconds{1000};
+    auto state = FeedFilterState{filter};
+
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"1"}, 1000}, 0));
+    EXPECT_FALSE(state.accept(Reading{"T", std::string{"2"}, 1500}, 0));
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"3"}, 2000}, 0));
+    // Readings without a timestamp use the given time
+    EXPECT_FALSE(state.accept(Reading{"T", std::string{"4"}, 0}, 2999));
+    EXPECT_TRUE(state.accept(Reading{"T", std::string{"4"}, 0}, 3000));
+}
+
+TEST(FeedFilterTests, ReportOnChangeWithHeartbeat)
+{
+    auto filter = FeedFilter{};
+    filter.reportOnChange = true;
+    filter.heartbeat = std::chrono::milliseconds{10000};
+    auto state = FeedFilterState{filter};
+
+    EXPECT_TRUE(state.accept(Reading{"SW", std::string{"false"}, 1000}, 0));
+    EXPECT_FALSE(state.accept(Reading{"SW", std::string{"false"}, 2000}, 0));
+    EXPECT_TRUE(state.accept(Reading{"SW", std::string{"true"}, 3000}, 0));
+    EXPECT_FALSE(state.accept(Reading{"SW", std::string{"true"}, 12999}, 0));
+    EXPECT_TRUE(state.accept(Reading{"SW", std::string{"true"}, 13000}, 0));
+
+    // Multi-value readings are compared value by value
+    EXPECT_TRUE(state.accept(Reading{"SW", std::vector<std::string>{"1", "2"}, 14000}, 0));
+    EXPECT_FALSE(state.accept(Reading{"SW", std::vector<std::string>{"1", "2"}, 15000}, 0));
+    EXPECT_TRUE(state.accept(Reading{"SW", std::vector<std::string>{"1", "3"}, 16000}, 0));
+}
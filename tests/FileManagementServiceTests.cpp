@@ -46,8 +46,7 @@ class FileManagementServiceTests : public ::testing::Test
 public:
     void SetUp() override
     {
-        _internalFeedUpdateSetHandler = [&](std::string deviceKey,
-                                            std::map<std::uint64_t, std::vector<Reading>> readings) {
+        _internalFeedUpdateSetHandler = [&](std::string deviceKey, SharedFeedValues readings) {
             if (feedUpdateSetHandler)
                 feedUpdateSetHandler(std::move(deviceKey), std::move(readings));
         };
@@ -0,0 +1,267 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <sstream>
+#include <thread>
+
+#define private public
+#define protected public
+#include "wolk/persistence/FilePersistence.h"
+#undef private
+#undef protected
+
+#include <gtest/gtest.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace ::testing;
+using namespace wolkabout;
+using namespace wolkabout::connect;
+
+class FilePersistenceTests : public ::testing::Test
+{
+public:
+    void SetUp() override { removeDirectory(); }
+
+    void TearDown() override { removeDirectory(); }
+
+    static void removeDirectory()
+    {
+        auto directory = ::opendir(DIRECTORY.c_str());
+        if (directory == nullptr)
+            return;
+        while (const auto entry = ::readdir(directory))
+        {
+            const auto name = std::string{entry->d_name};
+            if (name != "." && name != "..")
+                ::unlink((DIRECTORY + "/" + name).c_str());
+        }
+        ::closedir(directory);
+        ::rmdir(DIRECTORY.c_str());
+    }
+
+    static std::unique_ptr<FilePersistence> open(std::uint64_t segmentSize = FilePersistence::DEFAULT_SEGMENT_SIZE)
+    {
+        return std::unique_ptr<FilePersistence>{new FilePersistence{DIRECTORY, segmentSize, 1}};
+    }
+
+    static const std::string DIRECTORY;
+};
+
+const std::string FilePersistenceTests::DIRECTORY = "./file_persistence_tests";
+
+TEST_F(FilePersistenceTests, ReadingsRoundTrip)
+{
+    auto persistence = open();
+    ASSERT_TRUE(persistence->isOpen());
+    EXPECT_TRUE(persistence->isEmpty());
+
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"1"}, 100}));
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"2"}, 200}));
+    ASSERT_TRUE(persistence->putReading("D+V", Reading{"V", std::vector<std::string>{"1", "2", "3"}, 300}));
+    EXPECT_FALSE(persistence->isEmpty());
+    EXPECT_EQ(persistence->getReadingsKeys(), (std::vector<std::string>{"D+T", "D+V"}));
+
+    const auto readings = persistence->getReadings("D+T", 5);
+    ASSERT_EQ(readings.size(), 2);
+    EXPECT_EQ(readings[0]->getStringValue(), "1");
+    EXPECT_EQ(readings[0]->getTimestamp(), 100);
+    EXPECT_EQ(readings[1]->getStringValue(), "2");
+
+    const auto multi = persistence->getReadings("D+V", 1);
+    ASSERT_EQ(multi.size(), 1);
+    EXPECT_TRUE(multi.front()->isMulti());
+    EXPECT_EQ(multi.front()->getStringValues(), (std::vector<std::string>{"1", "2", "3"}));
+
+    persistence->removeReadings("D+T", 1);
+    ASSERT_EQ(persistence->getReadings("D+T", 5).size(), 1);
+    EXPECT_EQ(persistence->getReadings("D+T", 5).front()->getStringValue(), "2");
+    persistence->removeReadings("D+T", 5);
+    EXPECT_EQ(persistence->getReadingsKeys(), std::vector<std::string>{"D+V"});
+}
+
+TEST_F(FilePersistenceTests, ReadingsSurviveRestart)
+{
+    {
+        auto persistence = open();
+        for (auto i = 0; i < 10; ++i)
+            ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::to_string(i), std::uint64_t(i)}));
+        persistence->removeReadings("D+T", 4);
+    }
+
+    auto persistence = open();
+    const auto readings = persistence->getReadings("D+T", 100);
+    ASSERT_EQ(readings.size(), 6);
+    EXPECT_EQ(readings.front()->getStringValue(), "4");
+    EXPECT_EQ(readings.back()->getStringValue(), "9");
+
+    // New readings continue after the ones that were recovered
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"10"}, 10}));
+    EXPECT_EQ(persistence->getReadings("D+T", 100).back()->getStringValue(), "10");
+}
+
+TEST_F(FilePersistenceTests, SequenceContinuesAfterDrainedSegmentsAreDeleted)
+{
+    {
+        auto persistence = open();
+        for (auto i = 0; i < 10; ++i)
+            ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::to_string(i), std::uint64_t(i)}));
+        persistence->removeReadings("D+T", 10);
+    }
+
+    // Simulate a power cut right after the log was rotated, so the drained segment is deleted on the next open
+    const auto fd = ::open((DIRECTORY + "/segment-1.log").c_str(), O_WRONLY | O_CREAT, 0644);
+    ASSERT_GE(fd, 0);
+    ::close(fd);
+    open();
+
+    {
+        auto persistence = open();
+        ASSERT_EQ(persistence->getSegmentCount(), 1);
+        ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"10"}, 10}));
+    }
+
+    auto persistence = open();
+    const auto readings = persistence->getReadings("D+T", 100);
+    ASSERT_EQ(readings.size(), 1);
+    EXPECT_EQ(readings.front()->getStringValue(), "10");
+}
+
+TEST_F(FilePersistenceTests, TornWriteIsDiscarded)
+{
+    {
+        auto persistence = open();
+        ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"1"}, 1}));
+        ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"2"}, 2}));
+    }
+
+    // Simulate a power cut in the middle of writing a frame
+    const auto fd = ::open((DIRECTORY + "/segment-0.log").c_str(), O_WRONLY | O_APPEND);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::write(fd, "\x20\x00\x00\x00\x01", 5), 5);
+    ::close(fd);
+
+    auto persistence = open();
+    EXPECT_EQ(persistence->getReadings("D+T", 100).size(), 2);
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"3"}, 3}));
+    EXPECT_EQ(persistence->getReadings("D+T", 100).back()->getStringValue(), "3");
+}
+
+TEST_F(FilePersistenceTests, ConsumedSegmentsAreDeleted)
+{
+    auto persistence = open(256);
+    for (auto i = 0; i < 50; ++i)
+        ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::to_string(i), std::uint64_t(i)}));
+    const auto segments = persistence->getSegmentCount();
+    ASSERT_GT(segments, 2);
+
+    persistence->removeReadings("D+T", 40);
+    EXPECT_LT(persistence->getSegmentCount(), segments);
+    const auto readings = persistence->getReadings("D+T", 100);
+    ASSERT_EQ(readings.size(), 10);
+    EXPECT_EQ(readings.front()->getStringValue(), "40");
+}
+
+TEST_F(FilePersistenceTests, SparseSegmentsAreCompacted)
+{
+    {
+        auto persistence = open(512);
+        // One slow feed keeps a reading in every segment of a fast feed
+        for (auto i = 0; i < 40; ++i)
+        {
+            ASSERT_TRUE(persistence->putReading("D+S", Reading{"S", std::to_string(i), std::uint64_t(i)}));
+            for (auto j = 0; j < 8; ++j)
+                ASSERT_TRUE(persistence->putReading("D+F", Reading{"F", std::to_string(j), std::uint64_t(i)}));
+        }
+        const auto segments = persistence->getSegmentCount();
+        persistence->removeReadings("D+F", 1000);
+        EXPECT_LT(persistence->getSegmentCount(), segments);
+        ASSERT_EQ(persistence->getReadings("D+S", 100).size(), 40);
+    }
+
+    auto persistence = open(512);
+    const auto readings = persistence->getReadings("D+S", 100);
+    ASSERT_EQ(readings.size(), 40);
+    for (auto i = 0; i < 40; ++i)
+        EXPECT_EQ(readings[static_cast<std::size_t>(i)]->getStringValue(), std::to_string(i));
+    EXPECT_TRUE(persistence->getReadings("D+F", 100).empty());
+}
+
+TEST_F(FilePersistenceTests, PutReadingsWritesBatches)
+{
+    {
+        auto persistence = open(512);
+        auto readings = std::vector<Reading>{};
+        for (auto i = 0; i < 100; ++i)
+            readings.emplace_back("T", std::to_string(i), std::uint64_t(i));
+        ASSERT_TRUE(persistence->putReadings("D+T", std::move(readings)));
+        EXPECT_GT(persistence->getSegmentCount(), 2);
+        ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"100"}, 100}));
+        EXPECT_TRUE(persistence->putReadings("D+T", std::vector<Reading>{}));
+    }
+
+    auto persistence = open(512);
+    const auto readings = persistence->getReadings("D+T", 1000);
+    ASSERT_EQ(readings.size(), 101);
+    for (auto i = 0; i < 101; ++i)
+        EXPECT_EQ(readings[static_cast<std::size_t>(i)]->getStringValue(), std::to_string(i));
+}
+
+TEST_F(FilePersistenceTests, WaitingRecordsAreSyncedWithoutFurtherWrites)
+{
+    auto persistence = std::unique_ptr<FilePersistence>{new FilePersistence{
+      DIRECTORY, FilePersistence::DEFAULT_SEGMENT_SIZE, 1000, std::chrono::milliseconds{20}}};
+    persistence->sync();
+    ASSERT_TRUE(persistence->putReading("D+T", Reading{"T", std::string{"1"}, 1}));
+
+    const auto unsynced = [&] {
+        std::lock_guard<std::mutex> lock{persistence->m_mutex};
+        return persistence->m_unsyncedRecords;
+    };
+    EXPECT_EQ(unsynced(), 1);
+    for (auto i = 0; i < 200 && unsynced() > 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    EXPECT_EQ(unsynced(), 0);
+}
+
+TEST_F(FilePersistenceTests, AttributesAndParametersSurviveRestart)
+{
+    {
+        auto persistence = open();
+        ASSERT_TRUE(persistence->putAttribute("D+A", std::make_shared<Attribute>("A", DataType::NUMERIC, "1")));
+        ASSERT_TRUE(persistence->putAttribute("D+B", std::make_shared<Attribute>("B", DataType::STRING, "2")));
+        ASSERT_TRUE(persistence->putParameter("D+EXTERNAL_ID", Parameter{ParameterName::EXTERNAL_ID, "E"}));
+        persistence->removeAttributes("D+B");
+    }
+
+    auto persistence = open();
+    EXPECT_EQ(persistence->getAttributeKeys(), std::vector<std::string>{"D+A"});
+    ASSERT_NE(persistence->getAttributeUnderKey("D+A"), nullptr);
+    EXPECT_EQ(persistence->getAttributeUnderKey("D+A")->getDataType(), DataType::NUMERIC);
+    EXPECT_EQ(persistence->getAttributeUnderKey("D+A")->getValue(), "1");
+    EXPECT_EQ(persistence->getParameterForKey("D+EXTERNAL_ID").second, "E");
+
+    // A snapshot keeps the same state
+    ASSERT_TRUE(persistence->rewriteState());
+    persistence->removeParameters();
+    persistence.reset();
+    persistence = open();
+    EXPECT_EQ(persistence->getAttributes().size(), 1);
+    EXPECT_TRUE(persistence->getParameters().empty());
+}
@@ -51,7 +51,7 @@ public:
 
     const std::string FILE_NAME = "test.file";
 
-    CommandBuffer commandBuffer;
+    SerialExecutor commandBuffer;
 
     std::mutex mutex;
 
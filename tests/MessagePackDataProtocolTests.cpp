@@ -0,0 +1,108 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/model/Message.h"
+#include "wolk/protocol/MessagePack.h"
+#include "wolk/protocol/MessagePackDataProtocol.h"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout;
+using namespace wolkabout::connect;
+
+TEST(MessagePackDataProtocolTests, FeedValues)
+{
+    MessagePackDataProtocol protocol;
+    protocol.setFeedDataType("D", "T", DataType::NUMERIC);
+    protocol.setFeedDataType("D", "H", DataType::NUMERIC);
+    protocol.setFeedDataType("D", "L", DataType::NUMERIC);
+    protocol.setFeedDataType("D", "SW", DataType::BOOLEAN);
+    const auto message = protocol.makeOutboundMessage(
+      "D", FeedValuesMessage{{Reading{"T", "21.5", 1000}, Reading{"H", "40", 1000}, Reading{"SW", "true", 1000},
+                              Reading{"V", "1.10", 1000}, Reading{"L", std::vector<std::string>{"1", "text"}, 2000}}});
+    ASSERT_NE(message, nullptr);
+    EXPECT_EQ(message->getChannel(), WolkaboutDataProtocol{}
+                                       .makeOutboundMessage("D", FeedValuesMessage{{Reading{"T", "21.5", 1000}}})
+                                       ->getChannel());
+
+    auto value = MessagePackValue{};
+    ASSERT_TRUE(MessagePackReader::read(message->getContent(), value));
+    ASSERT_EQ(value.arrayValue.size(), 2);
+    const auto& first = value.arrayValue.front();
+    EXPECT_EQ(first.find("timestamp")->uintValue, 1000);
+    EXPECT_DOUBLE_EQ(first.find("T")->doubleValue, 21.5);
+    EXPECT_EQ(first.find("H")->uintValue, 40);
+    EXPECT_TRUE(first.find("SW")->boolValue);
+    // A feed that is not declared is written as a string, as it is
+    EXPECT_EQ(first.find("V")->stringValue, "1.10");
+    const auto& second = value.arrayValue.back();
+    EXPECT_EQ(second.find("timestamp")->uintValue, 2000);
+    ASSERT_EQ(second.find("L")->arrayValue.size(), 2);
+    EXPECT_EQ(second.find("L")->arrayValue.front().uintValue, 1);
+    EXPECT_EQ(second.find("L")->arrayValue.back().stringValue, "text");
+}
+
+TEST(MessagePackDataProtocolTests, Attributes)
+{
+    MessagePackDataProtocol protocol;
+    const auto message = protocol.makeOutboundMessage(
+      "D", AttributeRegistrationMessage{{Attribute{"Location", DataType::STRING, "Office"}}});
+    ASSERT_NE(message, nullptr);
+    EXPECT_EQ(message->getChannel(),
+              WolkaboutDataProtocol{}
+                .makeOutboundMessage("D", AttributeRegistrationMessage{{Attribute{"A", DataType::STRING, ""}}})
+                ->getChannel());
+
+    auto value = MessagePackValue{};
+    ASSERT_TRUE(MessagePackReader::read(message->getContent(), value));
+    ASSERT_EQ(value.arrayValue.size(), 1);
+    EXPECT_EQ(value.arrayValue.front().find("name")->stringValue, "Location");
+    EXPECT_EQ(value.arrayValue.front().find("dataType")->stringValue, toString(DataType::STRING));
+    EXPECT_EQ(value.arrayValue.front().find("value")->stringValue, "Office");
+}
+
+TEST(MessagePackDataProtocolTests, Parameters)
+{
+    MessagePackDataProtocol protocol;
+    const auto message = protocol.makeOutboundMessage(
+      "D", ParametersUpdateMessage{{Parameter{ParameterName::FIRMWARE_UPDATE_ENABLED, "true"},
+                                    Parameter{ParameterName::FIRMWARE_VERSION, "1.10"}}});
+    ASSERT_NE(message, nullptr);
+
+    auto value = MessagePackValue{};
+    ASSERT_TRUE(MessagePackReader::read(message->getContent(), value));
+    ASSERT_EQ(value.mapValue.size(), 2);
+    // The parameters are always written as strings, so a version like "1.10" is not turned into a number
+    EXPECT_EQ(value.find(toString(ParameterName::FIRMWARE_UPDATE_ENABLED))->stringValue, "true");
+    EXPECT_EQ(value.find(toString(ParameterName::FIRMWARE_VERSION))->stringValue, "1.10");
+}
+
+TEST(MessagePackDataProtocolTests, SmallerThanJson)
+{
+    auto readings = std::vector<Reading>{};
+    for (auto i = 0; i < 100; ++i)
+        readings.emplace_back("T", std::to_string(i), 1638537962000 + static_cast<std::uint64_t>(i));
+
+    MessagePackDataProtocol protocol;
+    protocol.setFeedDataType("D", "T", DataType::NUMERIC);
+    auto jsonProtocol = WolkaboutDataProtocol{};
+    const auto message = protocol.makeOutboundMessage("D", FeedValuesMessage{readings});
+    const auto json = jsonProtocol.makeOutboundMessage("D", FeedValuesMessage{readings});
+    ASSERT_NE(message, nullptr);
+    ASSERT_NE(json, nullptr);
+    EXPECT_LT(message->getContent().size(), json->getContent().size());
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/protocol/MessagePack.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+
+using namespace ::testing;
+using namespace wolkabout;
+using namespace wolkabout::connect;
+
+TEST(MessagePackTests, IntegersUseTheSmallestEncoding)
+{
+    auto writer = MessagePackWriter{};
+    writer.writeUInt(5);
+    EXPECT_EQ(writer.getBuffer().size(), 1);
+    writer.writeUInt(200);
+    EXPECT_EQ(writer.getBuffer().size(), 3);
+    writer.writeInt(-3);
+    EXPECT_EQ(writer.getBuffer().size(), 4);
+    writer.writeInt(-1000);
+    EXPECT_EQ(writer.getBuffer().size(), 7);
+    writer.writeUInt(1638537962000);
+    EXPECT_EQ(writer.getBuffer().size(), 16);
+}
+
+TEST(MessagePackTests, RoundTrip)
+{
+    auto writer = MessagePackWriter{};
+    writer.writeMapHeader(7);
+    writer.writeString("uint");
+    writer.writeUInt(std::numeric_limits<std::uint64_t>::max());
+    writer.writeString("int");
+    writer.writeInt(std::numeric_limits<std::int64_t>::min());
+    writer.writeString("double");
+    writer.writeDouble(-12.5);
+    writer.writeString("bool");
+    writer.writeBool(true);
+    writer.writeString("nil");
+    writer.writeNil();
+    writer.writeString("long");
+    writer.writeString(std::string(300, 'x'));
+    writer.writeString("array");
+    writer.writeArrayHeader(20);
+    for (auto i = 0; i < 20; ++i)
+        writer.writeInt(-i);
+
+    auto value = MessagePackValue{};
+    ASSERT_TRUE(MessagePackReader::read(writer.getBuffer(), value));
+    ASSERT_EQ(value.type, MessagePackValue::Type::Map);
+    ASSERT_EQ(value.mapValue.size(), 7);
+    EXPECT_EQ(value.find("uint")->uintValue, std::numeric_limits<std::uint64_t>::max());
+    EXPECT_EQ(value.find("int")->intValue, std::numeric_limits<std::int64_t>::min());
+    EXPECT_DOUBLE_EQ(value.find("double")->doubleValue, -12.5);
+    EXPECT_TRUE(value.find("bool")->boolValue);
+    EXPECT_EQ(value.find("nil")->type, MessagePackValue::Type::Nil);
+    EXPECT_EQ(value.find("long")->stringValue, std::string(300, 'x'));
+    ASSERT_EQ(value.find("array")->arrayValue.size(), 20);
+    EXPECT_EQ(value.find("array")->arrayValue[19].intValue, -19);
+    EXPECT_EQ(value.find("missing"), nullptr);
+}
+
+TEST(MessagePackTests, ValuesAreWrittenInTheirDeclaredType)
+{
+    const auto readValue = [](const std::string& text, DataType dataType) {
+        auto writer = MessagePackWriter{};
+        writer.writeValue(text, dataType);
+        auto value = MessagePackValue{};
+        EXPECT_TRUE(MessagePackReader::read(writer.getBuffer(), value));
+        return value;
+    };
+
+    EXPECT_EQ(readValue("42", DataType::NUMERIC).uintValue, 42);
+    EXPECT_EQ(readValue("-42", DataType::NUMERIC).intValue, -42);
+    EXPECT_DOUBLE_EQ(readValue("3.25", DataType::NUMERIC).doubleValue, 3.25);
+    EXPECT_TRUE(readValue("true", DataType::BOOLEAN).boolValue);
+    EXPECT_EQ(readValue("false", DataType::BOOLEAN).type, MessagePackValue::Type::Bool);
+
+    // Values that are not declared as numbers or booleans are kept as strings
+    EXPECT_EQ(readValue("42", DataType::STRING).stringValue, "42");
+    EXPECT_EQ(readValue("1.10", DataType::STRING).stringValue, "1.10");
+    EXPECT_EQ(readValue("1e3", DataType::STRING).stringValue, "1e3");
+    EXPECT_EQ(readValue("true", DataType::STRING).stringValue, "true");
+    EXPECT_EQ(readValue("1", DataType::BOOLEAN).stringValue, "1");
+
+    // Numbers that would not be written back the same way are kept as strings
+    EXPECT_EQ(readValue("007", DataType::NUMERIC).stringValue, "007");
+    EXPECT_EQ(readValue("99999999999999999999", DataType::NUMERIC).stringValue, "99999999999999999999");
+    EXPECT_EQ(readValue("nan", DataType::NUMERIC).stringValue, "nan");
+    EXPECT_EQ(readValue("1-2", DataType::NUMERIC).stringValue, "1-2");
+    EXPECT_EQ(readValue("", DataType::NUMERIC).stringValue, "");
+}
+
+TEST(MessagePackTests, InvalidData)
+{
+    auto writer = MessagePackWriter{};
+    writer.writeArrayHeader(2);
+    writer.writeString("value");
+    writer.writeUInt(1000);
+    const auto& buffer = writer.getBuffer();
+
+    auto value = MessagePackValue{};
+    EXPECT_FALSE(MessagePackReader::read("", value));
+    EXPECT_FALSE(MessagePackReader::read(buffer.substr(0, buffer.size() - 1), value));
+    EXPECT_FALSE(MessagePackReader::read(buffer + buffer, value));
+    EXPECT_FALSE(MessagePackReader::read(std::string(1, static_cast<char>(0xc1)), value));
+    EXPECT_FALSE(MessagePackReader::read(std::string(100, static_cast<char>(0x91)), value));
+}
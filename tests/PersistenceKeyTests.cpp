@@ -0,0 +1,114 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <sstream>
+
+#define private public
+#define protected public
+#include "wolk/service/data/PersistenceKey.h"
+#undef private
+#undef protected
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout::connect;
+
+TEST(PersistenceKeyTests, ComposeAndDecompose)
+{
+    EXPECT_EQ(PersistenceKeyRegistry::compose("D", "T"), "D+T");
+
+    auto deviceKey = std::string{};
+    auto reference = std::string{};
+    ASSERT_TRUE(PersistenceKeyRegistry::decompose("D+T", deviceKey, reference));
+    EXPECT_EQ(deviceKey, "D");
+    EXPECT_EQ(reference, "T");
+    EXPECT_FALSE(PersistenceKeyRegistry::decompose("DT", deviceKey, reference));
+}
+
+TEST(PersistenceKeyTests, MakePersistenceKey)
+{
+    EXPECT_EQ(PersistenceKeyRegistry::compose("DEVICE_KEY", "T"), "DEVICE_KEY+T");
+}
+
+TEST(PersistenceKeyTests, ParsePersistenceKeyInvalid)
+{
+    auto deviceKey = std::string{};
+    auto reference = std::string{};
+    ASSERT_NO_FATAL_FAILURE(EXPECT_FALSE(PersistenceKeyRegistry::decompose("AB", deviceKey, reference)));
+    EXPECT_TRUE(deviceKey.empty());
+    EXPECT_TRUE(reference.empty());
+}
+
+TEST(PersistenceKeyTests, ParsePersistenceKey)
+{
+    auto deviceKey = std::string{};
+    auto reference = std::string{};
+    ASSERT_NO_FATAL_FAILURE(EXPECT_TRUE(PersistenceKeyRegistry::decompose("A+B", deviceKey, reference)));
+    EXPECT_EQ(deviceKey, "A");
+    EXPECT_EQ(reference, "B");
+}
+
+TEST(PersistenceKeyTests, DelimiterInDeviceKeyDoesNotCollide)
+{
+    const auto first = PersistenceKeyRegistry::compose("A+B", "C");
+    const auto second = PersistenceKeyRegistry::compose("A", "B+C");
+    EXPECT_NE(first, second);
+
+    auto deviceKey = std::string{};
+    auto reference = std::string{};
+    ASSERT_TRUE(PersistenceKeyRegistry::decompose(first, deviceKey, reference));
+    EXPECT_EQ(deviceKey, "A+B");
+    EXPECT_EQ(reference, "C");
+    ASSERT_TRUE(PersistenceKeyRegistry::decompose(second, deviceKey, reference));
+    EXPECT_EQ(deviceKey, "A");
+    EXPECT_EQ(reference, "B+C");
+
+    ASSERT_TRUE(PersistenceKeyRegistry::decompose(PersistenceKeyRegistry::compose("A\\", "B"), deviceKey, reference));
+    EXPECT_EQ(deviceKey, "A\\");
+    EXPECT_EQ(reference, "B");
+}
+
+TEST(PersistenceKeyTests, InternReturnsTheSameKey)
+{
+    auto registry = PersistenceKeyRegistry{};
+    const auto& first = registry.intern("D", "T");
+    const auto& second = registry.intern("D", "T");
+    EXPECT_EQ(&first, &second);
+    EXPECT_EQ(first.getKey(), "D+T");
+    EXPECT_EQ(first.getDeviceKey(), "D");
+    EXPECT_EQ(first.getReference(), "T");
+
+    const auto& other = registry.intern("E", "T");
+    EXPECT_NE(other.getDeviceId(), first.getDeviceId());
+    EXPECT_EQ(other.getReferenceId(), first.getReferenceId());
+}
+
+TEST(PersistenceKeyTests, ResolveKnownAndForeignKeys)
+{
+    auto registry = PersistenceKeyRegistry{};
+    const auto& interned = registry.intern("D", "T");
+    EXPECT_EQ(registry.resolve("D+T"), &interned);
+
+    const auto foreign = registry.resolve("E+H");
+    ASSERT_NE(foreign, nullptr);
+    EXPECT_EQ(foreign->getDeviceKey(), "E");
+    EXPECT_EQ(foreign->getReference(), "H");
+    EXPECT_EQ(&registry.intern("E", "H"), foreign);
+
+    EXPECT_EQ(registry.resolve("Invalid"), nullptr);
+}
@@ -0,0 +1,122 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <sstream>
+
+#define private public
+#define protected public
+#include "wolk/service/data/PublishScheduler.h"
+#undef private
+#undef protected
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+using namespace ::testing;
+using namespace wolkabout::connect;
+
+namespace
+{
+bool waitFor(const std::atomic<int>& publishes, int expected,
+             std::chrono::milliseconds timeout = std::chrono::milliseconds{2000})
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (publishes < expected && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    return publishes >= expected;
+}
+}    // namespace
+
+TEST(PublishSchedulerTests, ReadingsThreshold)
+{
+    std::atomic<int> publishes{0};
+    PublishScheduler scheduler{PublishSchedule{10}, [&] { ++publishes; }};
+
+    scheduler.readingsAdded(9, 90);
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    EXPECT_EQ(publishes, 0);
+    EXPECT_EQ(scheduler.getPendingReadings(), 9);
+
+    scheduler.readingsAdded(1, 10);
+    ASSERT_TRUE(waitFor(publishes, 1));
+    EXPECT_EQ(scheduler.getPendingReadings(), 0);
+}
+
+TEST(PublishSchedulerTests, BytesThreshold)
+{
+    std::atomic<int> publishes{0};
+    PublishScheduler scheduler{PublishSchedule{0, 100}, [&] { ++publishes; }};
+
+    scheduler.readingsAdded(1, 60);
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    EXPECT_EQ(publishes, 0);
+
+    scheduler.readingsAdded(1, 60);
+    ASSERT_TRUE(waitFor(publishes, 1));
+}
+
+TEST(PublishSchedulerTests, LatencyDeadline)
+{
+    std::atomic<int> publishes{0};
+    PublishScheduler scheduler{PublishSchedule{1000, 0, std::chrono::milliseconds{50}}, [&] { ++publishes; }};
+
+    // Nothing is published while there are no readings
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    EXPECT_EQ(publishes, 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    scheduler.readingsAdded(1, 10);
+    ASSERT_TRUE(waitFor(publishes, 1));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{50});
+
+    // The deadline is counted from the first reading after the publish
+    scheduler.readingsAdded(1, 10);
+    ASSERT_TRUE(waitFor(publishes, 2));
+}
+
+TEST(PublishSchedulerTests, TickCanAddReadings)
+{
+    std::atomic<int> publishes{0};
+    std::atomic<int> ticks{0};
+    PublishScheduler scheduler{PublishSchedule{1}, [&] { ++publishes; }};
+
+    // Like a closed aggregation window, the first tick reports a reading, which is then published
+    scheduler.setTick(std::chrono::milliseconds{10}, [&] {
+        if (++ticks == 1)
+            scheduler.readingsAdded(1, 10);
+    });
+    ASSERT_TRUE(waitFor(publishes, 1));
+    ASSERT_TRUE(waitFor(ticks, 3));
+
+    scheduler.setTick(std::chrono::milliseconds{0}, nullptr);
+    const auto stoppedAt = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    EXPECT_LE(ticks, stoppedAt + 1);
+    EXPECT_EQ(publishes, 1);
+}
+
+TEST(PublishSchedulerTests, StoppedSchedulerDoesNotPublish)
+{
+    std::atomic<int> publishes{0};
+    PublishScheduler scheduler{PublishSchedule{1}, [&] { ++publishes; }};
+    scheduler.stop();
+
+    scheduler.readingsAdded(5, 50);
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    EXPECT_EQ(publishes, 0);
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <sstream>
+
+#define private public
+#define protected public
+#include "wolk/service/data/ReadingQueue.h"
+#undef private
+#undef protected
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace ::testing;
+using namespace wolkabout::connect;
+
+namespace
+{
+ReadingRecord makeRecord(const std::string& deviceKey, std::uint64_t rtc)
+{
+    auto record = ReadingRecord{};
+    record.deviceKey = deviceKey;
+    record.reference = "T";
+    record.value = ReadingValue{std::to_string(rtc)};
+    record.rtc = rtc;
+    return record;
+}
+}    // namespace
+
+TEST(ReadingQueueTests, CapacityIsRoundedUp)
+{
+    EXPECT_EQ(ReadingQueue{1}.getCapacity(), 2);
+    EXPECT_EQ(ReadingQueue{100}.getCapacity(), 128);
+    EXPECT_EQ(ReadingQueue{}.getCapacity(), ReadingQueue::DEFAULT_CAPACITY);
+}
+
+TEST(ReadingQueueTests, FirstInFirstOut)
+{
+    auto queue = ReadingQueue{4};
+    for (std::uint64_t i = 0; i < 4; ++i)
+    {
+        auto record = makeRecord("D", i);
+        ASSERT_TRUE(queue.push(record));
+        EXPECT_TRUE(record.value.toString().empty());
+    }
+    EXPECT_EQ(queue.size(), 4);
+
+    // The queue is full, so the record stays with the caller
+    auto overflow = makeRecord("D", 4);
+    EXPECT_FALSE(queue.push(overflow));
+    EXPECT_EQ(overflow.value.toString(), "4");
+
+    auto record = ReadingRecord{};
+    for (std::uint64_t i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(queue.pop(record));
+        EXPECT_EQ(record.rtc, i);
+        EXPECT_EQ(record.value.toString(), std::to_string(i));
+    }
+    EXPECT_FALSE(queue.pop(record));
+    EXPECT_EQ(queue.size(), 0);
+
+    // The slots are reused after the wrap around
+    ASSERT_TRUE(queue.push(overflow));
+    ASSERT_TRUE(queue.pop(record));
+    EXPECT_EQ(record.rtc, 4);
+}
+
+TEST(ReadingQueueTests, MultipleProducers)
+{
+    const auto producers = 4;
+    const auto perProducer = std::uint64_t{20000};
+    auto queue = ReadingQueue{256};
+
+    auto threads = std::vector<std::thread>{};
+    for (auto producer = 0; producer < producers; ++producer)
+    {
+        threads.emplace_back([&, producer] {
+            for (std::uint64_t i = 0; i < perProducer; ++i)
+            {
+                auto record = makeRecord(std::to_string(producer), i);
+                while (!queue.push(record))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // Every producer's records have to come out complete, and in the order they were pushed
+    auto next = std::vector<std::uint64_t>(producers, 0);
+    auto record = ReadingRecord{};
+    for (std::uint64_t received = 0; received < producers * perProducer;)
+    {
+        if (!queue.pop(record))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const auto producer = std::stoul(record.deviceKey);
+        ASSERT_EQ(record.rtc, next[producer]);
+        ASSERT_EQ(record.value.toString(), std::to_string(record.rtc));
+        ++next[producer];
+        ++received;
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_FALSE(queue.pop(record));
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <any>
+#include <sstream>
+
+#define private public
+#define protected public
+#include "wolk/service/data/ReadingValue.h"
+#undef private
+#undef protected
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout;
+using namespace wolkabout::connect;
+
+TEST(ReadingValueTests, NumericValuesKeepTheirType)
+{
+    EXPECT_EQ(ReadingValue::from(true).getType(), ReadingValue::Type::Bool);
+    EXPECT_EQ(ReadingValue::from(-3).getType(), ReadingValue::Type::Int);
+    EXPECT_EQ(ReadingValue::from(std::int64_t{-3}).getType(), ReadingValue::Type::Int);
+    EXPECT_EQ(ReadingValue::from(3u).getType(), ReadingValue::Type::UInt);
+    EXPECT_EQ(ReadingValue::from(std::uint64_t{3}).getType(), ReadingValue::Type::UInt);
+    EXPECT_EQ(ReadingValue::from(1.5f).getType(), ReadingValue::Type::Float);
+    EXPECT_EQ(ReadingValue::from(1.5).getType(), ReadingValue::Type::Double);
+}
+
+TEST(ReadingValueTests, OtherValuesAreStrings)
+{
+    EXPECT_EQ(ReadingValue::from("TestValue").getType(), ReadingValue::Type::String);
+    EXPECT_EQ(ReadingValue::from(std::string{"TestValue"}).getType(), ReadingValue::Type::String);
+    // Characters would be printed as numbers if they were held as integers
+    EXPECT_EQ(ReadingValue::from('c').getType(), ReadingValue::Type::String);
+    EXPECT_EQ(ReadingValue::from('c').toString(), StringUtils::toString('c'));
+}
+
+TEST(ReadingValueTests, ConversionMatchesStringUtils)
+{
+    EXPECT_EQ(ReadingValue::from(true).toString(), StringUtils::toString(true));
+    EXPECT_EQ(ReadingValue::from(-3).toString(), StringUtils::toString(-3));
+    EXPECT_EQ(ReadingValue::from(std::uint64_t{18446744073709551615ull}).toString(),
+              StringUtils::toString(std::uint64_t{18446744073709551615ull}));
+    EXPECT_EQ(ReadingValue::from(1.25f).toString(), StringUtils::toString(1.25f));
+    EXPECT_EQ(ReadingValue::from(2.5).toString(), StringUtils::toString(2.5));
+    EXPECT_EQ(ReadingValue::from("TestValue").toString(), "TestValue");
+}
+
+TEST(ReadingValueTests, TakeString)
+{
+    auto value = ReadingValue{std::string{"TestValue"}};
+    EXPECT_EQ(value.takeString(), "TestValue");
+
+    auto number = ReadingValue::from(42);
+    EXPECT_EQ(number.takeString(), "42");
+    EXPECT_EQ(number.toString(), "42");
+}
+
+TEST(ReadingValueTests, ParseNumber)
+{
+    auto number = 0.0;
+    EXPECT_TRUE(ReadingValue::parseNumber("12.5", number));
+    EXPECT_DOUBLE_EQ(number, 12.5);
+    EXPECT_TRUE(ReadingValue::parseNumber("-3", number));
+    EXPECT_DOUBLE_EQ(number, -3.0);
+
+    // Only a whole, finite number is accepted
+    EXPECT_FALSE(ReadingValue::parseNumber("", number));
+    EXPECT_FALSE(ReadingValue::parseNumber("12.5C", number));
+    EXPECT_FALSE(ReadingValue::parseNumber("true", number));
+    EXPECT_FALSE(ReadingValue::parseNumber("inf", number));
+    EXPECT_FALSE(ReadingValue::parseNumber("1e999", number));
+}
@@ -0,0 +1,57 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/ReconnectPolicy.h"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace wolkabout::connect;
+
+TEST(ReconnectPolicyTests, DelayGrowsUpToTheMaximum)
+{
+    auto backoff =
+      ReconnectBackoff{ReconnectPolicy{std::chrono::milliseconds{100}, std::chrono::milliseconds{1000}, 2.0, 0.0}};
+    EXPECT_EQ(backoff.nextDelay().count(), 100);
+    EXPECT_EQ(backoff.nextDelay().count(), 200);
+    EXPECT_EQ(backoff.nextDelay().count(), 400);
+    EXPECT_EQ(backoff.nextDelay().count(), 800);
+    EXPECT_EQ(backoff.nextDelay().count(), 1000);
+    EXPECT_EQ(backoff.nextDelay().count(), 1000);
+    EXPECT_EQ(backoff.getAttempts(), 6);
+
+    backoff.reset();
+    EXPECT_EQ(backoff.getAttempts(), 0);
+    EXPECT_EQ(backoff.nextDelay().count(), 100);
+}
+
+TEST(ReconnectPolicyTests, JitterSpreadsTheDelay)
+{
+    auto backoff =
+      ReconnectBackoff{ReconnectPolicy{std::chrono::milliseconds{1000}, std::chrono::milliseconds{1000}, 2.0, 0.5}};
+    auto minimum = std::chrono::milliseconds::max();
+    auto maximum = std::chrono::milliseconds::min();
+    for (auto i = 0; i < 1000; ++i)
+    {
+        const auto delay = backoff.nextDelay();
+        ASSERT_GE(delay.count(), 500);
+        ASSERT_LE(delay.count(), 1500);
+        minimum = std::min(minimum, delay);
+        maximum = std::max(maximum, delay);
+    }
+    EXPECT_LT(minimum.count(), 750);
+    EXPECT_GT(maximum.count(), 1250);
+}
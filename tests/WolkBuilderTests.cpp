@@ -176,6 +176,16 @@ TEST_F(WolkBuilderTests, FullMultiExample)
                  .parameterHandler(parameterHandlerMock)
                  .withPersistence(std::move(persistenceMock))
                  .withDataProtocol(std::move(dataProtocolMock))
+                 .withBoundedPersistence(EvictionPolicy::DropOldest, 10000)
+                 .withReadingQueueCapacity(1000)
+                 .withCommandQueueCapacity(10000, OverflowPolicy::DropOldest)
+                 .withReadingsPublishMode(ReadingsPublishMode::PerDevice, 100, 4096)
+                 .withPublishBudget(PublishBudget{10, 0, std::chrono::milliseconds{50}})
+                 .withPublishSchedule(PublishSchedule{500, 0, std::chrono::milliseconds{1000}})
+                 .withReconnectPolicy(ReconnectPolicy{std::chrono::milliseconds{500}})
+                 .withExecutorLanes(true, false)
+                 .withWorkerPoolSize(6)
+                 .withAdaptivePublishBatchSize(100, 10, 1000, 65536)
                  .withErrorProtocol(errorRetainTime, std::move(errorProtocolMock))
                  .withFileTransfer(fileDownloadLocation, maxPacketSize)
                  .withFileURLDownload(fileDownloadLocation, std::move(fileDownloaderMock), true, maxPacketSize)
@@ -191,4 +201,24 @@ TEST_F(WolkBuilderTests, FullMultiExample)
     ASSERT_NO_FATAL_FAILURE(wolk->m_connectivityService->m_onConnectionLost());
     ASSERT_NO_FATAL_FAILURE(wolk->m_dataService->m_feedUpdateHandler("", {}));
     ASSERT_NO_FATAL_FAILURE(wolk->m_dataService->m_parameterSyncHandler("", {}));
+    EXPECT_EQ(wolk->m_dataService->m_readingsPublishMode, ReadingsPublishMode::PerDevice);
+    EXPECT_EQ(wolk->m_dataService->m_readingsBudget, 100);
+    EXPECT_EQ(wolk->m_dataService->m_bytesBudget, 4096);
+    EXPECT_EQ(wolk->m_publishBudget.messages, 10);
+    EXPECT_EQ(wolk->m_publishBudget.time, std::chrono::milliseconds{50});
+    EXPECT_TRUE(wolk->m_dataService->m_batchSizeController.isAdaptive());
+    EXPECT_EQ(wolk->m_dataService->m_batchSizeController.getMaxPacketSize(), 65536);
+    EXPECT_NE(dynamic_cast<BoundedPersistence*>(wolk->m_persistence.get()), nullptr);
+    ASSERT_NE(wolk->m_readingQueue, nullptr);
+    EXPECT_EQ(wolk->m_readingQueue->getCapacity(), 1024);
+    ASSERT_NE(wolk->m_publishScheduler, nullptr);
+    EXPECT_EQ(wolk->m_publishScheduler->m_schedule.readings, 500);
+    EXPECT_TRUE(static_cast<bool>(wolk->m_dataService->m_readingsAddedListener));
+    EXPECT_NE(wolk->m_outboundCommandBuffer, wolk->m_commandBuffer);
+    EXPECT_EQ(wolk->m_callbackCommandBuffer, wolk->m_commandBuffer);
+    EXPECT_GE(WorkerPool::getDefault()->getSize(), 6);
+    EXPECT_EQ(wolk->m_commandBuffer->m_pool, WorkerPool::getDefault());
+    EXPECT_EQ(wolk->m_outboundCommandBuffer->m_pool, WorkerPool::getDefault());
+    EXPECT_EQ(wolk->m_commandBuffer->m_state->capacity, 10000);
+    EXPECT_EQ(wolk->m_commandBuffer->m_state->policy, OverflowPolicy::DropOldest);
 }
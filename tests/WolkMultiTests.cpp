@@ -225,8 +225,8 @@ TEST_F(WolkMultiTests, AddReadingMultipleReadings)
 {
     // Set up the DataService to be called
     std::atomic_bool called{false};
-    EXPECT_CALL(GetDataServiceReference(), addReadings(devices.front().getKey(), A<const std::vector<Reading>&>()))
-      .WillOnce([&](const std::string&, const std::vector<Reading>&) {
+    EXPECT_CALL(GetDataServiceReference(), addReadings(devices.front().getKey(), A<std::vector<Reading>&&>()))
+      .WillOnce([&](const std::string&, std::vector<Reading>&&) {
           called = true;
           Notify();
       });
@@ -638,6 +638,22 @@ TEST_F(WolkMultiTests, NotifyConnected)
     ASSERT_NO_FATAL_FAILURE(service->notifyConnected());
 }
 
+TEST_F(WolkMultiTests, PublishForDevice)
+{
+    std::atomic_bool called{false};
+    EXPECT_CALL(GetDataServiceReference(), publishAttributes(devices.front().getKey())).Times(1);
+    EXPECT_CALL(GetDataServiceReference(), publishReadings(devices.front().getKey())).Times(1);
+    EXPECT_CALL(GetDataServiceReference(), publishParameters(devices.front().getKey())).WillOnce([&](const std::string&) {
+        called = true;
+        Notify();
+    });
+    EXPECT_CALL(GetDataServiceReference(), publishReadings()).Times(0);
+    ASSERT_NO_FATAL_FAILURE(service->publish(devices.front().getKey()));
+    if (!called)
+        Await();
+    EXPECT_TRUE(called);
+}
+
 TEST_F(WolkMultiTests, AddDeviceAlreadyInList)
 {
     ASSERT_FALSE(service->addDevice(devices.front()));
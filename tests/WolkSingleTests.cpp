@@ -71,7 +71,11 @@ public:
           new RegistrationServiceMock{registrationProtocolMock, *service->m_connectivityService}};
     }
 
-    void TearDown() override { delete service->m_outboundMessageHandler; }
+    void TearDown() override
+    {
+        if (service != nullptr)
+            delete service->m_outboundMessageHandler;
+    }
 
     ConnectivityServiceMock& GetConnectivityServiceReference() const
     {
@@ -181,8 +185,8 @@ TEST_F(WolkSingleTests, AddReadingMultipleReadings)
 {
     // Set up the DataService to be called
     std::atomic_bool called{false};
-    EXPECT_CALL(GetDataServiceReference(), addReadings(device.getKey(), A<const std::vector<Reading>&>()))
-      .WillOnce([&](const std::string&, const std::vector<Reading>&) {
+    EXPECT_CALL(GetDataServiceReference(), addReadings(device.getKey(), A<std::vector<Reading>&&>()))
+      .WillOnce([&](const std::string&, std::vector<Reading>&&) {
           called = true;
           Notify();
       });
@@ -211,6 +215,29 @@ TEST_F(WolkSingleTests, AddFeed)
     EXPECT_TRUE(called);
 }
 
+TEST_F(WolkSingleTests, AddFeedWithFilter)
+{
+    // Set up the DataService to be called
+    std::atomic_bool called{false};
+    EXPECT_CALL(GetDataServiceReference(), setFeedFilter(device.getKey(), "TF", _))
+      .WillOnce([&](const std::string&, const std::string&, const FeedFilter& filter) {
+          EXPECT_TRUE(filter.reportOnChange);
+      });
+    EXPECT_CALL(GetDataServiceReference(), registerFeed(device.getKey(), _))
+      .WillOnce([&](const std::string&, const Feed&) {
+          called = true;
+          Notify();
+      });
+
+    // Call the service
+    auto filter = FeedFilter{};
+    filter.reportOnChange = true;
+    ASSERT_NO_FATAL_FAILURE(service->registerFeed(Feed{"TestFeed", "TF", FeedType::IN_OUT, "NUMERIC"}, filter));
+    if (!called)
+        Await();
+    EXPECT_TRUE(called);
+}
+
 TEST_F(WolkSingleTests, AddFeeds)
 {
     // Set up the DataService to be called
@@ -430,6 +457,72 @@ TEST_F(WolkSingleTests, ConnectionToggles)
     EXPECT_FALSE(service->isConnected());
 }
 
+TEST_F(WolkSingleTests, ConnectRetriesWithBackoff)
+{
+    service->m_reconnectBackoff =
+      ReconnectBackoff{ReconnectPolicy{std::chrono::milliseconds{5}, std::chrono::milliseconds{20}, 2.0, 0.0}};
+    std::atomic_bool called{false};
+    ASSERT_NO_FATAL_FAILURE(service->setConnectionStatusListener([&](bool status) {
+        called = status;
+        Notify();
+    }));
+    EXPECT_CALL(GetConnectivityServiceReference(), connect)
+      .WillOnce(Return(false))
+      .WillOnce(Return(false))
+      .WillOnce(Return(true));
+    ASSERT_NO_FATAL_FAILURE(service->connect());
+    if (!called)
+        Await(std::chrono::milliseconds{1000});
+    EXPECT_TRUE(called);
+    EXPECT_TRUE(service->isConnected());
+    EXPECT_EQ(service->m_reconnectBackoff.getAttempts(), 0);
+}
+
+TEST_F(WolkSingleTests, DisconnectStopsReconnecting)
+{
+    service->m_reconnectBackoff =
+      ReconnectBackoff{ReconnectPolicy{std::chrono::milliseconds{5}, std::chrono::milliseconds{5}, 1.0, 0.0}};
+    std::atomic<int> attempts{0};
+    EXPECT_CALL(GetConnectivityServiceReference(), connect).WillRepeatedly([&] {
+        if (++attempts == 3)
+            Notify();
+        return false;
+    });
+    ASSERT_NO_FATAL_FAILURE(service->connect());
+    if (attempts < 3)
+        Await(std::chrono::milliseconds{1000});
+    ASSERT_GE(attempts, 3);
+
+    ASSERT_NO_FATAL_FAILURE(service->disconnect());
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    const auto attemptsAfterDisconnect = attempts.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    EXPECT_EQ(attempts, attemptsAfterDisconnect);
+    EXPECT_FALSE(service->isConnected());
+}
+
+TEST_F(WolkSingleTests, DestroyedWhileConnectAttemptFails)
+{
+    service->m_reconnectBackoff =
+      ReconnectBackoff{ReconnectPolicy{std::chrono::milliseconds{5}, std::chrono::milliseconds{5}, 1.0, 0.0}};
+    std::atomic_bool attempting{false};
+    EXPECT_CALL(GetConnectivityServiceReference(), connect).WillRepeatedly([&] {
+        attempting = true;
+        Notify();
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        return false;
+    });
+    ASSERT_NO_FATAL_FAILURE(service->connect());
+    if (!attempting)
+        Await(std::chrono::milliseconds{1000});
+    ASSERT_TRUE(attempting);
+
+    // The failed attempt finishes while the object is being destroyed, and schedules another one
+    auto outboundMessageHandler = std::unique_ptr<OutboundMessageHandler>{service->m_outboundMessageHandler};
+    ASSERT_NO_FATAL_FAILURE(service.reset());
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+}
+
 TEST_F(WolkSingleTests, FeedUpdateHandlerLambda)
 {
     std::atomic_bool called{false};
@@ -439,7 +532,8 @@ TEST_F(WolkSingleTests, FeedUpdateHandlerLambda)
         Notify();
     };
 
-    ASSERT_NO_FATAL_FAILURE(service->handleFeedUpdateCommand("", {}));
+    ASSERT_NO_FATAL_FAILURE(
+      service->handleFeedUpdateCommand("", std::make_shared<std::map<std::uint64_t, std::vector<Reading>>>()));
     if (!called)
         Await();
     EXPECT_TRUE(called);
@@ -459,3 +553,163 @@ TEST_F(WolkSingleTests, ParameterUpdateHandlerLambda)
         Await();
     EXPECT_TRUE(called);
 }
+
+TEST_F(WolkSingleTests, SlowFeedUpdateHandlerDoesNotHoldUpReadings)
+{
+    // Make the handler hold its command buffer until the reading gets through
+    std::atomic_bool handlerStarted{false};
+    std::atomic_bool readingAdded{false};
+    std::atomic_bool handlerReleased{false};
+    service->m_feedUpdateHandler.reset();
+    service->m_feedUpdateHandlerLambda = [&](const std::string&, const std::map<std::uint64_t, std::vector<Reading>>&) {
+        std::unique_lock<std::mutex> lock{mutex};
+        handlerStarted = true;
+        conditionVariable.notify_all();
+        conditionVariable.wait_for(lock, std::chrono::milliseconds{1000}, [&] { return readingAdded.load(); });
+        handlerReleased = readingAdded.load();
+    };
+    EXPECT_CALL(GetDataServiceReference(), addReading(device.getKey(), A<const Reading&>()))
+      .WillOnce([&](const std::string&, const Reading&) {
+          std::lock_guard<std::mutex> lock{mutex};
+          readingAdded = true;
+          conditionVariable.notify_all();
+      });
+
+    ASSERT_NO_FATAL_FAILURE(
+      service->handleFeedUpdateCommand("", std::make_shared<std::map<std::uint64_t, std::vector<Reading>>>()));
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        ASSERT_TRUE(
+          conditionVariable.wait_for(lock, std::chrono::milliseconds{1000}, [&] { return handlerStarted.load(); }));
+    }
+    ASSERT_NO_FATAL_FAILURE(service->addReading(Reading{"T", std::string{"TestValue"}}));
+
+    // Destroying the callback command buffer waits for the handler to return
+    service->m_callbackCommandBuffer.reset();
+    EXPECT_TRUE(readingAdded);
+    EXPECT_TRUE(handlerReleased);
+}
+
+TEST_F(WolkSingleTests, PublishFollowsTheAddedReadings)
+{
+    // The publish goes through another command buffer, but must still see the reading added before it
+    std::atomic_bool readingAdded{false};
+    std::atomic_bool publishedAfterReading{false};
+    EXPECT_CALL(GetDataServiceReference(), addReading(device.getKey(), A<const Reading&>()))
+      .WillOnce([&](const std::string&, const Reading&) {
+          std::this_thread::sleep_for(std::chrono::milliseconds{20});
+          readingAdded = true;
+      });
+    EXPECT_CALL(GetDataServiceReference(), publishReadings()).WillOnce([&] {
+        publishedAfterReading = readingAdded.load();
+        Notify();
+    });
+
+    ASSERT_NO_FATAL_FAILURE(service->addReading(Reading{"T", std::string{"TestValue"}}));
+    ASSERT_NO_FATAL_FAILURE(service->publish());
+    if (!publishedAfterReading)
+        Await(std::chrono::milliseconds{1000});
+    EXPECT_TRUE(publishedAfterReading);
+}
+
+TEST_F(WolkSingleTests, PublishFutureReportsTheResult)
+{
+    // The first slice leaves a backlog, and the second one drains it
+    service->m_connected = true;
+    auto first = PublishSliceResult{};
+    first.sentMessages = 1;
+    first.sentReadings = 3;
+    first.backlogRemaining = true;
+    auto second = PublishSliceResult{};
+    second.sentMessages = 1;
+    second.sentReadings = 2;
+    second.failedMessages = 1;
+    EXPECT_CALL(GetDataServiceReference(), publishAttributes()).Times(1);
+    EXPECT_CALL(GetDataServiceReference(), publishReadingsSlice).WillOnce(Return(first)).WillOnce(Return(second));
+    EXPECT_CALL(GetDataServiceReference(), publishParameters()).Times(1);
+
+    auto future = service->publishFuture();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds{1}), std::future_status::ready);
+    const auto result = future.get();
+    EXPECT_EQ(result.sentMessages, 2);
+    EXPECT_EQ(result.sentReadings, 5);
+    EXPECT_EQ(result.failedMessages, 1);
+    EXPECT_EQ(result.remainingFeedKeys, 0);
+}
+
+TEST_F(WolkSingleTests, AddReadingRefusedWhenCommandBufferIsFull)
+{
+    // Disable the reading queue, and let only one reading wait in the command buffer
+    service->m_readingQueue.reset();
+    service->m_commandBuffer->setCapacity(1, OverflowPolicy::DropNewest);
+    std::atomic_bool holding{false};
+    std::atomic_bool released{false};
+    service->addToCommandBuffer([&] {
+        holding = true;
+        while (!released)
+            std::this_thread::yield();
+    });
+    while (!holding)
+        std::this_thread::yield();
+
+    std::atomic_int stored{0};
+    EXPECT_CALL(GetDataServiceReference(), addReading(device.getKey(), _, A<const std::string&>(), _))
+      .WillOnce([&](const std::string&, const std::string&, const std::string&, std::uint64_t) {
+          ++stored;
+          Notify();
+      });
+    EXPECT_TRUE(service->addReading("T", "First"));
+    EXPECT_FALSE(service->addReading("T", "Second"));
+    EXPECT_EQ(service->getQueueDepth(), 1);
+    EXPECT_EQ(service->getOverflowCount(), 1);
+
+    released = true;
+    if (stored == 0)
+        Await();
+    EXPECT_EQ(stored, 1);
+}
+
+TEST_F(WolkSingleTests, ReadingsThatOverflowTheQueueKeepTheirOrder)
+{
+    // Let only two readings wait in the queue, while the command buffer is held
+    service->m_readingQueue.reset(new ReadingQueue{2});
+    std::atomic_bool holding{false};
+    std::atomic_bool released{false};
+    service->addToCommandBuffer([&] {
+        holding = true;
+        while (!released)
+            std::this_thread::yield();
+    });
+    while (!holding)
+        std::this_thread::yield();
+
+    std::vector<std::string> stored;
+    std::atomic_bool allStored{false};
+    EXPECT_CALL(GetDataServiceReference(), addReadings(device.getKey(), A<std::vector<Reading>&&>()))
+      .WillRepeatedly([&](const std::string&, std::vector<Reading>&& readings) {
+          for (const auto& reading : readings)
+              stored.emplace_back(reading.getStringValue());
+      });
+    EXPECT_CALL(GetDataServiceReference(), addReading(device.getKey(), _, A<const std::string&>(), _))
+      .WillRepeatedly([&](const std::string&, const std::string&, const std::string& value, std::uint64_t) {
+          stored.emplace_back(value);
+          if (stored.size() == 5)
+          {
+              allStored = true;
+              Notify();
+          }
+      });
+
+    // Once a reading overflowed, the ones after it follow it through the command buffer
+    for (const auto value : {"1", "2", "3", "4", "5"})
+        EXPECT_TRUE(service->addReading("T", std::string{value}));
+    EXPECT_EQ(service->m_readingQueue->size(), 2);
+    EXPECT_NE(service->m_readingOverflowTicket.load(), 0);
+
+    released = true;
+    if (!allStored)
+        Await(std::chrono::milliseconds{1000});
+    ASSERT_TRUE(allStored);
+    EXPECT_EQ(stored, (std::vector<std::string>{"1", "2", "3", "4", "5"}));
+    EXPECT_EQ(service->m_readingOverflowTicket.load(), 0);
+}
@@ -0,0 +1,302 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/WorkerPool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+using namespace ::testing;
+using namespace wolkabout::connect;
+
+namespace
+{
+std::shared_ptr<std::function<void()>> makeCommand(std::function<void()> function)
+{
+    return std::make_shared<std::function<void()>>(std::move(function));
+}
+
+template <class Predicate> bool waitFor(std::mutex& mutex, std::condition_variable& condition, Predicate predicate)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    return condition.wait_for(lock, std::chrono::seconds{1}, predicate);
+}
+}    // namespace
+
+TEST(WorkerPoolTests, PoolRunsTasks)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    auto count = 0;
+    auto pool = WorkerPool{2};
+    EXPECT_EQ(pool.getSize(), 2);
+
+    for (auto i = 0; i < 100; ++i)
+        pool.post([&] {
+            std::lock_guard<std::mutex> lock{mutex};
+            ++count;
+            condition.notify_one();
+        });
+    EXPECT_TRUE(waitFor(mutex, condition, [&] { return count == 100; }));
+}
+
+TEST(WorkerPoolTests, PoolOnlyGrows)
+{
+    auto pool = WorkerPool{0};
+    EXPECT_EQ(pool.getSize(), 1);
+    pool.grow(3);
+    EXPECT_EQ(pool.getSize(), 3);
+    pool.grow(2);
+    EXPECT_EQ(pool.getSize(), 3);
+}
+
+TEST(WorkerPoolTests, ExecutorKeepsTheOrder)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    auto pool = std::make_shared<WorkerPool>(4);
+    auto executor = SerialExecutor{pool};
+
+    auto order = std::vector<int>{};
+    std::atomic_int running{0};
+    std::atomic_bool overlapped{false};
+    for (auto i = 0; i < 500; ++i)
+        executor.pushCommand(makeCommand([&, i] {
+            if (++running > 1)
+                overlapped = true;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                order.emplace_back(i);
+            }
+            --running;
+            condition.notify_one();
+        }));
+    ASSERT_TRUE(waitFor(mutex, condition, [&] { return order.size() == 500; }));
+    EXPECT_FALSE(overlapped);
+    for (auto i = 0; i < 500; ++i)
+        EXPECT_EQ(order[static_cast<std::size_t>(i)], i);
+}
+
+TEST(WorkerPoolTests, BlockedExecutorDoesNotHoldUpOthers)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    auto pool = std::make_shared<WorkerPool>(2);
+    auto blocked = SerialExecutor{pool};
+    auto other = SerialExecutor{pool};
+
+    auto released = false;
+    auto ran = false;
+    blocked.pushCommand(makeCommand([&] { waitFor(mutex, condition, [&] { return released; }); }));
+    other.pushCommand(makeCommand([&] {
+        std::lock_guard<std::mutex> lock{mutex};
+        ran = true;
+        condition.notify_all();
+    }));
+    EXPECT_TRUE(waitFor(mutex, condition, [&] { return ran; }));
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        released = true;
+    }
+    condition.notify_all();
+}
+
+TEST(WorkerPoolTests, ExecutorWaitsForTheRunningCommand)
+{
+    auto pool = std::make_shared<WorkerPool>(1);
+    std::atomic_bool started{false};
+    std::atomic_bool finished{false};
+    std::atomic_bool droppedRan{false};
+    {
+        auto executor = SerialExecutor{pool};
+        executor.pushCommand(makeCommand([&] {
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds{50});
+            finished = true;
+        }));
+        executor.pushCommand(makeCommand([&] { droppedRan = true; }));
+        while (!started)
+            std::this_thread::yield();
+    }
+    EXPECT_TRUE(finished);
+
+    // Anything left in the pool from the destroyed executor does not run its commands anymore
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    EXPECT_FALSE(droppedRan);
+}
+
+TEST(WorkerPoolTests, DefaultPoolIsShared)
+{
+    WorkerPool::setDefaultSize(2);
+    const auto pool = WorkerPool::getDefault();
+    ASSERT_NE(pool, nullptr);
+    EXPECT_EQ(pool, WorkerPool::getDefault());
+    EXPECT_GE(pool->getSize(), 2);
+}
+
+TEST(WorkerPoolTests, FullExecutorRefusesTheNewest)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    auto released = false;
+    auto ran = std::vector<int>{};
+    auto pool = std::make_shared<WorkerPool>(1);
+    auto executor = SerialExecutor{pool};
+    executor.setCapacity(2, OverflowPolicy::DropNewest);
+
+    // Hold the executor, so the offered commands wait
+    executor.pushCommand(makeCommand([&] { waitFor(mutex, condition, [&] { return released; }); }));
+    while (executor.getDepth() > 0)
+        std::this_thread::yield();
+    for (auto i = 0; i < 4; ++i)
+    {
+        const auto accepted = executor.offerCommand(makeCommand([&, i] {
+            std::lock_guard<std::mutex> lock{mutex};
+            ran.emplace_back(i);
+            condition.notify_all();
+        }));
+        EXPECT_EQ(accepted, i < 2);
+    }
+    EXPECT_EQ(executor.getDepth(), 2);
+    EXPECT_EQ(executor.getDroppedCount(), 2);
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        released = true;
+    }
+    condition.notify_all();
+    ASSERT_TRUE(waitFor(mutex, condition, [&] { return ran.size() == 2; }));
+    EXPECT_EQ(ran, (std::vector<int>{0, 1}));
+}
+
+TEST(WorkerPoolTests, FullExecutorDropsTheOldestOffered)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    auto released = false;
+    auto ran = std::vector<int>{};
+    auto pool = std::make_shared<WorkerPool>(1);
+    auto executor = SerialExecutor{pool};
+    executor.setCapacity(2, OverflowPolicy::DropOldest);
+
+    executor.pushCommand(makeCommand([&] { waitFor(mutex, condition, [&] { return released; }); }));
+    while (executor.getDepth() > 0)
+        std::this_thread::yield();
+    const auto record = [&](int i) {
+        return makeCommand([&, i] {
+            std::lock_guard<std::mutex> lock{mutex};
+            ran.emplace_back(i);
+            condition.notify_all();
+        });
+    };
+
+    // The pushed command is never dropped, only the offered ones
+    executor.pushCommand(record(-1));
+    for (auto i = 0; i < 4; ++i)
+        EXPECT_TRUE(executor.offerCommand(record(i)));
+    EXPECT_EQ(executor.getDepth(), 2);
+    EXPECT_EQ(executor.getDroppedCount(), 3);
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        released = true;
+    }
+    condition.notify_all();
+    ASSERT_TRUE(waitFor(mutex, condition, [&] { return ran.size() == 2; }));
+    EXPECT_EQ(ran, (std::vector<int>{-1, 3}));
+}
+
+TEST(WorkerPoolTests, FullExecutorBlocksTheCaller)
+{
+    std::atomic_int ran{0};
+    auto pool = std::make_shared<WorkerPool>(1);
+    auto executor = SerialExecutor{pool};
+    executor.setCapacity(1, OverflowPolicy::Block);
+
+    for (auto i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(executor.offerCommand(makeCommand([&] {
+            std::this_thread::sleep_for(std::chrono::microseconds{100});
+            ++ran;
+        })));
+        EXPECT_LE(executor.getDepth(), 1);
+    }
+    while (ran < 100)
+        std::this_thread::yield();
+    EXPECT_EQ(executor.getDroppedCount(), 0);
+}
+
+TEST(WorkerPoolTests, FullExecutorDoesNotBlockAPoolThread)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    auto released = false;
+    auto offered = false;
+    auto accepted = false;
+    auto pool = std::make_shared<WorkerPool>(2);
+    auto executor = SerialExecutor{pool};
+    auto other = SerialExecutor{pool};
+    executor.setCapacity(1, OverflowPolicy::Block);
+
+    // Hold the executor, and fill it up
+    executor.pushCommand(makeCommand([&] { waitFor(mutex, condition, [&] { return released; }); }));
+    while (executor.getDepth() > 0)
+        std::this_thread::yield();
+    ASSERT_TRUE(executor.offerCommand(makeCommand([] {})));
+
+    // A command of another executor is not blocked, its command is taken over the capacity
+    other.pushCommand(makeCommand([&] {
+        const auto result = executor.offerCommand(makeCommand([] {}));
+        std::lock_guard<std::mutex> lock{mutex};
+        accepted = result;
+        offered = true;
+        condition.notify_all();
+    }));
+    EXPECT_TRUE(waitFor(mutex, condition, [&] { return offered; }));
+    EXPECT_TRUE(accepted);
+    EXPECT_EQ(executor.getDepth(), 2);
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        released = true;
+    }
+    condition.notify_all();
+}
+
+TEST(WorkerPoolTests, DestroyedPoolCleansUpTheDroppedTasks)
+{
+    std::atomic_bool released{false};
+    std::atomic_bool dropped{false};
+    auto pool = std::make_shared<WorkerPool>(1);
+    pool->post([&] {
+        while (!released)
+            std::this_thread::yield();
+    });
+    pool->post([] {}, [&] {
+        dropped = true;
+        released = true;
+    });
+
+    // The second task never gets to run, and its cleanup lets the first one finish
+    pool.reset();
+    EXPECT_TRUE(dropped);
+}
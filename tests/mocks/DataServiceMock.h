@@ -40,10 +40,13 @@ public:
                 (const std::string&, const std::string&, const std::vector<std::string>&, std::uint64_t));
     MOCK_METHOD(void, addReading, (const std::string&, const Reading&));
     MOCK_METHOD(void, addReadings, (const std::string&, const std::vector<Reading>&));
+    MOCK_METHOD(void, addReadings, (const std::string&, std::vector<Reading>&&));
     MOCK_METHOD(void, addAttribute, (const std::string&, const Attribute&));
     MOCK_METHOD(void, updateParameter, (const std::string&, const Parameter&));
     MOCK_METHOD(void, registerFeed, (const std::string&, Feed));
     MOCK_METHOD(void, registerFeeds, (const std::string&, std::vector<Feed>));
+    MOCK_METHOD(void, setFeedFilter, (const std::string&, const std::string&, const FeedFilter&));
+    MOCK_METHOD(void, setFeedAggregation, (const std::string&, const std::string&, const FeedAggregation&));
     MOCK_METHOD(void, removeFeed, (const std::string&, std::string));
     MOCK_METHOD(void, removeFeeds, (const std::string&, std::vector<std::string>));
     MOCK_METHOD(void, pullFeedValues, (const std::string&));
@@ -54,6 +57,7 @@ public:
                 (const std::string&, std::function<void(std::vector<std::string>, std::vector<std::string>)>));
     MOCK_METHOD(void, publishReadings, ());
     MOCK_METHOD(void, publishReadings, (const std::string&));
+    MOCK_METHOD(PublishSliceResult, publishReadingsSlice, (const PublishBudget&));
     MOCK_METHOD(void, publishAttributes, ());
     MOCK_METHOD(void, publishAttributes, (const std::string&));
     MOCK_METHOD(void, publishParameters, ());
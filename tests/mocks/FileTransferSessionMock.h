@@ -52,7 +52,7 @@ public:
     MOCK_METHOD(const std::vector<FileChunk>&, getChunks, (), (const));
 
 private:
-    CommandBuffer buffer;
+    SerialExecutor buffer;
 };
 
 #endif    // WOLKABOUTCONNECTOR_FILETRANSFERSESSIONMOCK_H
@@ -0,0 +1,56 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/ReconnectPolicy.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+namespace connect
+{
+ReconnectBackoff::ReconnectBackoff(const ReconnectPolicy& policy)
+: m_policy{policy}
+, m_delay{static_cast<double>(policy.initialDelay.count())}
+, m_attempts{0}
+, m_random{std::random_device{}()}
+{
+}
+
+std::chrono::milliseconds ReconnectBackoff::nextDelay()
+{
+    const auto maximum = static_cast<double>(m_policy.maximumDelay.count());
+    const auto delay = std::min(m_delay, maximum);
+    m_delay = std::min(delay * std::max(m_policy.multiplier, 1.0), maximum);
+    ++m_attempts;
+
+    const auto jitter = std::min(std::max(m_policy.jitter, 0.0), 1.0);
+    auto distribution = std::uniform_real_distribution<double>{1.0 - jitter, 1.0 + jitter};
+    return std::chrono::milliseconds{static_cast<std::chrono::milliseconds::rep>(delay * distribution(m_random))};
+}
+
+void ReconnectBackoff::reset()
+{
+    m_delay = static_cast<double>(m_policy.initialDelay.count());
+    m_attempts = 0;
+}
+
+std::uint32_t ReconnectBackoff::getAttempts() const
+{
+    return m_attempts;
+}
+}    // namespace connect
+}    // namespace wolkabout
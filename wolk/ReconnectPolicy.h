@@ -0,0 +1,97 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_RECONNECTPOLICY_H
+#define WOLKABOUTCONNECTOR_RECONNECTPOLICY_H
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This structure describes how long the Wolk object waits between attempts to connect to the platform. The delay
+ * starts at the initial delay, and is multiplied after every failed attempt, up to the maximum delay. Every delay is
+ * then randomly spread by the jitter, so many devices that lost the connection at the same time do not retry at the
+ * same time.
+ */
+struct ReconnectPolicy
+{
+    explicit ReconnectPolicy(std::chrono::milliseconds initial = std::chrono::milliseconds{1000},
+                             std::chrono::milliseconds maximum = std::chrono::milliseconds{60000},
+                             double delayMultiplier = 2.0, double jitterFraction = 0.2)
+    : initialDelay{initial}, maximumDelay{maximum}, multiplier{delayMultiplier}, jitter{jitterFraction}
+    {
+    }
+
+    // The delay before the first retry
+    std::chrono::milliseconds initialDelay;
+    // The longest delay between two retries
+    std::chrono::milliseconds maximumDelay;
+    // The factor by which the delay grows after every failed retry
+    double multiplier;
+    // The fraction of the delay by which it is randomly shortened or lengthened, from 0 (none) to 1
+    double jitter;
+};
+
+/**
+ * This is the object that calculates the delays between attempts to connect, following a `ReconnectPolicy`.
+ */
+class ReconnectBackoff
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param policy The policy for the delays.
+     */
+    explicit ReconnectBackoff(const ReconnectPolicy& policy = ReconnectPolicy{});
+
+    /**
+     * This method returns the delay before the next attempt, and grows the delay for the attempt after it.
+     *
+     * @return The delay, with the jitter applied.
+     */
+    std::chrono::milliseconds nextDelay();
+
+    /**
+     * This method resets the delay back to the initial one. It should be invoked once a connection is established.
+     */
+    void reset();
+
+    /**
+     * This is a getter for the count of delays given out since the last reset.
+     *
+     * @return The count of attempts.
+     */
+    std::uint32_t getAttempts() const;
+
+private:
+    ReconnectPolicy m_policy;
+
+    // Here is the delay before the next attempt, without the jitter
+    double m_delay;
+    std::uint32_t m_attempts;
+
+    std::minstd_rand m_random;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_RECONNECTPOLICY_H
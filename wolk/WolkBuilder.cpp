@@ -31,7 +31,9 @@
 #include "core/utilities/Logger.h"
 #include "wolk/WolkMulti.h"
 #include "wolk/WolkSingle.h"
+#include "wolk/WorkerPool.h"
 #include "wolk/service/data/DataService.h"
+#include "wolk/service/data/ReadingQueue.h"
 #include "wolk/service/file_management/FileManagementService.h"
 #include "wolk/service/firmware_update/FirmwareUpdateService.h"
 
@@ -47,6 +49,19 @@ WolkBuilder::WolkBuilder(std::vector<Device> devices)
 , m_host(WOLK_DEMO_HOST)
 , m_caCertPath(TRUST_STORE)
 , m_persistence{new InMemoryPersistence}
+, m_evictionPolicy{EvictionPolicy::DropOldest}
+, m_maxBufferedReadings{0}
+, m_maxBufferedBytes{0}
+, m_evictionParameter{0}
+, m_readingQueueCapacity{ReadingQueue::DEFAULT_CAPACITY}
+, m_commandQueueCapacity{0}
+, m_overflowPolicy{OverflowPolicy::Block}
+, m_readingsPublishMode{ReadingsPublishMode::PerFeed}
+, m_readingsBudget{0}
+, m_bytesBudget{0}
+, m_separateOutboundLane{true}
+, m_separateCallbackLane{true}
+, m_workerPoolSize{0}
 , m_dataProtocol{new WolkaboutDataProtocol}
 , m_errorProtocol{new WolkaboutErrorProtocol}
 , m_errorRetainTime{1000}
@@ -61,6 +76,19 @@ WolkBuilder::WolkBuilder(Device device)
 , m_host{WOLK_DEMO_HOST}
 , m_caCertPath{TRUST_STORE}
 , m_persistence{new InMemoryPersistence}
+, m_evictionPolicy{EvictionPolicy::DropOldest}
+, m_maxBufferedReadings{0}
+, m_maxBufferedBytes{0}
+, m_evictionParameter{0}
+, m_readingQueueCapacity{ReadingQueue::DEFAULT_CAPACITY}
+, m_commandQueueCapacity{0}
+, m_overflowPolicy{OverflowPolicy::Block}
+, m_readingsPublishMode{ReadingsPublishMode::PerFeed}
+, m_readingsBudget{0}
+, m_bytesBudget{0}
+, m_separateOutboundLane{true}
+, m_separateCallbackLane{true}
+, m_workerPoolSize{0}
 , m_dataProtocol{new WolkaboutDataProtocol}
 , m_errorProtocol{new WolkaboutErrorProtocol}
 , m_errorRetainTime{1000}
@@ -88,7 +116,7 @@ WolkBuilder& WolkBuilder::caCertPath(const std::string& caCertPath)
 }
 
 WolkBuilder& WolkBuilder::feedUpdateHandler(
-  const std::function<void(std::string, const std::map<std::uint64_t, std::vector<Reading>>)>& feedUpdateHandler)
+  const std::function<void(std::string, const std::map<std::uint64_t, std::vector<Reading>>&)>& feedUpdateHandler)
 {
     m_feedUpdateHandlerLambda = feedUpdateHandler;
     m_feedUpdateHandler.reset();
@@ -123,12 +151,88 @@ WolkBuilder& WolkBuilder::withPersistence(std::unique_ptr<Persistence> persisten
     return *this;
 }
 
+WolkBuilder& WolkBuilder::withBoundedPersistence(EvictionPolicy policy, std::uint64_t maxReadings,
+                                                 std::uint64_t maxBytes, std::uint64_t policyParameter)
+{
+    m_evictionPolicy = policy;
+    m_maxBufferedReadings = maxReadings;
+    m_maxBufferedBytes = maxBytes;
+    m_evictionParameter = policyParameter;
+    return *this;
+}
+
 WolkBuilder& WolkBuilder::withDataProtocol(std::unique_ptr<DataProtocol> protocol)
 {
     m_dataProtocol = std::move(protocol);
     return *this;
 }
 
+WolkBuilder& WolkBuilder::withReadingQueueCapacity(std::size_t capacity)
+{
+    m_readingQueueCapacity = capacity;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withCommandQueueCapacity(std::size_t capacity, OverflowPolicy policy)
+{
+    m_commandQueueCapacity = capacity;
+    m_overflowPolicy = policy;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withReadingsPublishMode(ReadingsPublishMode mode, std::uint64_t readingsBudget,
+                                                  std::uint64_t bytesBudget)
+{
+    m_readingsPublishMode = mode;
+    m_readingsBudget = readingsBudget;
+    m_bytesBudget = bytesBudget;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withPublishBudget(const PublishBudget& budget)
+{
+    m_publishBudget = budget;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withPublishSchedule(const PublishSchedule& schedule)
+{
+    m_publishSchedule = schedule;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withReconnectPolicy(const ReconnectPolicy& policy)
+{
+    m_reconnectPolicy = policy;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withExecutorLanes(bool separateOutbound, bool separateCallbacks)
+{
+    m_separateOutboundLane = separateOutbound;
+    m_separateCallbackLane = separateCallbacks;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withWorkerPoolSize(std::size_t threads)
+{
+    m_workerPoolSize = threads;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withPublishBatchSize(std::uint64_t batchSize)
+{
+    m_batchSizeController = BatchSizeController{batchSize};
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withAdaptivePublishBatchSize(std::uint64_t initialBatchSize, std::uint64_t minimumBatchSize,
+                                                       std::uint64_t maximumBatchSize, std::uint64_t maxPacketSize)
+{
+    m_batchSizeController = BatchSizeController{initialBatchSize, minimumBatchSize, maximumBatchSize, maxPacketSize};
+    return *this;
+}
+
 WolkBuilder& WolkBuilder::withErrorProtocol(std::chrono::milliseconds errorRetainTime,
                                             std::unique_ptr<ErrorProtocol> protocol)
 {
@@ -218,6 +322,10 @@ std::unique_ptr<WolkInterface> WolkBuilder::build(WolkInterfaceType type)
 {
     LOG(TRACE) << METHOD_INFO;
 
+    // Size the pool of threads before any of the services start using it
+    if (m_workerPoolSize > 0)
+        WorkerPool::setDefaultSize(m_workerPoolSize);
+
     // Make the Wolk instance
     auto wolk = std::unique_ptr<WolkInterface>{};
     auto deviceKeys = std::vector<std::string>{};
@@ -271,6 +379,11 @@ std::unique_ptr<WolkInterface> WolkBuilder::build(WolkInterfaceType type)
 
     // Connect the ConnectivityService with the ConnectivityManager.
     auto wolkRaw = wolk.get();
+    wolk->m_reconnectBackoff = ReconnectBackoff{m_reconnectPolicy};
+    if (!m_separateOutboundLane)
+        wolk->m_outboundCommandBuffer = wolk->m_commandBuffer;
+    if (!m_separateCallbackLane)
+        wolk->m_callbackCommandBuffer = wolk->m_commandBuffer;
     wolk->m_connectivityService->onConnectionLost([wolkRaw] {
         wolkRaw->notifyDisconnected();
         wolkRaw->tryConnect(true);
@@ -280,6 +393,11 @@ std::unique_ptr<WolkInterface> WolkBuilder::build(WolkInterfaceType type)
     // Set the data service, the only required service
     wolk->m_dataProtocol = std::move(m_dataProtocol);
     wolk->m_errorProtocol = std::move(m_errorProtocol);
+    if (m_maxBufferedReadings > 0 || m_maxBufferedBytes > 0 ||
+        (m_evictionPolicy == EvictionPolicy::PerFeedQuota && m_evictionParameter > 0))
+        m_persistence = std::unique_ptr<Persistence>{new BoundedPersistence{std::move(m_persistence), m_evictionPolicy,
+                                                                            m_maxBufferedReadings, m_maxBufferedBytes,
+                                                                            m_evictionParameter}};
     wolk->m_persistence = std::move(m_persistence);
     wolk->m_feedUpdateHandlerLambda = m_feedUpdateHandlerLambda;
     wolk->m_feedUpdateHandler = m_feedUpdateHandler;
@@ -287,8 +405,8 @@ std::unique_ptr<WolkInterface> WolkBuilder::build(WolkInterfaceType type)
     wolk->m_parameterHandler = m_parameterHandler;
     wolk->m_dataService = std::make_shared<DataService>(
       *wolk->m_dataProtocol, *wolk->m_persistence, *wolk->m_connectivityService, *wolk->m_outboundRetryMessageHandler,
-      [wolkRaw](const std::string& deviceKey, const std::map<std::uint64_t, std::vector<Reading>>& readings) {
-          wolkRaw->handleFeedUpdateCommand(deviceKey, readings);
+      [wolkRaw](const std::string& deviceKey, SharedFeedValues readings) {
+          wolkRaw->handleFeedUpdateCommand(deviceKey, std::move(readings));
       },
       [wolkRaw](const std::string& deviceKey, const std::vector<Parameter>& parameters) {
           wolkRaw->handleParameterCommand(deviceKey, parameters);
@@ -303,6 +421,24 @@ std::unique_ptr<WolkInterface> WolkBuilder::build(WolkInterfaceType type)
           for (const auto& parameter : parameters)
               LOG(INFO) << "\t\t" << parameter;
       });
+    wolk->m_dataService->setReadingsPublishMode(m_readingsPublishMode, m_readingsBudget, m_bytesBudget);
+    wolk->m_dataService->setBatchSizeController(m_batchSizeController);
+    wolk->m_publishBudget = m_publishBudget;
+    wolk->m_readingQueue.reset(m_readingQueueCapacity > 0 ? new ReadingQueue{m_readingQueueCapacity} : nullptr);
+    wolk->m_commandBuffer->setCapacity(m_commandQueueCapacity, m_overflowPolicy);
+    if (!m_publishSchedule.isDisabled())
+    {
+        wolk->m_publishScheduler.reset(
+          new PublishScheduler{m_publishSchedule, [wolkRaw] { wolkRaw->flushScheduledReadings(); }});
+        auto scheduler = wolk->m_publishScheduler.get();
+        wolk->m_dataService->setReadingsAddedListener(
+          [scheduler](std::uint64_t count, std::uint64_t bytes) { scheduler->readingsAdded(count, bytes); });
+        // Aggregation windows that don't get another reading are closed on the scheduler's tick, so they get published
+        // too. The closing is posted onto the command buffer, along with the rest of the work that stores readings.
+        scheduler->setTick(PublishScheduler::DEFAULT_TICK_INTERVAL, [wolkRaw] {
+            wolkRaw->addToCommandBuffer([wolkRaw] { wolkRaw->m_dataService->closeAggregationWindows(); });
+        });
+    }
     wolk->m_errorService = std::make_shared<ErrorService>(*wolk->m_errorProtocol, m_errorRetainTime);
     wolk->m_inboundMessageHandler->addListener(wolk->m_dataService);
     wolk->m_inboundMessageHandler->addListener(wolk->m_errorService);
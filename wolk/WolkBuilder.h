@@ -25,13 +25,20 @@
 #include "core/protocol/FirmwareUpdateProtocol.h"
 #include "core/protocol/PlatformStatusProtocol.h"
 #include "core/protocol/RegistrationProtocol.h"
+#include "wolk/ReconnectPolicy.h"
 #include "wolk/WolkInterfaceType.h"
+#include "wolk/WorkerPool.h"
 #include "wolk/api/FeedUpdateHandler.h"
 #include "wolk/api/FileListener.h"
 #include "wolk/api/FirmwareInstaller.h"
 #include "wolk/api/FirmwareParametersListener.h"
 #include "wolk/api/ParameterHandler.h"
 #include "wolk/api/PlatformStatusListener.h"
+#include "wolk/persistence/BoundedPersistence.h"
+#include "wolk/service/data/BatchSizeController.h"
+#include "wolk/service/data/PublishBudget.h"
+#include "wolk/service/data/PublishScheduler.h"
+#include "wolk/service/data/ReadingsPublishMode.h"
 #include "wolk/service/file_management/FileDownloader.h"
 
 #include <cstdint>
@@ -101,7 +108,7 @@ public:
      * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
      */
     WolkBuilder& feedUpdateHandler(
-      const std::function<void(std::string, const std::map<std::uint64_t, std::vector<Reading>>)>& feedUpdateHandler);
+      const std::function<void(std::string, const std::map<std::uint64_t, std::vector<Reading>>&)>& feedUpdateHandler);
 
     /**
      * @brief Sets feed update handler
@@ -133,6 +140,18 @@ public:
      */
     WolkBuilder& withPersistence(std::unique_ptr<Persistence> persistence);
 
+    /**
+     * @brief Limits the readings buffered in the persistence, so a long outage can not exhaust the memory or the disk.
+     * @details The persistence is wrapped in a `BoundedPersistence` when the Wolk instance is built.
+     * @param policy The eviction policy that makes room once the limit is reached.
+     * @param maxReadings The maximum count of buffered readings. 0 means unlimited.
+     * @param maxBytes The maximum estimated size of buffered readings (in bytes). 0 means unlimited.
+     * @param policyParameter The N for `Downsample` (every Nth reading is kept) or `PerFeedQuota` (readings per feed).
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withBoundedPersistence(EvictionPolicy policy, std::uint64_t maxReadings, std::uint64_t maxBytes = 0,
+                                        std::uint64_t policyParameter = 0);
+
     /**
      * @brief withDataProtocol Defines which data protocol to use
      * @param Protocol unique_ptr to wolkabout::DataProtocol implementation
@@ -140,6 +159,115 @@ public:
      */
     WolkBuilder& withDataProtocol(std::unique_ptr<DataProtocol> protocol);
 
+    /**
+     * @brief Sets the capacity of the queue in which added readings wait to be stored into persistence.
+     * @details Readings are passed from the threads that add them to the data service through a lock-free queue, and
+     * are stored in bulk. If the queue is full, readings are passed through the command buffer instead.
+     * @param capacity The count of readings the queue can hold. 0 disables the queue.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withReadingQueueCapacity(std::size_t capacity);
+
+    /**
+     * @brief Limits the count of commands waiting to store the added data, so a producer faster than the storage can
+     * not grow the memory without a limit.
+     * @details Only the readings can overflow, other commands are always accepted. A reading first goes into the
+     * reading queue, and only once that is full does it wait in the command buffer. What happens to a reading that
+     * finds the command buffer full depends on the policy. `Block` makes the caller wait for room, `DropNewest` refuses
+     * the reading, and `DropOldest` drops the oldest waiting readings instead. A refused reading makes `addReading`
+     * return false. Blocking callers should not be external handlers, as those run on the shared pool of threads.
+     * @param capacity The count of waiting commands. 0 means unlimited, which is the default.
+     * @param policy What happens to a reading added while the command buffer is full.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withCommandQueueCapacity(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::Block);
+
+    /**
+     * @brief Sets the way the readings from persistence are packed into outgoing messages.
+     * @details The default mode is `PerFeed`. In `PerDevice` mode all the pending feeds of a device are sent together,
+     * and the message is limited by the budgets.
+     * @param mode The readings publish mode.
+     * @param readingsBudget The maximum count of readings in a single message. 0 means unlimited.
+     * @param bytesBudget The maximum estimated size of readings in a single message (in bytes). 0 means unlimited.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withReadingsPublishMode(ReadingsPublishMode mode, std::uint64_t readingsBudget = 0,
+                                         std::uint64_t bytesBudget = 0);
+
+    /**
+     * @brief Sets the budget for publishing readings from persistence.
+     * @details By default, the whole backlog is published at once. With a budget set, the backlog is published in
+     * slices that fit the budget, and the command buffer is released between the slices, so a large backlog after an
+     * outage does not hold up the other commands.
+     * @param budget The limits for a single slice (messages, bytes, time). Limits left at 0 are unlimited.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withPublishBudget(const PublishBudget& budget);
+
+    /**
+     * @brief Sets the Wolk module to publish the readings automatically.
+     * @details The readings are published once the readings added since the last publish reach the count or the size
+     * threshold, or once the oldest of them has waited for the maximum latency, whichever comes first. Without a
+     * schedule, readings are only published when `publish` is called.
+     * @param schedule The thresholds for publishing (readings, bytes, latency). Thresholds left at 0 are not used.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withPublishSchedule(const PublishSchedule& schedule);
+
+    /**
+     * @brief Sets the delays between attempts to connect to the platform.
+     * @details After a failed attempt, the next one is made after the initial delay, which is then multiplied after
+     * every failed attempt, up to the maximum delay. Every delay is randomly spread by the jitter. By default, the
+     * delay starts at 1 second, doubles up to 1 minute, with 20% jitter.
+     * @param policy The reconnect policy.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withReconnectPolicy(const ReconnectPolicy& policy);
+
+    /**
+     * @brief Sets which work of the Wolk module gets a command buffer of its own.
+     * @details Storing the added data always has its own command buffer. By default, publishing to the platform
+     * (including connecting) and calling the external handlers and listeners each have their own too, so a slow
+     * handler or a slow publish does not hold up the data collection. A lane that is not separate shares the command
+     * buffer with the data storage.
+     * @param separateOutbound Whether publishing and connecting run on a separate command buffer.
+     * @param separateCallbacks Whether the feed update and parameter handlers, and the connection status listener run
+     * on a separate command buffer.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withExecutorLanes(bool separateOutbound, bool separateCallbacks);
+
+    /**
+     * @brief Sets the count of threads in the pool shared by the services.
+     * @details The services and the command buffers hold no threads of their own. Their commands run on a pool of
+     * threads shared by the whole process, still one after another for every service. The pool only grows, and the
+     * default is 4 threads. Connecting and publishing, calling the handlers, downloading and installing files can each
+     * hold a thread for a long time, so the pool should be grown when several of those are expected to run at once.
+     * @param threads The count of threads. 0 keeps the current size.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withWorkerPoolSize(std::size_t threads);
+
+    /**
+     * @brief Sets a fixed count of readings that is taken from persistence for a single message.
+     * @param batchSize The count of readings. The default is 50.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withPublishBatchSize(std::uint64_t batchSize);
+
+    /**
+     * @brief Sets the count of readings taken from persistence for a single message to adapt to the link.
+     * @details The batch size will grow while the messages are being published, shrink when publishing fails, and
+     * messages will be kept under the maximum packet size.
+     * @param initialBatchSize The batch size used at the start.
+     * @param minimumBatchSize The smallest batch size that can be used.
+     * @param maximumBatchSize The largest batch size that can be used.
+     * @param maxPacketSize The maximum payload size the broker accepts (in bytes). 0 means unlimited.
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withAdaptivePublishBatchSize(std::uint64_t initialBatchSize, std::uint64_t minimumBatchSize,
+                                              std::uint64_t maximumBatchSize, std::uint64_t maxPacketSize = 0);
+
     /**
      * @brief withErrorProtocol Defines which error protocol to use
      * @param errorRetainTime The time defining how long will the error messages be retained. The default retain time is
@@ -251,15 +379,40 @@ private:
     std::string m_caCertPath;
 
     // Here is the place for external entities capable of receiving Reading values.
-    std::function<void(std::string, std::map<std::uint64_t, std::vector<Reading>>)> m_feedUpdateHandlerLambda;
+    std::function<void(std::string, const std::map<std::uint64_t, std::vector<Reading>>&)> m_feedUpdateHandlerLambda;
     std::weak_ptr<FeedUpdateHandler> m_feedUpdateHandler;
 
     // Here is the place for external entities capable of receiving Parameter values.
     std::function<void(std::string, std::vector<Parameter>)> m_parameterHandlerLambda;
     std::weak_ptr<ParameterHandler> m_parameterHandler;
 
-    // Here is the place for the persistence pointer
+    // Here is the place for the persistence pointer, and the limits of buffered readings
     std::unique_ptr<Persistence> m_persistence;
+    EvictionPolicy m_evictionPolicy;
+    std::uint64_t m_maxBufferedReadings;
+    std::uint64_t m_maxBufferedBytes;
+    std::uint64_t m_evictionParameter;
+
+    // Here is the place for the capacity of the queue for added readings, and of the command buffer behind it
+    std::size_t m_readingQueueCapacity;
+    std::size_t m_commandQueueCapacity;
+    OverflowPolicy m_overflowPolicy;
+
+    // Here is the place for the way the readings are being published
+    ReadingsPublishMode m_readingsPublishMode;
+    std::uint64_t m_readingsBudget;
+    std::uint64_t m_bytesBudget;
+    PublishBudget m_publishBudget;
+    BatchSizeController m_batchSizeController;
+    PublishSchedule m_publishSchedule;
+
+    // Here is the place for the delays between attempts to connect
+    ReconnectPolicy m_reconnectPolicy;
+
+    // Here is the place for which work gets a command buffer of its own
+    bool m_separateOutboundLane;
+    bool m_separateCallbackLane;
+    std::size_t m_workerPoolSize;
 
     // Here is the place for all the protocols that are being held
     std::unique_ptr<DataProtocol> m_dataProtocol;
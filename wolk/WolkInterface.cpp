@@ -33,16 +33,23 @@ namespace wolkabout
 {
 namespace connect
 {
-WolkInterface::~WolkInterface() = default;
+WolkInterface::~WolkInterface()
+{
+    // Once the command buffers are gone, the reconnect timer must not post anything anymore
+    m_connectRequested = false;
+}
 
 void WolkInterface::connect()
 {
+    m_connectRequested = true;
     tryConnect(true);
 }
 
 void WolkInterface::disconnect()
 {
-    addToCommandBuffer([=]() -> void {
+    m_connectRequested = false;
+    addToOutboundCommandBuffer([=]() -> void {
+        m_reconnectTimer.stop();
         m_connectivityService->disconnect();
         notifyDisconnected();
     });
@@ -60,35 +67,99 @@ void WolkInterface::setConnectionStatusListener(ConnectionStatusListener listene
 
 void WolkInterface::publish()
 {
-    addToCommandBuffer([=]() -> void {
+    addToOutboundCommandBufferAfterIngestion([=]() -> void {
         flushAttributes();
         flushReadings();
         flushParameters();
     });
 }
 
-WolkInterface::WolkInterface() : m_connected(false), m_commandBuffer(new CommandBuffer) {}
+void WolkInterface::publishAsync(PublishCallback callback)
+{
+    addToOutboundCommandBufferAfterIngestion([=]() -> void {
+        flushAttributes();
+        flushReadingsSlice(std::make_shared<PublishResult>(), callback);
+    });
+}
+
+std::future<PublishResult> WolkInterface::publishFuture()
+{
+    auto promise = std::make_shared<std::promise<PublishResult>>();
+    auto future = promise->get_future();
+    publishAsync([promise](const PublishResult& result) { promise->set_value(result); });
+    return future;
+}
+
+EvictionCounters WolkInterface::getEvictionCounters()
+{
+    const auto boundedPersistence = dynamic_cast<BoundedPersistence*>(m_persistence.get());
+    return boundedPersistence != nullptr ? boundedPersistence->getCounters() : EvictionCounters{};
+}
+
+std::size_t WolkInterface::getQueueDepth()
+{
+    const auto queued = m_readingQueue != nullptr ? m_readingQueue->size() : std::size_t{0};
+    return queued + m_commandBuffer->getDepth();
+}
+
+std::uint64_t WolkInterface::getOverflowCount()
+{
+    return m_commandBuffer->getDroppedCount();
+}
+
+WolkInterface::WolkInterface()
+: m_connected(false)
+, m_connectRequested(false)
+, m_readingQueue(new ReadingQueue)
+, m_readingQueueDrainScheduled(false)
+, m_readingOverflowTickets(0)
+, m_readingOverflowTicket(0)
+, m_commandBuffer(new SerialExecutor)
+, m_outboundCommandBuffer(new SerialExecutor)
+, m_callbackCommandBuffer(new SerialExecutor)
+, m_flushingReadings(false)
+{
+}
 
 void WolkInterface::tryConnect(bool firstTime)
 {
-    addToCommandBuffer([=]() -> void {
+    addToOutboundCommandBuffer([=]() -> void {
+        // The connection could have been given up on, or established, while this attempt was waiting
+        if (!m_connectRequested || m_connected)
+            return;
+
         if (firstTime)
+        {
             LOG(INFO) << "Connecting...";
+            m_reconnectBackoff.reset();
+        }
 
         if (!m_connectivityService->connect())
         {
             if (firstTime)
                 LOG(INFO) << "Failed to connect";
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            tryConnect(false);
+            scheduleReconnect();
             return;
         }
 
+        m_reconnectBackoff.reset();
         notifyConnected();
     });
 }
 
+void WolkInterface::scheduleReconnect()
+{
+    // The outbound command buffer is not held up while waiting, so the publishes can still be attempted
+    const auto delay = m_reconnectBackoff.nextDelay();
+    LOG(DEBUG) << "Retrying to connect in " << delay.count() << "ms (attempt " << m_reconnectBackoff.getAttempts()
+               << ").";
+    m_reconnectTimer.start(delay, [this] {
+        if (m_connectRequested)
+            tryConnect(false);
+    });
+}
+
 void WolkInterface::notifyConnected()
 {
     LOG(INFO) << "Connection established";
@@ -114,10 +185,10 @@ void WolkInterface::notifyConnectionStatusListener()
 {
     if (m_connectionStatusListener)
     {
-        m_commandBuffer->pushCommand(std::make_shared<std::function<void()>>([this]() {
+        addToCallbackCommandBuffer([this]() {
             if (m_connectionStatusListener)
                 m_connectionStatusListener(m_connected);
-        }));
+        });
     }
 }
 
@@ -128,7 +199,55 @@ void WolkInterface::flushAttributes()
 
 void WolkInterface::flushReadings()
 {
-    m_dataService->publishReadings();
+    if (m_publishBudget.isUnlimited())
+    {
+        m_dataService->publishReadings();
+        return;
+    }
+
+    // If there's already a sliced flush going on, it will pick up the new readings too
+    if (m_flushingReadings.exchange(true))
+        return;
+    flushReadingsSlice();
+}
+
+void WolkInterface::flushReadingsSlice()
+{
+    const auto result = m_dataService->publishReadingsSlice(m_publishBudget);
+    if (result.backlogRemaining && result.failedMessages == 0 && m_connected)
+    {
+        // Yield the outbound command buffer to other commands, and continue with the next slice afterwards
+        addToOutboundCommandBuffer([=] { flushReadingsSlice(); });
+        return;
+    }
+    m_flushingReadings = false;
+}
+
+void WolkInterface::flushReadingsSlice(std::shared_ptr<PublishResult> result, PublishCallback callback)
+{
+    const auto slice = m_dataService->publishReadingsSlice(m_publishBudget);
+    result->sentMessages += slice.sentMessages;
+    result->sentReadings += slice.sentReadings;
+    result->failedMessages += slice.failedMessages;
+    if (slice.backlogRemaining && slice.failedMessages == 0 && m_connected)
+    {
+        addToOutboundCommandBuffer([=] { flushReadingsSlice(result, callback); });
+        return;
+    }
+
+    flushParameters();
+    result->remainingFeedKeys = m_persistence != nullptr ? m_persistence->getReadingsKeys().size() : 0;
+    if (callback)
+        addToCallbackCommandBuffer([=] { callback(*result); });
+}
+
+void WolkInterface::flushScheduledReadings()
+{
+    addToOutboundCommandBufferAfterIngestion([=] {
+        // While disconnected, the readings wait for the publish that follows the connection
+        if (m_connected)
+            flushReadings();
+    });
 }
 
 void WolkInterface::flushParameters()
@@ -136,19 +255,139 @@ void WolkInterface::flushParameters()
     m_dataService->publishParameters();
 }
 
-void WolkInterface::handleFeedUpdateCommand(const std::string& deviceKey,
-                                            const std::map<std::uint64_t, std::vector<Reading>>& readings)
+bool WolkInterface::queueReading(const std::string& deviceKey, const std::string& reference, ReadingValue value,
+                                 std::uint64_t rtc)
+{
+    auto record = ReadingRecord{};
+    record.deviceKey = deviceKey;
+    record.reference = reference;
+    record.value = std::move(value);
+    record.rtc = rtc != 0 ? rtc : currentRtc();
+    return queueReading(record);
+}
+
+bool WolkInterface::queueReading(const std::string& deviceKey, const std::string& reference,
+                                 std::vector<ReadingValue> values, std::uint64_t rtc)
+{
+    auto record = ReadingRecord{};
+    record.deviceKey = deviceKey;
+    record.reference = reference;
+    record.values = std::move(values);
+    record.multi = true;
+    record.rtc = rtc != 0 ? rtc : currentRtc();
+    return queueReading(record);
+}
+
+bool WolkInterface::queueReading(ReadingRecord& record)
+{
+    // While a reading that overflowed the queue waits in the command buffer, the readings after it follow it there
+    if (m_readingQueue != nullptr && m_readingOverflowTicket.load(std::memory_order_acquire) == 0 &&
+        m_readingQueue->push(record))
+    {
+        // Only the first reading after a drain has started needs to schedule the next drain
+        if (!m_readingQueueDrainScheduled.exchange(true, std::memory_order_acq_rel))
+            addToCommandBuffer([this] { drainReadingQueue(); });
+        return true;
+    }
+
+    // The queue is disabled, so every reading takes the slower path through the command buffer
+    if (m_readingQueue == nullptr)
+        return offerToCommandBuffer([this, record] {
+            auto records = std::vector<ReadingRecord>{record};
+            storeReadingRecords(records);
+        });
+
+    // The queue is full, so the reading goes through the command buffer, and first stores the older readings still in
+    // the queue. The tickets are handed out in the order the commands are offered, and only the last one lets the
+    // readings use the queue again.
+    std::lock_guard<std::mutex> lock{m_readingOverflowMutex};
+    const auto ticket = ++m_readingOverflowTickets;
+    m_readingOverflowTicket.store(ticket, std::memory_order_release);
+    return offerToCommandBuffer([this, record, ticket] {
+        drainReadingQueue();
+        auto last = ticket;
+        m_readingOverflowTicket.compare_exchange_strong(last, 0, std::memory_order_acq_rel);
+        auto records = std::vector<ReadingRecord>{record};
+        storeReadingRecords(records);
+    });
+}
+
+void WolkInterface::drainReadingQueue()
+{
+    // Readings pushed from now on will schedule another drain
+    m_readingQueueDrainScheduled.exchange(false, std::memory_order_acq_rel);
+
+    // Take at most one queue worth of readings, and pass them on in runs that belong to the same device
+    const auto budget = m_readingQueue->getCapacity();
+    auto taken = std::size_t{0};
+    auto record = ReadingRecord{};
+    auto run = std::vector<ReadingRecord>{};
+    while (taken < budget && m_readingQueue->pop(record))
+    {
+        ++taken;
+        if (!run.empty() && run.front().deviceKey != record.deviceKey)
+        {
+            storeReadingRecords(run);
+            run.clear();
+        }
+        run.emplace_back(std::move(record));
+    }
+    if (!run.empty())
+        storeReadingRecords(run);
+
+    // If the budget ran out, yield the command buffer to other commands, and continue afterwards
+    if (taken == budget && !m_readingQueueDrainScheduled.exchange(true, std::memory_order_acq_rel))
+        addToCommandBuffer([this] { drainReadingQueue(); });
+}
+
+void WolkInterface::storeReadingRecords(std::vector<ReadingRecord>& records)
+{
+    // This is where the values are turned into strings, only once, on the way into persistence
+    const auto toStrings = [](std::vector<ReadingValue>& values) {
+        auto strings = std::vector<std::string>{};
+        strings.reserve(values.size());
+        for (auto& value : values)
+            strings.emplace_back(value.takeString());
+        return strings;
+    };
+
+    if (records.size() == 1)
+    {
+        auto& record = records.front();
+        if (record.multi)
+            m_dataService->addReading(record.deviceKey, record.reference, toStrings(record.values), record.rtc);
+        else
+            m_dataService->addReading(record.deviceKey, record.reference, record.value.takeString(), record.rtc);
+        return;
+    }
+
+    auto readings = std::vector<Reading>{};
+    readings.reserve(records.size());
+    for (auto& record : records)
+    {
+        if (record.multi)
+            readings.emplace_back(std::move(record.reference), toStrings(record.values), record.rtc);
+        else
+            readings.emplace_back(std::move(record.reference), record.value.takeString(), record.rtc);
+    }
+    m_dataService->addReadings(records.front().deviceKey, std::move(readings));
+}
+
+void WolkInterface::handleFeedUpdateCommand(const std::string& deviceKey, SharedFeedValues readings)
 {
     LOG(INFO) << "Received feed update";
+    if (readings == nullptr)
+        return;
 
-    addToCommandBuffer([=] {
+    // The readings are shared with the command, and handed to the handlers by reference, so they are never copied
+    addToCallbackCommandBuffer([=] {
         if (auto provider = m_feedUpdateHandler.lock())
         {
-            provider->handleUpdate(deviceKey, readings);
+            provider->handleUpdate(deviceKey, *readings);
         }
         else if (m_feedUpdateHandlerLambda)
         {
-            m_feedUpdateHandlerLambda(deviceKey, readings);
+            m_feedUpdateHandlerLambda(deviceKey, *readings);
         }
     });
 }
@@ -157,7 +396,7 @@ void WolkInterface::handleParameterCommand(const std::string& deviceKey, const s
 {
     LOG(INFO) << "Received parameter sync";
 
-    addToCommandBuffer([=] {
+    addToCallbackCommandBuffer([=] {
         if (auto provider = m_parameterHandler.lock())
         {
             provider->handleUpdate(deviceKey, parameters);
@@ -177,7 +416,35 @@ std::uint64_t WolkInterface::currentRtc()
 
 void WolkInterface::addToCommandBuffer(std::function<void()> command)
 {
-    m_commandBuffer->pushCommand(std::make_shared<std::function<void()>>(command));
+    m_commandBuffer->pushCommand(std::make_shared<std::function<void()>>(std::move(command)));
+}
+
+bool WolkInterface::offerToCommandBuffer(std::function<void()> command)
+{
+    return m_commandBuffer->offerCommand(std::make_shared<std::function<void()>>(std::move(command)));
+}
+
+void WolkInterface::addToOutboundCommandBuffer(std::function<void()> command)
+{
+    m_outboundCommandBuffer->pushCommand(std::make_shared<std::function<void()>>(std::move(command)));
+}
+
+void WolkInterface::addToOutboundCommandBufferAfterIngestion(std::function<void()> command)
+{
+    if (m_outboundCommandBuffer == m_commandBuffer)
+    {
+        addToCommandBuffer(std::move(command));
+        return;
+    }
+
+    // Passing through the command buffer first makes sure everything added before is already in persistence
+    auto shared = std::make_shared<std::function<void()>>(std::move(command));
+    addToCommandBuffer([this, shared] { m_outboundCommandBuffer->pushCommand(shared); });
+}
+
+void WolkInterface::addToCallbackCommandBuffer(std::function<void()> command)
+{
+    m_callbackCommandBuffer->pushCommand(std::make_shared<std::function<void()>>(std::move(command)));
 }
 }    // namespace connect
 }    // namespace wolkabout
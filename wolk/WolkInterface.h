@@ -18,11 +18,16 @@
 #define WOLK_INTERFACE_H
 
 #include "core/model/Reading.h"
-#include "core/utilities/CommandBuffer.h"
+#include "core/utilities/Timer.h"
+#include "wolk/ReconnectPolicy.h"
 #include "wolk/WolkInterfaceType.h"
+#include "wolk/WorkerPool.h"
 #include "wolk/api/FeedUpdateHandler.h"
 #include "wolk/api/ParameterHandler.h"
+#include "wolk/persistence/BoundedPersistence.h"
 #include "wolk/service/data/DataService.h"
+#include "wolk/service/data/PublishScheduler.h"
+#include "wolk/service/data/ReadingQueue.h"
 #include "wolk/service/error/ErrorService.h"
 #include "wolk/service/file_management/FileManagementService.h"
 #include "wolk/service/firmware_update/FirmwareUpdateService.h"
@@ -31,8 +36,10 @@
 
 #include <atomic>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 
 namespace wolkabout
 {
@@ -58,6 +65,9 @@ class FileListener;
 // This is an alias for a lambda expression that can listen to the Wolk object's connection status.
 using ConnectionStatusListener = std::function<void(bool)>;
 
+// This is an alias for a lambda expression that receives the outcome of a publish.
+using PublishCallback = std::function<void(const PublishResult&)>;
+
 /**
  * This is an interface class that represents a Wolk implementation.
  * A Wolk implementation is a further specialized
@@ -73,12 +83,14 @@ public:
     virtual ~WolkInterface();
 
     /**
-     * This method will invoke the Wolk object to connect to the platform.
+     * This method will invoke the Wolk object to connect to the platform. Until it is connected, and whenever the
+     * connection is lost, it keeps retrying with the delays of its `ReconnectPolicy`.
      */
     virtual void connect();
 
     /**
-     * This method will invoke the Wolk object to disconnect from the platform.
+     * This method will invoke the Wolk object to disconnect from the platform. It also stops any further attempts to
+     * connect.
      */
     virtual void disconnect();
 
@@ -102,6 +114,47 @@ public:
      */
     virtual void publish();
 
+    /**
+     * This method will invoke the Wolk object to publish everything that is held in persistence, same as `publish`,
+     * and report how it went once the readings backlog is drained, or the publishing of it stopped on a failure.
+     * The counts in the result cover the readings, the attributes and parameters are published but not counted.
+     * The callback is invoked on the same command buffer as the feed and parameter handlers.
+     *
+     * @param callback The callback that will receive the outcome of the publish.
+     */
+    virtual void publishAsync(PublishCallback callback);
+
+    /**
+     * This method will invoke the Wolk object to publish everything that is held in persistence, and returns a future
+     * that becomes ready with the outcome of the publish. It must not be waited on from within a handler.
+     *
+     * @return The future that becomes ready once the publish is done.
+     */
+    std::future<PublishResult> publishFuture();
+
+    /**
+     * This method is a getter for the counters of readings that were dropped to keep the persistence under its limits.
+     *
+     * @return The eviction counters. They are all zero if the persistence is not bounded.
+     */
+    virtual EvictionCounters getEvictionCounters();
+
+    /**
+     * This method is a getter for the count of readings and commands waiting to be stored into persistence.
+     * Producers can use it to slow down before the command buffer overflows.
+     *
+     * @return The count of waiting readings and commands.
+     */
+    virtual std::size_t getQueueDepth();
+
+    /**
+     * This method is a getter for the count of readings that were refused or dropped because the command buffer was
+     * full. Readings added together with `addReadings` are counted once.
+     *
+     * @return The count of overflowed readings.
+     */
+    virtual std::uint64_t getOverflowCount();
+
     /**
      * This method will return a value indicating which type of a Wolk instance is this object.
      *
@@ -113,35 +166,54 @@ protected:
     // Internal forward declaration for the class that will listen to the ConnectivityService.
     class ConnectivityFacade;
 
-    // The protected constructor that will set the connection status to false, and create the command buffer.
+    // The protected constructor that will set the connection status to false, and create the command buffers.
     WolkInterface();
 
     // Here are some internal methods regarding the connection
     virtual void tryConnect(bool firstTime);
+    void scheduleReconnect();
     virtual void notifyConnected();
     virtual void notifyDisconnected();
     virtual void notifyConnectionStatusListener();
 
     // Here are some internal methods used to publish data from persistence
     virtual void flushReadings();
+    virtual void flushReadingsSlice();
+    void flushReadingsSlice(std::shared_ptr<PublishResult> result, PublishCallback callback);
+    virtual void flushScheduledReadings();
     virtual void flushAttributes();
     virtual void flushParameters();
 
+    // Here are some internal methods used to pass the readings from the producer threads to the data service
+    bool queueReading(const std::string& deviceKey, const std::string& reference, ReadingValue value,
+                      std::uint64_t rtc);
+    bool queueReading(const std::string& deviceKey, const std::string& reference, std::vector<ReadingValue> values,
+                      std::uint64_t rtc);
+    bool queueReading(ReadingRecord& record);
+    void drainReadingQueue();
+    void storeReadingRecords(std::vector<ReadingRecord>& records);
+
     // Here are internal methods that are used to propagate the data to external handlers
-    virtual void handleFeedUpdateCommand(const std::string& deviceKey,
-                                         const std::map<std::uint64_t, std::vector<Reading>>& readings);
+    virtual void handleFeedUpdateCommand(const std::string& deviceKey, SharedFeedValues readings);
     virtual void handleParameterCommand(const std::string& deviceKey, const std::vector<Parameter>& parameters);
 
     // Here are some utility methods to be used
     static std::uint64_t currentRtc();
     void addToCommandBuffer(std::function<void()> command);
+    bool offerToCommandBuffer(std::function<void()> command);
+    void addToOutboundCommandBuffer(std::function<void()> command);
+    void addToOutboundCommandBufferAfterIngestion(std::function<void()> command);
+    void addToCallbackCommandBuffer(std::function<void()> command);
 
     // Here is the place for the connection status and its listener
     std::atomic_bool m_connected;
+    // Here is whether the connection is wanted, and the delays between attempts to connect
+    std::atomic_bool m_connectRequested;
+    ReconnectBackoff m_reconnectBackoff;
     ConnectionStatusListener m_connectionStatusListener;
 
     // Here is the place for external entities capable of receiving Reading values.
-    std::function<void(const std::string&, const std::map<std::uint64_t, std::vector<Reading>>)>
+    std::function<void(const std::string&, const std::map<std::uint64_t, std::vector<Reading>>&)>
       m_feedUpdateHandlerLambda;
     std::weak_ptr<FeedUpdateHandler> m_feedUpdateHandler;
 
@@ -172,8 +244,31 @@ protected:
     std::shared_ptr<PlatformStatusService> m_platformStatusService;
     std::shared_ptr<RegistrationService> m_registrationService;
 
-    // Here is the command buffer that should be used
-    std::unique_ptr<CommandBuffer> m_commandBuffer;
+    // Here is the queue in which the readings wait for the data service, and the flag for a scheduled drain
+    std::unique_ptr<ReadingQueue> m_readingQueue;
+    std::atomic_bool m_readingQueueDrainScheduled;
+    // Here are the tickets of the readings that overflowed the queue, and the last one still waiting (0 if none)
+    std::mutex m_readingOverflowMutex;
+    std::uint64_t m_readingOverflowTickets;
+    std::atomic<std::uint64_t> m_readingOverflowTicket;
+
+    // Here is the timer that triggers the next attempt to connect. It only posts the attempt onto the command buffer,
+    // and it is declared before the command buffers, as a command they are still running might start it.
+    Timer m_reconnectTimer;
+
+    // Here are the command buffers that should be used. The first one stores the data, the outbound one talks to the
+    // platform, and the callback one calls the external handlers. The builder can make them share a buffer. All of them
+    // run on the pool shared by the process.
+    std::shared_ptr<SerialExecutor> m_commandBuffer;
+    std::shared_ptr<SerialExecutor> m_outboundCommandBuffer;
+    std::shared_ptr<SerialExecutor> m_callbackCommandBuffer;
+
+    // Here is the budget for a single slice of readings publishing, and the flag for an ongoing sliced flush
+    PublishBudget m_publishBudget;
+    std::atomic_bool m_flushingReadings;
+
+    // Here is the scheduler that publishes the readings automatically. It is stopped before anything else is destroyed.
+    std::unique_ptr<PublishScheduler> m_publishScheduler;
 };
 }    // namespace connect
 }    // namespace wolkabout
@@ -54,7 +54,7 @@ bool WolkMulti::addDevice(const Device& device)
     return true;
 }
 
-void WolkMulti::addReading(const std::string& deviceKey, const std::string& reference, std::string value,
+bool WolkMulti::addReading(const std::string& deviceKey, const std::string& reference, std::string value,
                            std::uint64_t rtc)
 {
     //    Now, I'd really like to add this check in the `addReading` call, but I think this method is called too often
@@ -64,12 +64,10 @@ void WolkMulti::addReading(const std::string& deviceKey, const std::string& refe
     //        LOG(WARN) << "Ignoring call of 'addReading' - Device '" << deviceKey << "' has not been added.";
     //        return;
     //    }
-    if (rtc == 0)
-        rtc = WolkMulti::currentRtc();
-    addToCommandBuffer([=]() -> void { m_dataService->addReading(deviceKey, reference, value, rtc); });
+    return queueReading(deviceKey, reference, ReadingValue{std::move(value)}, rtc);
 }
 
-void WolkMulti::addReading(const std::string& deviceKey, const std::string& reference,
+bool WolkMulti::addReading(const std::string& deviceKey, const std::string& reference,
                            const std::vector<std::string>& values, std::uint64_t rtc)
 {
     //    Now, I'd really like to add this check in the `addReading` call, but I think this method is called too often
@@ -79,19 +77,25 @@ void WolkMulti::addReading(const std::string& deviceKey, const std::string& refe
     //        LOG(WARN) << "Ignoring call of 'addReading' - Device '" << deviceKey << "' has not been added.";
     //        return;
     //    }
-    if (rtc == 0)
-        rtc = WolkMulti::currentRtc();
-    addToCommandBuffer([=]() -> void { m_dataService->addReading(deviceKey, reference, values, rtc); });
+    return queueReading(deviceKey, reference, std::vector<ReadingValue>(values.cbegin(), values.cend()), rtc);
 }
 
-void WolkMulti::addReading(const std::string& deviceKey, const Reading& reading)
+bool WolkMulti::addReading(const std::string& deviceKey, const Reading& reading)
 {
-    addToCommandBuffer([this, deviceKey, reading] { m_dataService->addReading(deviceKey, reading); });
+    return offerToCommandBuffer([this, deviceKey, reading] { m_dataService->addReading(deviceKey, reading); });
 }
 
-void WolkMulti::addReadings(const std::string& deviceKey, const std::vector<Reading>& readings)
+bool WolkMulti::addReadings(const std::string& deviceKey, const std::vector<Reading>& readings)
 {
-    addToCommandBuffer([this, deviceKey, readings] { m_dataService->addReadings(deviceKey, readings); });
+    return addReadings(deviceKey, std::vector<Reading>{readings});
+}
+
+bool WolkMulti::addReadings(const std::string& deviceKey, std::vector<Reading>&& readings)
+{
+    // The vector is moved into a shared pointer, as the command can't be moved into the buffer
+    auto shared = std::make_shared<std::vector<Reading>>(std::move(readings));
+    return offerToCommandBuffer(
+      [this, deviceKey, shared] { m_dataService->addReadings(deviceKey, std::move(*shared)); });
 }
 
 void WolkMulti::registerFeed(const std::string& deviceKey, const Feed& feed)
@@ -116,6 +120,43 @@ void WolkMulti::registerFeeds(const std::string& deviceKey, const std::vector<Fe
     addToCommandBuffer([=]() -> void { m_dataService->registerFeeds(deviceKey, feeds); });
 }
 
+void WolkMulti::registerFeed(const std::string& deviceKey, const Feed& feed, const FeedFilter& filter)
+{
+    if (!isDeviceInList(deviceKey))
+    {
+        LOG(WARN) << "Ignoring call of 'registerFeed' - Device '" << deviceKey << "' has not been added.";
+        return;
+    }
+
+    addToCommandBuffer([=]() -> void {
+        m_dataService->setFeedFilter(deviceKey, feed.getReference(), filter);
+        m_dataService->registerFeed(deviceKey, feed);
+    });
+}
+
+void WolkMulti::setFeedFilter(const std::string& deviceKey, const std::string& reference, const FeedFilter& filter)
+{
+    if (!isDeviceInList(deviceKey))
+    {
+        LOG(WARN) << "Ignoring call of 'setFeedFilter' - Device '" << deviceKey << "' has not been added.";
+        return;
+    }
+
+    addToCommandBuffer([=]() -> void { m_dataService->setFeedFilter(deviceKey, reference, filter); });
+}
+
+void WolkMulti::setFeedAggregation(const std::string& deviceKey, const std::string& reference,
+                                   const FeedAggregation& aggregation)
+{
+    if (!isDeviceInList(deviceKey))
+    {
+        LOG(WARN) << "Ignoring call of 'setFeedAggregation' - Device '" << deviceKey << "' has not been added.";
+        return;
+    }
+
+    addToCommandBuffer([=]() -> void { m_dataService->setFeedAggregation(deviceKey, reference, aggregation); });
+}
+
 void WolkMulti::removeFeed(const std::string& deviceKey, const std::string& reference)
 {
     if (!isDeviceInList(deviceKey))
@@ -146,7 +187,7 @@ void WolkMulti::pullFeedValues(const std::string& deviceKey)
         return;
     }
 
-    addToCommandBuffer([=]() -> void { m_dataService->pullFeedValues(deviceKey); });
+    addToOutboundCommandBuffer([=]() -> void { m_dataService->pullFeedValues(deviceKey); });
 }
 
 void WolkMulti::pullParameters(const std::string& deviceKey)
@@ -157,7 +198,7 @@ void WolkMulti::pullParameters(const std::string& deviceKey)
         return;
     }
 
-    addToCommandBuffer([=]() -> void { m_dataService->pullParameters(deviceKey); });
+    addToOutboundCommandBuffer([=]() -> void { m_dataService->pullParameters(deviceKey); });
 }
 
 void WolkMulti::addAttribute(const std::string& deviceKey, Attribute attribute)
@@ -252,6 +293,15 @@ bool WolkMulti::obtainDevicesAsync(const std::string& deviceKey, TimePoint times
     return m_registrationService->obtainDevicesAsync(deviceKey, timestampFrom, deviceType, externalId, callback);
 }
 
+void WolkMulti::publish(const std::string& deviceKey)
+{
+    addToOutboundCommandBufferAfterIngestion([=]() -> void {
+        m_dataService->publishAttributes(deviceKey);
+        m_dataService->publishReadings(deviceKey);
+        m_dataService->publishParameters(deviceKey);
+    });
+}
+
 std::uint64_t WolkMulti::peekErrorCount(const std::string& deviceKey)
 {
     if (!isDeviceInList(deviceKey))
@@ -22,8 +22,6 @@
 #include "wolk/WolkBuilder.h"
 #include "wolk/WolkInterface.h"
 
-#include <algorithm>
-
 namespace wolkabout
 {
 class Device;
@@ -42,21 +40,23 @@ public:
     bool addDevice(const Device& device);
 
     template <typename T>
-    void addReading(const std::string& deviceKey, const std::string& reference, T value, std::uint64_t rtc = 0);
+    bool addReading(const std::string& deviceKey, const std::string& reference, T value, std::uint64_t rtc = 0);
 
-    void addReading(const std::string& deviceKey, const std::string& reference, std::string value,
+    bool addReading(const std::string& deviceKey, const std::string& reference, std::string value,
                     std::uint64_t rtc = 0);
 
     template <typename T>
-    void addReading(const std::string& deviceKey, const std::string& reference, const std::vector<T>& values,
+    bool addReading(const std::string& deviceKey, const std::string& reference, const std::vector<T>& values,
                     std::uint64_t rtc = 0);
 
-    void addReading(const std::string& deviceKey, const std::string& reference, const std::vector<std::string>& values,
+    bool addReading(const std::string& deviceKey, const std::string& reference, const std::vector<std::string>& values,
                     std::uint64_t rtc = 0);
 
-    void addReading(const std::string& deviceKey, const Reading& reading);
+    bool addReading(const std::string& deviceKey, const Reading& reading);
+
+    bool addReadings(const std::string& deviceKey, const std::vector<Reading>& readings);
 
-    void addReadings(const std::string& deviceKey, const std::vector<Reading>& readings);
+    bool addReadings(const std::string& deviceKey, std::vector<Reading>&& readings);
 
     void pullFeedValues(const std::string& deviceKey);
     void pullParameters(const std::string& deviceKey);
@@ -64,6 +64,13 @@ public:
     void registerFeed(const std::string& deviceKey, const Feed& feed);
     void registerFeeds(const std::string& deviceKey, const std::vector<Feed>& feeds);
 
+    void registerFeed(const std::string& deviceKey, const Feed& feed, const FeedFilter& filter);
+
+    void setFeedFilter(const std::string& deviceKey, const std::string& reference, const FeedFilter& filter);
+
+    void setFeedAggregation(const std::string& deviceKey, const std::string& reference,
+                            const FeedAggregation& aggregation);
+
     void removeFeed(const std::string& deviceKey, const std::string& reference);
     void removeFeeds(const std::string& deviceKey, const std::vector<std::string>& references);
 
@@ -90,6 +97,16 @@ public:
                             std::string externalId = {},
                             std::function<void(const std::vector<RegisteredDeviceInformation>&)> callback = {});
 
+    using WolkInterface::publish;
+
+    /**
+     * This method will invoke the Wolk object to publish everything that is held in persistence for a single device.
+     * This includes readings, parameters and attributes of the device, without looking through other devices' data.
+     *
+     * @param deviceKey The key of the device.
+     */
+    void publish(const std::string& deviceKey);
+
     /**
      * This method allows the user to see the count of error messages a device currently has in the backlog, sent out
      * from the platform.
@@ -150,23 +167,24 @@ private:
 };
 
 template <typename T>
-void WolkMulti::addReading(const std::string& deviceKey, const std::string& reference, T value, std::uint64_t rtc)
+bool WolkMulti::addReading(const std::string& deviceKey, const std::string& reference, T value, std::uint64_t rtc)
 {
-    addReading(deviceKey, reference, StringUtils::toString(value), rtc);
+    return queueReading(deviceKey, reference, ReadingValue::from(value), rtc);
 }
 
 template <typename T>
-void WolkMulti::addReading(const std::string& deviceKey, const std::string& reference, const std::vector<T>& values,
+bool WolkMulti::addReading(const std::string& deviceKey, const std::string& reference, const std::vector<T>& values,
                            std::uint64_t rtc)
 {
     if (values.empty())
-        return;
+        return false;
 
-    std::vector<std::string> stringifiedValues(values.size());
-    std::transform(values.cbegin(), values.cend(), stringifiedValues.begin(),
-                   [&](const T& value) -> std::string { return StringUtils::toString(value); });
+    std::vector<ReadingValue> typedValues;
+    typedValues.reserve(values.size());
+    for (const auto& value : values)
+        typedValues.emplace_back(ReadingValue::from(value));
 
-    addReading(deviceKey, reference, stringifiedValues, rtc);
+    return queueReading(deviceKey, reference, std::move(typedValues), rtc);
 }
 }    // namespace connect
 }    // namespace wolkabout
@@ -27,55 +27,53 @@ WolkBuilder WolkSingle::newBuilder(Device device)
     return WolkBuilder(device);
 }
 
-void WolkSingle::addReading(const std::string& reference, std::string value, std::uint64_t rtc)
+bool WolkSingle::addReading(const std::string& reference, std::string value, std::uint64_t rtc)
 {
-    if (rtc == 0)
-    {
-        rtc = WolkSingle::currentRtc();
-    }
-
-    addToCommandBuffer([=] { m_dataService->addReading(m_device.getKey(), reference, value, rtc); });
+    return queueReading(m_device.getKey(), reference, ReadingValue{std::move(value)}, rtc);
 }
 
-void WolkSingle::addReading(const std::string& reference, const std::vector<std::string>& values, std::uint64_t rtc)
+bool WolkSingle::addReading(const std::string& reference, const std::vector<std::string>& values, std::uint64_t rtc)
 {
-    if (rtc == 0)
-    {
-        rtc = WolkSingle::currentRtc();
-    }
+    return queueReading(m_device.getKey(), reference, std::vector<ReadingValue>(values.cbegin(), values.cend()), rtc);
+}
 
-    addToCommandBuffer([=] { m_dataService->addReading(m_device.getKey(), reference, values, rtc); });
+bool WolkSingle::addReading(const Reading& reading)
+{
+    return offerToCommandBuffer([this, reading] { m_dataService->addReading(m_device.getKey(), reading); });
 }
 
-void WolkSingle::addReading(const Reading& reading)
+bool WolkSingle::addReadings(const std::vector<Reading>& readings)
 {
-    addToCommandBuffer([this, reading] { m_dataService->addReading(m_device.getKey(), reading); });
+    return addReadings(std::vector<Reading>{readings});
 }
 
-void WolkSingle::addReadings(const std::vector<Reading>& readings)
+bool WolkSingle::addReadings(std::vector<Reading>&& readings)
 {
-    addToCommandBuffer([this, readings] { m_dataService->addReadings(m_device.getKey(), readings); });
+    // The vector is moved into a shared pointer, as the command can't be moved into the buffer
+    auto shared = std::make_shared<std::vector<Reading>>(std::move(readings));
+    return offerToCommandBuffer(
+      [this, shared] { m_dataService->addReadings(m_device.getKey(), std::move(*shared)); });
 }
 
 void WolkSingle::pullFeedValues()
 {
-    addToCommandBuffer([=] { m_dataService->pullFeedValues(m_device.getKey()); });
+    addToOutboundCommandBuffer([=] { m_dataService->pullFeedValues(m_device.getKey()); });
 }
 
 void WolkSingle::pullParameters()
 {
-    addToCommandBuffer([=] { m_dataService->pullParameters(m_device.getKey()); });
+    addToOutboundCommandBuffer([=] { m_dataService->pullParameters(m_device.getKey()); });
 }
 
 void WolkSingle::synchronizeParameters(const std::vector<ParameterName>& parameters,
                                        std::function<void(std::vector<Parameter>)> callback)
 {
-    addToCommandBuffer([=] { m_dataService->synchronizeParameters(m_device.getKey(), parameters, callback); });
+    addToOutboundCommandBuffer([=] { m_dataService->synchronizeParameters(m_device.getKey(), parameters, callback); });
 }
 
 void WolkSingle::obtainDetails(std::function<void(std::vector<std::string>, std::vector<std::string>)> callback)
 {
-    addToCommandBuffer([=] { m_dataService->detailsSynchronizationAsync(m_device.getKey(), callback); });
+    addToOutboundCommandBuffer([=] { m_dataService->detailsSynchronizationAsync(m_device.getKey(), callback); });
 }
 
 void WolkSingle::registerFeed(const Feed& feed)
@@ -88,6 +86,24 @@ void WolkSingle::registerFeeds(const std::vector<Feed>& feeds)
     addToCommandBuffer([=] { m_dataService->registerFeeds(m_device.getKey(), feeds); });
 }
 
+void WolkSingle::registerFeed(const Feed& feed, const FeedFilter& filter)
+{
+    addToCommandBuffer([=] {
+        m_dataService->setFeedFilter(m_device.getKey(), feed.getReference(), filter);
+        m_dataService->registerFeed(m_device.getKey(), feed);
+    });
+}
+
+void WolkSingle::setFeedFilter(const std::string& reference, const FeedFilter& filter)
+{
+    addToCommandBuffer([=] { m_dataService->setFeedFilter(m_device.getKey(), reference, filter); });
+}
+
+void WolkSingle::setFeedAggregation(const std::string& reference, const FeedAggregation& aggregation)
+{
+    addToCommandBuffer([=] { m_dataService->setFeedAggregation(m_device.getKey(), reference, aggregation); });
+}
+
 void WolkSingle::removeFeed(const std::string& reference)
 {
     addToCommandBuffer([=] { m_dataService->removeFeed(m_device.getKey(), reference); });
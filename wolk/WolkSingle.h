@@ -22,7 +22,6 @@
 #include "core/utilities/StringUtils.h"
 #include "wolk/WolkInterface.h"
 
-#include <algorithm>
 #include <functional>
 #include <string>
 #include <vector>
@@ -68,8 +67,14 @@ public:
      *               - const char*<br>
      * @param rtc Reading POSIX time - Number of seconds since 01/01/1970<br>
      *            If omitted current POSIX time is adopted
+     * @return Whether the reading was accepted. A reading waits to be stored in the reading queue, or in the command
+     *         buffer once the queue is full. When the command buffer is full as well (see
+     *         `WolkBuilder::withCommandQueueCapacity`), the result depends on the overflow policy. With `Block`
+     *         the call waits for room and the reading is accepted. With `DropOldest` the reading is accepted, and
+     *         the oldest reading still waiting is dropped instead. With `DropNewest` this reading is refused, and
+     *         false is returned.
      */
-    template <typename T> void addReading(const std::string& reference, T value, std::uint64_t rtc = 0);
+    template <typename T> bool addReading(const std::string& reference, T value, std::uint64_t rtc = 0);
 
     /**
      * @brief Publishes sensor reading to Wolkabout IoT Cloud<br>
@@ -78,8 +83,9 @@ public:
      * @param value Sensor value
      * @param rtc Reading POSIX time - Number of seconds since 01/01/1970<br>
      *            If omitted current POSIX time is adopted
+     * @return Whether the reading was accepted, as described for `addReading(const std::string&, T, std::uint64_t)`.
      */
-    void addReading(const std::string& reference, std::string value, std::uint64_t rtc = 0);
+    bool addReading(const std::string& reference, std::string value, std::uint64_t rtc = 0);
 
     /**
      * @brief Publishes multi-value sensor reading to Wolkabout IoT Cloud<br>
@@ -101,9 +107,10 @@ public:
      *               - const char*<br>
      * @param rtc Reading POSIX time - Number of seconds since 01/01/1970<br>
      *            If omitted current POSIX time is adopted
+     * @return Whether the reading was accepted, as described for `addReading(const std::string&, T, std::uint64_t)`.
      */
     template <typename T>
-    void addReading(const std::string& reference, const std::vector<T>& values, std::uint64_t rtc = 0);
+    bool addReading(const std::string& reference, const std::vector<T>& values, std::uint64_t rtc = 0);
 
     /**
      * @brief Publishes multi-value sensor reading to Wolkabout IoT Cloud<br>
@@ -112,12 +119,15 @@ public:
      * @param values Multi-value sensor values
      * @param rtc Reading POSIX time - Number of seconds since 01/01/1970<br>
      *            If omitted current POSIX time is adopted
+     * @return Whether the reading was accepted, as described for `addReading(const std::string&, T, std::uint64_t)`.
      */
-    void addReading(const std::string& reference, const std::vector<std::string>& values, std::uint64_t rtc = 0);
+    bool addReading(const std::string& reference, const std::vector<std::string>& values, std::uint64_t rtc = 0);
 
-    void addReading(const Reading& reading);
+    bool addReading(const Reading& reading);
 
-    void addReadings(const std::vector<Reading>& readings);
+    bool addReadings(const std::vector<Reading>& readings);
+
+    bool addReadings(std::vector<Reading>&& readings);
 
     void pullFeedValues();
     void pullParameters();
@@ -130,6 +140,28 @@ public:
     void registerFeed(const Feed& feed);
     void registerFeeds(const std::vector<Feed>& feeds);
 
+    /**
+     * @brief Registers a feed, and sets the filter for its readings.
+     * @param feed The feed.
+     * @param filter The filter that decides which readings of the feed are stored, before they reach persistence.
+     */
+    void registerFeed(const Feed& feed, const FeedFilter& filter);
+
+    /**
+     * @brief Sets the filter for the readings of a feed. A filter with no rules removes the filter of the feed.
+     * @param reference The feed reference.
+     * @param filter The filter that decides which readings of the feed are stored, before they reach persistence.
+     */
+    void setFeedFilter(const std::string& reference, const FeedFilter& filter);
+
+    /**
+     * @brief Sets the aggregation of a feed, which rolls its readings up into time windows before they are stored.
+     * @param reference The feed reference.
+     * @param aggregation The window length and the statistics stored for every window. An aggregation without a
+     * window or statistics removes the aggregation of the feed.
+     */
+    void setFeedAggregation(const std::string& reference, const FeedAggregation& aggregation);
+
     void removeFeed(const std::string& reference);
     void removeFeeds(const std::vector<std::string>& references);
 
@@ -142,8 +174,6 @@ public:
     WolkInterfaceType getType() const override;
 
 protected:
-    static const constexpr unsigned int PUBLISH_BATCH_ITEMS_COUNT = 50;
-
     explicit WolkSingle(Device device);
 
     void notifyConnected() override;
@@ -151,22 +181,23 @@ protected:
     Device m_device;
 };
 
-template <typename T> void WolkSingle::addReading(const std::string& reference, T value, std::uint64_t rtc)
+template <typename T> bool WolkSingle::addReading(const std::string& reference, T value, std::uint64_t rtc)
 {
-    addReading(reference, StringUtils::toString(value), rtc);
+    return queueReading(m_device.getKey(), reference, ReadingValue::from(value), rtc);
 }
 
 template <typename T>
-void WolkSingle::addReading(const std::string& reference, const std::vector<T>& values, std::uint64_t rtc)
+bool WolkSingle::addReading(const std::string& reference, const std::vector<T>& values, std::uint64_t rtc)
 {
     if (values.empty())
-        return;
+        return false;
 
-    std::vector<std::string> stringifiedValues(values.size());
-    std::transform(values.cbegin(), values.cend(), stringifiedValues.begin(),
-                   [&](const T& value) -> std::string { return StringUtils::toString(value); });
+    std::vector<ReadingValue> typedValues;
+    typedValues.reserve(values.size());
+    for (const auto& value : values)
+        typedValues.emplace_back(ReadingValue::from(value));
 
-    addReading(reference, stringifiedValues, rtc);
+    return queueReading(m_device.getKey(), reference, std::move(typedValues), rtc);
 }
 }    // namespace connect
 }    // namespace wolkabout
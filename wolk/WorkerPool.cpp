@@ -0,0 +1,299 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/WorkerPool.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+namespace connect
+{
+namespace
+{
+// The count of commands an executor runs before it lets the other executors have the thread
+const std::size_t COMMANDS_PER_TURN = 64;
+
+// Whether the current thread belongs to a pool
+thread_local bool t_poolThread = false;
+}    // namespace
+
+const std::size_t WorkerPool::DEFAULT_SIZE = 4;
+
+std::mutex WorkerPool::s_defaultMutex;
+std::shared_ptr<WorkerPool> WorkerPool::s_default;
+std::size_t WorkerPool::s_defaultSize = WorkerPool::DEFAULT_SIZE;
+
+WorkerPool::WorkerPool(std::size_t size) : m_state{std::make_shared<State>()}
+{
+    grow(std::max(size, std::size_t{1}));
+}
+
+WorkerPool::~WorkerPool()
+{
+    auto dropped = std::deque<std::pair<std::function<void()>, std::function<void()>>>{};
+    {
+        std::lock_guard<std::mutex> lock{m_state->mutex};
+        m_state->running = false;
+        dropped.swap(m_state->tasks);
+    }
+    m_state->condition.notify_all();
+    for (auto& task : dropped)
+        if (task.second)
+            task.second();
+
+    std::lock_guard<std::mutex> lock{m_workersMutex};
+    for (auto& worker : m_workers)
+    {
+        // If the pool is destroyed from one of its own tasks, that thread finishes on its own
+        if (worker.get_id() == std::this_thread::get_id())
+            worker.detach();
+        else if (worker.joinable())
+            worker.join();
+    }
+}
+
+bool WorkerPool::post(std::function<void()> task, std::function<void()> onDropped)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_state->mutex};
+        if (!m_state->running)
+            return false;
+        m_state->tasks.emplace_back(std::move(task), std::move(onDropped));
+    }
+    m_state->condition.notify_one();
+    return true;
+}
+
+bool WorkerPool::isPoolThread()
+{
+    return t_poolThread;
+}
+
+void WorkerPool::grow(std::size_t size)
+{
+    std::lock_guard<std::mutex> lock{m_workersMutex};
+    const auto state = m_state;
+    while (m_workers.size() < size)
+        m_workers.emplace_back([state] { work(state); });
+}
+
+std::size_t WorkerPool::getSize()
+{
+    std::lock_guard<std::mutex> lock{m_workersMutex};
+    return m_workers.size();
+}
+
+std::shared_ptr<WorkerPool> WorkerPool::getDefault()
+{
+    std::lock_guard<std::mutex> lock{s_defaultMutex};
+    if (s_default == nullptr)
+        s_default = std::make_shared<WorkerPool>(s_defaultSize);
+    return s_default;
+}
+
+void WorkerPool::setDefaultSize(std::size_t size)
+{
+    std::lock_guard<std::mutex> lock{s_defaultMutex};
+    s_defaultSize = std::max(size, std::size_t{1});
+    if (s_default != nullptr)
+        s_default->grow(s_defaultSize);
+}
+
+void WorkerPool::work(const std::shared_ptr<State>& state)
+{
+    t_poolThread = true;
+    std::unique_lock<std::mutex> lock{state->mutex};
+    while (true)
+    {
+        state->condition.wait(lock, [&] { return !state->running || !state->tasks.empty(); });
+        if (!state->running)
+            return;
+
+        auto task = std::move(state->tasks.front().first);
+        state->tasks.pop_front();
+        lock.unlock();
+        task();
+        task = nullptr;
+        lock.lock();
+    }
+}
+
+SerialExecutor::SerialExecutor(std::shared_ptr<WorkerPool> pool)
+: m_pool{pool != nullptr ? std::move(pool) : WorkerPool::getDefault()}, m_state{std::make_shared<State>()}
+{
+    m_state->pool = m_pool.get();
+}
+
+SerialExecutor::~SerialExecutor()
+{
+    auto dropped = std::deque<std::pair<std::shared_ptr<std::function<void()>>, bool>>{};
+    {
+        std::unique_lock<std::mutex> lock{m_state->mutex};
+        m_state->stopped = true;
+        dropped.swap(m_state->commands);
+        m_state->condition.notify_all();
+
+        // A command can destroy its own executor, and then there is nothing to wait for
+        if (m_state->runner != std::this_thread::get_id())
+            m_state->condition.wait(
+              lock, [&] { return m_state->runner == std::thread::id{} && m_state->blocked == 0; });
+    }
+}
+
+void SerialExecutor::pushCommand(std::shared_ptr<std::function<void()>> command)
+{
+    std::unique_lock<std::mutex> lock{m_state->mutex};
+    if (m_state->stopped)
+        return;
+    enqueue(lock, std::move(command), false);
+}
+
+bool SerialExecutor::offerCommand(std::shared_ptr<std::function<void()>> command)
+{
+    std::unique_lock<std::mutex> lock{m_state->mutex};
+    if (m_state->stopped)
+        return false;
+
+    const auto isFull = [&] { return m_state->capacity > 0 && m_state->commands.size() >= m_state->capacity; };
+    const auto mustAccept = m_state->runner == std::this_thread::get_id() ||
+                            (m_state->policy == OverflowPolicy::Block && WorkerPool::isPoolThread());
+    if (isFull() && !mustAccept)
+    {
+        switch (m_state->policy)
+        {
+        case OverflowPolicy::Block:
+        {
+            ++m_state->blocked;
+            m_state->condition.wait(lock, [&] { return m_state->stopped || !isFull(); });
+            --m_state->blocked;
+            if (m_state->stopped)
+            {
+                m_state->condition.notify_all();
+                return false;
+            }
+            break;
+        }
+        case OverflowPolicy::DropOldest:
+        {
+            // Only offered commands can be dropped, the pushed ones are relied upon to run
+            const auto oldest = std::find_if(m_state->commands.begin(), m_state->commands.end(),
+                                             [](const std::pair<std::shared_ptr<std::function<void()>>, bool>& entry)
+                                             { return entry.second; });
+            ++m_state->dropped;
+            if (oldest == m_state->commands.end())
+                return false;
+            m_state->commands.erase(oldest);
+            break;
+        }
+        default:
+            ++m_state->dropped;
+            return false;
+        }
+    }
+
+    enqueue(lock, std::move(command), true);
+    return true;
+}
+
+void SerialExecutor::setCapacity(std::size_t capacity, OverflowPolicy policy)
+{
+    std::lock_guard<std::mutex> lock{m_state->mutex};
+    m_state->capacity = capacity;
+    m_state->policy = policy;
+    m_state->condition.notify_all();
+}
+
+std::size_t SerialExecutor::getDepth()
+{
+    std::lock_guard<std::mutex> lock{m_state->mutex};
+    return m_state->commands.size();
+}
+
+std::uint64_t SerialExecutor::getDroppedCount()
+{
+    std::lock_guard<std::mutex> lock{m_state->mutex};
+    return m_state->dropped;
+}
+
+void SerialExecutor::enqueue(std::unique_lock<std::mutex>& lock, std::shared_ptr<std::function<void()>> command,
+                             bool offered)
+{
+    m_state->commands.emplace_back(std::move(command), offered);
+    if (m_state->scheduled)
+        return;
+    m_state->scheduled = true;
+    lock.unlock();
+
+    const auto state = m_state;
+    if (!m_pool->post([state] { run(state); }, [state] { drop(state); }))
+        drop(state);
+}
+
+void SerialExecutor::run(const std::shared_ptr<State>& state)
+{
+    // The commands that can not run anymore are destroyed only once the state is unlocked
+    auto dropped = std::deque<std::pair<std::shared_ptr<std::function<void()>>, bool>>{};
+    std::unique_lock<std::mutex> lock{state->mutex};
+    state->runner = std::this_thread::get_id();
+    auto count = std::size_t{0};
+    while (!state->stopped && !state->commands.empty() && count < COMMANDS_PER_TURN)
+    {
+        auto command = std::move(state->commands.front().first);
+        state->commands.pop_front();
+        if (state->blocked > 0)
+            state->condition.notify_all();
+        lock.unlock();
+        if (command != nullptr && *command)
+            (*command)();
+        command = nullptr;
+        lock.lock();
+        ++count;
+    }
+    state->runner = std::thread::id{};
+
+    // The pool is still alive here, because the executor that holds it waits for this to finish
+    if (!state->stopped && !state->commands.empty())
+    {
+        auto pool = state->pool;
+        if (!pool->post([state] { run(state); }, [state] { drop(state); }))
+        {
+            state->stopped = true;
+            state->scheduled = false;
+            dropped.swap(state->commands);
+        }
+    }
+    else
+    {
+        state->scheduled = false;
+    }
+    state->condition.notify_all();
+}
+
+void SerialExecutor::drop(const std::shared_ptr<State>& state)
+{
+    // The pool is gone, so nothing would ever run the commands, or schedule the executor again
+    auto dropped = std::deque<std::pair<std::shared_ptr<std::function<void()>>, bool>>{};
+    {
+        std::lock_guard<std::mutex> lock{state->mutex};
+        state->stopped = true;
+        state->scheduled = false;
+        dropped.swap(state->commands);
+        state->condition.notify_all();
+    }
+}
+}    // namespace connect
+}    // namespace wolkabout
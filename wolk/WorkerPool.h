@@ -0,0 +1,232 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_WORKERPOOL_H
+#define WOLKABOUTCONNECTOR_WORKERPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This enumeration describes what happens to a command offered to a `SerialExecutor` that is full.
+ */
+enum class OverflowPolicy
+{
+    // The caller waits until there is room
+    Block,
+    // The offered command is refused
+    DropNewest,
+    // The oldest offered command that has not started is dropped to make room
+    DropOldest
+};
+
+/**
+ * This is a pool of threads that runs the tasks posted to it, in any order, on whichever thread is free. The services
+ * do not use it directly, but through a `SerialExecutor` each, so their own commands still run one after another.
+ *
+ * The default pool is shared by every Wolk object in the process, including the executors that connect, download,
+ * install or call external handlers, which can block one of its threads for a long time. It should be sized so those
+ * can block at once without holding up the others. A pool thread never waits on a full executor, so a blocked pool can
+ * not deadlock on itself.
+ */
+class WorkerPool
+{
+public:
+    // The count of threads in the default pool, unless set otherwise
+    static const std::size_t DEFAULT_SIZE;
+
+    /**
+     * Default constructor.
+     *
+     * @param size The count of threads in the pool. At least one thread is always created.
+     */
+    explicit WorkerPool(std::size_t size = DEFAULT_SIZE);
+
+    /**
+     * Default destructor. Waits for the running tasks to finish, and drops the ones that did not start, calling their
+     * cleanup.
+     */
+    ~WorkerPool();
+
+    /**
+     * This method posts a task to be run on one of the threads.
+     *
+     * @param task The task.
+     * @param onDropped The cleanup that is called instead of the task, if the pool is destroyed before it runs.
+     * @return Whether the task was accepted. It is not, if the pool is being destroyed.
+     */
+    bool post(std::function<void()> task, std::function<void()> onDropped = nullptr);
+
+    /**
+     * This method checks whether the calling thread is a thread of any pool.
+     *
+     * @return Whether the caller is a pool thread.
+     */
+    static bool isPoolThread();
+
+    /**
+     * This method grows the pool to the new size. The pool never shrinks, because its threads may be blocked in tasks.
+     *
+     * @param size The new count of threads.
+     */
+    void grow(std::size_t size);
+
+    /**
+     * This is a getter for the count of threads in the pool.
+     *
+     * @return The count of threads.
+     */
+    std::size_t getSize();
+
+    /**
+     * This method returns the pool shared by all the services that were not given a pool of their own. It is created
+     * once it is first needed.
+     *
+     * @return The default pool.
+     */
+    static std::shared_ptr<WorkerPool> getDefault();
+
+    /**
+     * This method sets the count of threads in the default pool. If the pool already exists, it is grown.
+     *
+     * @param size The count of threads.
+     */
+    static void setDefaultSize(std::size_t size);
+
+private:
+    // Here is the state shared with the threads, so a thread can outlive the pool if it is destroyed from a task
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::pair<std::function<void()>, std::function<void()>>> tasks;
+        bool running = true;
+    };
+
+    static void work(const std::shared_ptr<State>& state);
+
+    std::shared_ptr<State> m_state;
+    std::mutex m_workersMutex;
+    std::vector<std::thread> m_workers;
+
+    // Here is the default pool, and the size it will be created with
+    static std::mutex s_defaultMutex;
+    static std::shared_ptr<WorkerPool> s_default;
+    static std::size_t s_defaultSize;
+};
+
+/**
+ * This is the executor that runs commands one after another, in the order they were pushed, on the threads of a
+ * `WorkerPool`. It holds no thread of its own, so a service that is mostly idle costs nothing but memory.
+ */
+class SerialExecutor
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param pool The pool to run the commands on. If none is given, the default pool is used.
+     */
+    explicit SerialExecutor(std::shared_ptr<WorkerPool> pool = nullptr);
+
+    /**
+     * Default destructor. Waits for the running command to finish, and drops the commands that did not start.
+     */
+    ~SerialExecutor();
+
+    /**
+     * This method pushes a command to be run after all the commands pushed before it.
+     *
+     * @param command The command.
+     */
+    void pushCommand(std::shared_ptr<std::function<void()>> command);
+
+    /**
+     * This method offers a command to be run after all the commands pushed before it. Unlike pushed commands, offered
+     * commands respect the capacity, and if the executor is full, the overflow policy decides what happens. Commands
+     * offered from a command of this executor are always accepted, as waiting for itself would never end. A pool
+     * thread is never blocked either, so with the `Block` policy, commands offered from any pool thread are accepted.
+     *
+     * @param command The command.
+     * @return Whether the command was accepted.
+     */
+    bool offerCommand(std::shared_ptr<std::function<void()>> command);
+
+    /**
+     * This method limits the count of commands waiting in the executor.
+     *
+     * @param capacity The count of waiting commands after which offered commands overflow. 0 means unlimited.
+     * @param policy What happens to a command offered while the executor is full.
+     */
+    void setCapacity(std::size_t capacity, OverflowPolicy policy);
+
+    /**
+     * This is a getter for the count of commands waiting in the executor, not counting the one that is running.
+     *
+     * @return The count of waiting commands.
+     */
+    std::size_t getDepth();
+
+    /**
+     * This is a getter for the count of offered commands that were refused or dropped because the executor was full.
+     *
+     * @return The count of dropped commands.
+     */
+    std::uint64_t getDroppedCount();
+
+private:
+    // Here is the state shared with the tasks posted to the pool, as they can outlive the executor
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::pair<std::shared_ptr<std::function<void()>>, bool>> commands;
+        WorkerPool* pool = nullptr;
+        std::thread::id runner;
+        bool scheduled = false;
+        bool stopped = false;
+        std::size_t capacity = 0;
+        OverflowPolicy policy = OverflowPolicy::Block;
+        std::size_t blocked = 0;
+        std::uint64_t dropped = 0;
+    };
+
+    // Here is the common part of pushing and offering, where the state is already locked
+    void enqueue(std::unique_lock<std::mutex>& lock, std::shared_ptr<std::function<void()>> command, bool offered);
+
+    static void run(const std::shared_ptr<State>& state);
+
+    static void drop(const std::shared_ptr<State>& state);
+
+    std::shared_ptr<WorkerPool> m_pool;
+    std::shared_ptr<State> m_state;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_WORKERPOOL_H
@@ -0,0 +1,67 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_BATCHPERSISTENCE_H
+#define WOLKABOUTCONNECTOR_BATCHPERSISTENCE_H
+
+#include "core/model/Reading.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This is an interface a `Persistence` implementation can additionally implement, to store many readings at once.
+ * `DataService` uses it when the persistence implements it, and falls back to `putReading` for every reading when not.
+ * `BoundedPersistence` uses it to count the readings that are already stored.
+ */
+class BatchPersistence
+{
+public:
+    virtual ~BatchPersistence() = default;
+
+    /**
+     * This method stores readings under a single key, in the order they are given.
+     *
+     * @param key The persistence key.
+     * @param readings The readings, which are moved from.
+     * @return Whether all the readings were stored.
+     */
+    virtual bool putReadings(const std::string& key, std::vector<Reading>&& readings) = 0;
+
+    /**
+     * This method passes the readings stored under a key to the visitor one by one, in the order they were stored, so
+     * they never all have to be held in memory at once.
+     *
+     * @param key The persistence key.
+     * @param visitor The visitor that is called for every reading.
+     * @return Whether the readings were visited. The default implementation does not support it, and returns false.
+     */
+    virtual bool visitReadings(const std::string& key, const std::function<void(const Reading&)>& visitor)
+    {
+        (void)key;
+        (void)visitor;
+        return false;
+    }
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_BATCHPERSISTENCE_H
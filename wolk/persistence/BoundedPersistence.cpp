@@ -0,0 +1,363 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/persistence/BoundedPersistence.h"
+
+#include "core/utilities/Logger.h"
+#include "wolk/persistence/ReadingSize.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace wolkabout
+{
+namespace connect
+{
+const constexpr std::uint64_t BoundedPersistence::DEFAULT_DOWNSAMPLE_FACTOR;
+
+BoundedPersistence::BoundedPersistence(std::unique_ptr<Persistence> persistence, EvictionPolicy policy,
+                                       std::uint64_t maxReadings, std::uint64_t maxBytes,
+                                       std::uint64_t policyParameter)
+: m_persistence(std::move(persistence))
+, m_batchPersistence(dynamic_cast<BatchPersistence*>(m_persistence.get()))
+, m_policy(policy)
+, m_maxReadings(maxReadings)
+, m_maxBytes(maxBytes)
+, m_policyParameter(policy == EvictionPolicy::Downsample && policyParameter == 0 ? DEFAULT_DOWNSAMPLE_FACTOR :
+                                                                                    policyParameter)
+, m_nextOrder(0)
+, m_readings(0)
+, m_bytes(0)
+{
+    if (m_persistence == nullptr)
+        throw std::invalid_argument("Unable to create a bounded persistence without a persistence.");
+
+    // Count the readings that are already there, one by one if possible, and bring them under the limit
+    for (const auto& key : m_persistence->getReadingsKeys())
+    {
+        const auto visited = m_batchPersistence != nullptr &&
+                             m_batchPersistence->visitReadings(
+                               key, [&](const Reading& reading) { track(key, estimateReadingSize(reading)); });
+        if (!visited)
+            for (const auto& reading : m_persistence->getReadings(key, std::numeric_limits<std::uint_fast64_t>::max()))
+                track(key, estimateReadingSize(*reading));
+    }
+    while (isOverLimit(0, 0) && m_readings > 0)
+        evictOldest();
+    removeEvicted();
+}
+
+bool BoundedPersistence::putReading(const std::string& key, const Reading& reading)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto size = estimateReadingSize(reading);
+
+    if (m_policy == EvictionPolicy::Downsample)
+    {
+        if (isOverLimit(1, size))
+        {
+            if (m_downsampling[key]++ % m_policyParameter != 0)
+            {
+                ++m_counters.downsampledReadings;
+                return true;
+            }
+        }
+        else if (!m_downsampling.empty())
+            m_downsampling.clear();
+    }
+    else if (m_policy == EvictionPolicy::PerFeedQuota && m_policyParameter > 0)
+    {
+        // The entries of the key are erased once they are all evicted, so they are looked up again every time
+        while (m_entries.count(key) != 0 && m_entries[key].size() >= m_policyParameter)
+        {
+            evict(key);
+            ++m_counters.quotaEvictedReadings;
+        }
+    }
+
+    while (isOverLimit(1, size) && m_readings > 0)
+        evictOldest();
+    removeEvicted();
+
+    if (!m_persistence->putReading(key, reading))
+        return false;
+    track(key, size);
+    return true;
+}
+
+bool BoundedPersistence::putReadings(const std::string& key, std::vector<Reading>&& readings)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    // The readings are collected until something has to be evicted, and then stored all at once, so the outcome is
+    // the same as if they were put one by one
+    auto pending = std::vector<Reading>{};
+    auto sizes = std::vector<std::uint64_t>{};
+    auto pendingBytes = std::uint64_t{0};
+    pending.reserve(readings.size());
+    sizes.reserve(readings.size());
+    for (auto& reading : readings)
+    {
+        const auto size = estimateReadingSize(reading);
+
+        if (m_policy == EvictionPolicy::Downsample)
+        {
+            if (isOverLimit(pending.size() + 1, pendingBytes + size))
+            {
+                if (m_downsampling[key]++ % m_policyParameter != 0)
+                {
+                    ++m_counters.downsampledReadings;
+                    continue;
+                }
+            }
+            else if (!m_downsampling.empty())
+                m_downsampling.clear();
+        }
+        else if (m_policy == EvictionPolicy::PerFeedQuota && m_policyParameter > 0)
+        {
+            const auto it = m_entries.find(key);
+            const auto buffered = (it != m_entries.cend() ? it->second.size() : 0) + pending.size();
+            if (buffered >= m_policyParameter)
+            {
+                if (!storePending(key, pending, sizes, pendingBytes))
+                    return false;
+                while (m_entries.count(key) != 0 && m_entries[key].size() >= m_policyParameter)
+                {
+                    evict(key);
+                    ++m_counters.quotaEvictedReadings;
+                }
+            }
+        }
+
+        if (isOverLimit(pending.size() + 1, pendingBytes + size))
+        {
+            if (!storePending(key, pending, sizes, pendingBytes))
+                return false;
+            while (isOverLimit(1, size) && m_readings > 0)
+                evictOldest();
+        }
+
+        pending.emplace_back(std::move(reading));
+        sizes.emplace_back(size);
+        pendingBytes += size;
+    }
+    return storePending(key, pending, sizes, pendingBytes);
+}
+
+bool BoundedPersistence::visitReadings(const std::string& key, const std::function<void(const Reading&)>& visitor)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_batchPersistence != nullptr && m_batchPersistence->visitReadings(key, visitor);
+}
+
+std::vector<std::shared_ptr<Reading>> BoundedPersistence::getReadings(const std::string& key,
+                                                                      std::uint_fast64_t count)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_persistence->getReadings(key, count);
+}
+
+void BoundedPersistence::removeReadings(const std::string& key, std::uint_fast64_t count)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_persistence->removeReadings(key, count);
+    untrack(key, count);
+}
+
+std::vector<std::string> BoundedPersistence::getReadingsKeys()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_persistence->getReadingsKeys();
+}
+
+bool BoundedPersistence::putAttribute(const std::string& key, std::shared_ptr<Attribute> attribute)
+{
+    return m_persistence->putAttribute(key, std::move(attribute));
+}
+
+std::map<std::string, std::shared_ptr<Attribute>> BoundedPersistence::getAttributes()
+{
+    return m_persistence->getAttributes();
+}
+
+std::shared_ptr<Attribute> BoundedPersistence::getAttributeUnderKey(const std::string& key)
+{
+    return m_persistence->getAttributeUnderKey(key);
+}
+
+void BoundedPersistence::removeAttributes()
+{
+    m_persistence->removeAttributes();
+}
+
+void BoundedPersistence::removeAttributes(const std::string& key)
+{
+    m_persistence->removeAttributes(key);
+}
+
+std::vector<std::string> BoundedPersistence::getAttributeKeys()
+{
+    return m_persistence->getAttributeKeys();
+}
+
+bool BoundedPersistence::putParameter(const std::string& key, Parameter parameter)
+{
+    return m_persistence->putParameter(key, std::move(parameter));
+}
+
+std::map<std::string, Parameter> BoundedPersistence::getParameters()
+{
+    return m_persistence->getParameters();
+}
+
+Parameter BoundedPersistence::getParameterForKey(const std::string& key)
+{
+    return m_persistence->getParameterForKey(key);
+}
+
+void BoundedPersistence::removeParameters()
+{
+    m_persistence->removeParameters();
+}
+
+void BoundedPersistence::removeParameters(const std::string& key)
+{
+    m_persistence->removeParameters(key);
+}
+
+std::vector<std::string> BoundedPersistence::getParameterKeys()
+{
+    return m_persistence->getParameterKeys();
+}
+
+bool BoundedPersistence::isEmpty()
+{
+    return m_persistence->isEmpty();
+}
+
+EvictionCounters BoundedPersistence::getCounters()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_counters;
+}
+
+std::uint64_t BoundedPersistence::getBufferedReadings()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_readings;
+}
+
+std::uint64_t BoundedPersistence::getBufferedBytes()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_bytes;
+}
+
+bool BoundedPersistence::isOverLimit(std::uint64_t incomingReadings, std::uint64_t incomingSize) const
+{
+    return (m_maxReadings > 0 && m_readings + incomingReadings > m_maxReadings) ||
+           (m_maxBytes > 0 && m_bytes + incomingSize > m_maxBytes);
+}
+
+void BoundedPersistence::track(const std::string& key, std::uint64_t size)
+{
+    auto& entries = m_entries[key];
+    if (entries.empty())
+        m_heads.emplace(m_nextOrder, key);
+    entries.emplace_back(Entry{m_nextOrder++, size});
+    ++m_readings;
+    m_bytes += size;
+}
+
+void BoundedPersistence::untrack(const std::string& key, std::uint64_t count)
+{
+    const auto it = m_entries.find(key);
+    if (it == m_entries.cend() || it->second.empty())
+        return;
+
+    auto& entries = it->second;
+    m_heads.erase({entries.front().order, key});
+    for (std::uint64_t i = 0; i < count && !entries.empty(); ++i)
+    {
+        --m_readings;
+        m_bytes -= entries.front().size;
+        entries.pop_front();
+    }
+    if (entries.empty())
+        m_entries.erase(it);
+    else
+        m_heads.emplace(entries.front().order, key);
+}
+
+void BoundedPersistence::evict(const std::string& key)
+{
+    const auto it = m_entries.find(key);
+    if (it == m_entries.cend() || it->second.empty())
+        return;
+
+    ++m_counters.evictedReadings;
+    m_counters.evictedBytes += it->second.front().size;
+    ++m_evicted[key];
+    untrack(key, 1);
+}
+
+void BoundedPersistence::evictOldest()
+{
+    if (m_heads.empty())
+        return;
+    // The key is copied, as the entry in the set is replaced while evicting
+    const auto key = m_heads.begin()->second;
+    evict(key);
+}
+
+void BoundedPersistence::removeEvicted()
+{
+    // The evicted readings are the oldest ones of their keys, so they are removed with a single call for every key
+    for (const auto& pair : m_evicted)
+        m_persistence->removeReadings(pair.first, pair.second);
+    m_evicted.clear();
+}
+
+bool BoundedPersistence::storePending(const std::string& key, std::vector<Reading>& pending,
+                                      std::vector<std::uint64_t>& sizes, std::uint64_t& pendingBytes)
+{
+    removeEvicted();
+    if (pending.empty())
+        return true;
+
+    auto stored = true;
+    if (m_batchPersistence != nullptr)
+        stored = m_batchPersistence->putReadings(key, std::move(pending));
+    else
+    {
+        for (const auto& reading : pending)
+        {
+            stored = m_persistence->putReading(key, reading);
+            if (!stored)
+                break;
+        }
+    }
+    if (stored)
+        for (const auto size : sizes)
+            track(key, size);
+
+    pending.clear();
+    sizes.clear();
+    pendingBytes = 0;
+    return stored;
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,187 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_BOUNDEDPERSISTENCE_H
+#define WOLKABOUTCONNECTOR_BOUNDEDPERSISTENCE_H
+
+#include "core/persistence/Persistence.h"
+#include "wolk/persistence/BatchPersistence.h"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This enumeration describes what the `BoundedPersistence` does once the buffered readings reach the limit.
+ */
+enum class EvictionPolicy
+{
+    // The oldest buffered readings are dropped to make room for new ones.
+    DropOldest,
+    // While the buffer is full, only every Nth new reading of a feed is kept, and the oldest readings make room for it.
+    Downsample,
+    // Every feed can hold at most N readings, and drops its own oldest readings over that. The global limit is
+    // enforced by dropping the oldest readings.
+    PerFeedQuota
+};
+
+/**
+ * This is the structure holding the counters of readings that were dropped by the `BoundedPersistence`.
+ */
+struct EvictionCounters
+{
+    // The count and estimated size of all buffered readings that were dropped
+    std::uint64_t evictedReadings = 0;
+    std::uint64_t evictedBytes = 0;
+    // The count of new readings that were skipped because of downsampling
+    std::uint64_t downsampledReadings = 0;
+    // The count of buffered readings that were dropped because their feed was over the quota (also in evictedReadings)
+    std::uint64_t quotaEvictedReadings = 0;
+};
+
+/**
+ * This is a `Persistence` decorator that puts a limit on the count and estimated size of buffered readings, so a long
+ * outage can not exhaust the memory or the disk. Attributes and parameters are passed through as they are.
+ *
+ * All readings have to be written and removed through this object, as it keeps a small record (order and size) of
+ * every buffered reading to decide what to evict. The readings already in the wrapped persistence are counted when
+ * the object is created.
+ */
+class BoundedPersistence : public Persistence, public BatchPersistence
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param persistence The persistence that actually stores the data.
+     * @param policy The eviction policy.
+     * @param maxReadings The maximum count of buffered readings. 0 means unlimited.
+     * @param maxBytes The maximum estimated size of buffered readings (in bytes). 0 means unlimited.
+     * @param policyParameter For `Downsample`, every Nth reading is kept (default 2). For `PerFeedQuota`, the maximum
+     * count of readings of a single feed (default is no quota).
+     */
+    BoundedPersistence(std::unique_ptr<Persistence> persistence, EvictionPolicy policy, std::uint64_t maxReadings,
+                       std::uint64_t maxBytes = 0, std::uint64_t policyParameter = 0);
+
+    bool putReading(const std::string& key, const Reading& reading) override;
+    bool putReadings(const std::string& key, std::vector<Reading>&& readings) override;
+    bool visitReadings(const std::string& key, const std::function<void(const Reading&)>& visitor) override;
+    std::vector<std::shared_ptr<Reading>> getReadings(const std::string& key, std::uint_fast64_t count) override;
+    void removeReadings(const std::string& key, std::uint_fast64_t count) override;
+    std::vector<std::string> getReadingsKeys() override;
+
+    bool putAttribute(const std::string& key, std::shared_ptr<Attribute> attribute) override;
+    std::map<std::string, std::shared_ptr<Attribute>> getAttributes() override;
+    std::shared_ptr<Attribute> getAttributeUnderKey(const std::string& key) override;
+    void removeAttributes() override;
+    void removeAttributes(const std::string& key) override;
+    std::vector<std::string> getAttributeKeys() override;
+
+    bool putParameter(const std::string& key, Parameter parameter) override;
+    std::map<std::string, Parameter> getParameters() override;
+    Parameter getParameterForKey(const std::string& key) override;
+    void removeParameters() override;
+    void removeParameters(const std::string& key) override;
+    std::vector<std::string> getParameterKeys() override;
+
+    bool isEmpty() override;
+
+    /**
+     * This is a getter for the eviction counters.
+     *
+     * @return The counters since the object was created.
+     */
+    EvictionCounters getCounters();
+
+    /**
+     * This is a getter for the count of buffered readings.
+     *
+     * @return The count of readings.
+     */
+    std::uint64_t getBufferedReadings();
+
+    /**
+     * This is a getter for the estimated size of buffered readings.
+     *
+     * @return The size (in bytes).
+     */
+    std::uint64_t getBufferedBytes();
+
+    static const constexpr std::uint64_t DEFAULT_DOWNSAMPLE_FACTOR = 2;
+
+private:
+    // Here is what is known about a single buffered reading
+    struct Entry
+    {
+        std::uint64_t order;
+        std::uint64_t size;
+    };
+
+    bool isOverLimit(std::uint64_t incomingReadings, std::uint64_t incomingSize) const;
+
+    void track(const std::string& key, std::uint64_t size);
+
+    void untrack(const std::string& key, std::uint64_t count);
+
+    void evict(const std::string& key);
+
+    void evictOldest();
+
+    void removeEvicted();
+
+    bool storePending(const std::string& key, std::vector<Reading>& pending, std::vector<std::uint64_t>& sizes,
+                      std::uint64_t& pendingBytes);
+
+    std::unique_ptr<Persistence> m_persistence;
+    // Here is the wrapped persistence, if it can store many readings at once
+    BatchPersistence* m_batchPersistence;
+
+    // Here is the configuration
+    const EvictionPolicy m_policy;
+    const std::uint64_t m_maxReadings;
+    const std::uint64_t m_maxBytes;
+    const std::uint64_t m_policyParameter;
+
+    std::mutex m_mutex;
+
+    // Here are the buffered readings of every key, and the oldest reading of every key ordered by age
+    std::map<std::string, std::deque<Entry>> m_entries;
+    std::set<std::pair<std::uint64_t, std::string>> m_heads;
+    std::uint64_t m_nextOrder;
+    std::uint64_t m_readings;
+    std::uint64_t m_bytes;
+    // Here is the count of evicted readings of every key that are yet to be removed from the wrapped persistence
+    std::map<std::string, std::uint64_t> m_evicted;
+
+    // Here is the count of readings skipped for every key while downsampling
+    std::map<std::string, std::uint64_t> m_downsampling;
+
+    EvictionCounters m_counters;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_BOUNDEDPERSISTENCE_H
@@ -0,0 +1,1094 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/persistence/FilePersistence.h"
+
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wolkabout
+{
+namespace connect
+{
+namespace
+{
+const std::string SEGMENT_PREFIX = "segment-";
+const std::string SEGMENT_SUFFIX = ".log";
+const std::string STATE_FILE = "state.log";
+const std::string STATE_TEMPORARY_FILE = "state.log.tmp";
+
+// Frames are made of the payload size, the payload checksum and the payload
+const std::size_t FRAME_HEADER_SIZE = 2 * sizeof(std::uint32_t);
+const std::uint32_t MAX_FRAME_PAYLOAD_SIZE = 64 * 1024 * 1024;
+
+// The state journal is rewritten as a snapshot once it grows over this size
+const std::uint64_t STATE_SNAPSHOT_THRESHOLD = 1024 * 1024;
+
+// A sealed segment is compacted when less than a quarter of its readings are still live
+const std::uint64_t SPARSE_SEGMENT_RATIO = 4;
+
+enum class StateRecord : std::uint8_t
+{
+    ReadingsRemoved = 1,
+    AttributePut = 2,
+    AttributeRemoved = 3,
+    AttributesCleared = 4,
+    ParameterPut = 5,
+    ParameterRemoved = 6,
+    ParametersCleared = 7
+};
+
+std::uint32_t checksum(const char* data, std::size_t size)
+{
+    // FNV-1a
+    auto hash = std::uint32_t{2166136261u};
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<std::uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void appendU8(std::string& out, std::uint8_t value)
+{
+    out.push_back(static_cast<char>(value));
+}
+
+void appendU32(std::string& out, std::uint32_t value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendU64(std::string& out, std::uint64_t value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendString(std::string& out, const std::string& value)
+{
+    appendU32(out, static_cast<std::uint32_t>(value.size()));
+    out.append(value);
+}
+
+std::string makeFrame(const std::string& payload)
+{
+    auto frame = std::string{};
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    appendU32(frame, static_cast<std::uint32_t>(payload.size()));
+    appendU32(frame, checksum(payload.data(), payload.size()));
+    frame.append(payload);
+    return frame;
+}
+
+class PayloadReader
+{
+public:
+    PayloadReader(const char* data, std::size_t size) : m_data(data), m_size(size), m_position(0), m_valid(true) {}
+
+    std::uint8_t readU8()
+    {
+        auto value = std::uint8_t{0};
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    std::uint32_t readU32()
+    {
+        auto value = std::uint32_t{0};
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    std::uint64_t readU64()
+    {
+        auto value = std::uint64_t{0};
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    std::string readString()
+    {
+        const auto size = readU32();
+        if (!m_valid || size > m_size - m_position)
+        {
+            m_valid = false;
+            return {};
+        }
+        auto value = std::string{m_data + m_position, size};
+        m_position += size;
+        return value;
+    }
+
+    bool isValid() const { return m_valid; }
+
+private:
+    void read(void* destination, std::size_t size)
+    {
+        if (!m_valid || size > m_size - m_position)
+        {
+            m_valid = false;
+            return;
+        }
+        std::memcpy(destination, m_data + m_position, size);
+        m_position += size;
+    }
+
+    const char* m_data;
+    std::size_t m_size;
+    std::size_t m_position;
+    bool m_valid;
+};
+
+/**
+ * Walks over the frames in the buffer, and calls the callback for every valid one.
+ *
+ * @return The size of the valid part of the buffer. Everything after it is a torn or corrupted write.
+ */
+template <typename Callback> std::uint64_t scanFrames(const char* data, std::uint64_t size, Callback callback)
+{
+    auto offset = std::uint64_t{0};
+    while (size - offset >= FRAME_HEADER_SIZE)
+    {
+        auto payloadSize = std::uint32_t{0};
+        auto payloadChecksum = std::uint32_t{0};
+        std::memcpy(&payloadSize, data + offset, sizeof(payloadSize));
+        std::memcpy(&payloadChecksum, data + offset + sizeof(payloadSize), sizeof(payloadChecksum));
+        if (payloadSize > MAX_FRAME_PAYLOAD_SIZE || payloadSize > size - offset - FRAME_HEADER_SIZE)
+            break;
+        const auto payload = data + offset + FRAME_HEADER_SIZE;
+        if (checksum(payload, payloadSize) != payloadChecksum)
+            break;
+        callback(offset, payload, payloadSize);
+        offset += FRAME_HEADER_SIZE + payloadSize;
+    }
+    return offset;
+}
+
+bool writeFully(int fd, const char* data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const auto written = ::write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool createDirectories(const std::string& path)
+{
+    for (auto position = path.find('/', 1); ; position = path.find('/', position + 1))
+    {
+        const auto directory = path.substr(0, position);
+        if (!directory.empty() && ::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if (position == std::string::npos)
+            return true;
+    }
+}
+
+std::string serializeReading(std::uint64_t sequence, const std::string& key, const Reading& reading)
+{
+    auto payload = std::string{};
+    appendU64(payload, sequence);
+    appendString(payload, key);
+    appendString(payload, reading.getReference());
+    appendU64(payload, reading.getTimestamp());
+    appendU8(payload, reading.isMulti() ? 1 : 0);
+    const auto values =
+      reading.isMulti() ? reading.getStringValues() : std::vector<std::string>{reading.getStringValue()};
+    appendU32(payload, static_cast<std::uint32_t>(values.size()));
+    for (const auto& value : values)
+        appendString(payload, value);
+    return payload;
+}
+
+std::string serializeAttribute(const std::string& key, const Attribute& attribute)
+{
+    auto payload = std::string{};
+    appendU8(payload, static_cast<std::uint8_t>(StateRecord::AttributePut));
+    appendString(payload, key);
+    appendString(payload, attribute.getName());
+    appendU8(payload, static_cast<std::uint8_t>(attribute.getDataType()));
+    appendString(payload, attribute.getValue());
+    return payload;
+}
+
+std::string serializeParameter(const std::string& key, const Parameter& parameter)
+{
+    auto payload = std::string{};
+    appendU8(payload, static_cast<std::uint8_t>(StateRecord::ParameterPut));
+    appendString(payload, key);
+    appendU8(payload, static_cast<std::uint8_t>(parameter.first));
+    appendString(payload, parameter.second);
+    return payload;
+}
+
+std::string serializeKeyRecord(StateRecord type, const std::string& key)
+{
+    auto payload = std::string{};
+    appendU8(payload, static_cast<std::uint8_t>(type));
+    appendString(payload, key);
+    return payload;
+}
+
+std::string serializeWatermark(const std::string& key, std::uint64_t sequence)
+{
+    auto payload = serializeKeyRecord(StateRecord::ReadingsRemoved, key);
+    appendU64(payload, sequence);
+    return payload;
+}
+}    // namespace
+
+const constexpr std::uint64_t FilePersistence::DEFAULT_SEGMENT_SIZE;
+const constexpr std::uint64_t FilePersistence::DEFAULT_SYNC_BATCH_SIZE;
+const constexpr std::chrono::milliseconds FilePersistence::DEFAULT_SYNC_INTERVAL;
+
+/**
+ * This is a single file of the reading log. Writes are appended through the file descriptor, and reads go through a
+ * read-only mapping of the file, which is remapped when the file grew past it.
+ */
+class FilePersistence::Segment
+{
+public:
+    Segment(std::uint64_t id, std::string path)
+    : records(0), live(0), m_id(id), m_path(std::move(path)), m_fd(-1), m_size(0), m_mapping(nullptr), m_mappedSize(0)
+    {
+    }
+
+    ~Segment()
+    {
+        unmap();
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    bool open()
+    {
+        m_fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (m_fd < 0)
+            return false;
+        struct stat status
+        {
+        };
+        if (::fstat(m_fd, &status) != 0)
+            return false;
+        m_size = static_cast<std::uint64_t>(status.st_size);
+        return true;
+    }
+
+    bool append(const std::string& frame, std::uint64_t& offset)
+    {
+        offset = m_size;
+        if (!writeFully(m_fd, frame.data(), frame.size()))
+        {
+            // Don't leave a partial frame in the middle of the log
+            if (::ftruncate(m_fd, static_cast<off_t>(m_size)) != 0)
+                LOG(ERROR) << "Failed to truncate segment '" << m_path << "' -> '" << std::strerror(errno) << "'.";
+            return false;
+        }
+        m_size += frame.size();
+        return true;
+    }
+
+    const char* data()
+    {
+        if (m_mappedSize < m_size)
+        {
+            unmap();
+            auto mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                LOG(ERROR) << "Failed to map segment '" << m_path << "' -> '" << std::strerror(errno) << "'.";
+                return nullptr;
+            }
+            m_mapping = static_cast<const char*>(mapping);
+            m_mappedSize = m_size;
+        }
+        return m_mapping;
+    }
+
+    bool truncate(std::uint64_t size)
+    {
+        unmap();
+        if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+            return false;
+        m_size = size;
+        return true;
+    }
+
+    bool sync() { return ::fdatasync(m_fd) == 0; }
+
+    void remove()
+    {
+        unmap();
+        ::close(m_fd);
+        m_fd = -1;
+        if (::unlink(m_path.c_str()) != 0)
+            LOG(ERROR) << "Failed to delete segment '" << m_path << "' -> '" << std::strerror(errno) << "'.";
+    }
+
+    std::uint64_t getId() const { return m_id; }
+
+    std::uint64_t getSize() const { return m_size; }
+
+    // Here is the count of readings in the segment, and how many of them are not removed
+    std::uint64_t records;
+    std::uint64_t live;
+
+private:
+    void unmap()
+    {
+        if (m_mapping != nullptr)
+            ::munmap(const_cast<char*>(m_mapping), m_mappedSize);
+        m_mapping = nullptr;
+        m_mappedSize = 0;
+    }
+
+    std::uint64_t m_id;
+    std::string m_path;
+    int m_fd;
+    std::uint64_t m_size;
+    const char* m_mapping;
+    std::uint64_t m_mappedSize;
+};
+
+FilePersistence::FilePersistence(std::string directory, std::uint64_t segmentSize, std::uint64_t syncBatchSize,
+                                 std::chrono::milliseconds syncInterval)
+: m_directory(std::move(directory))
+, m_segmentSize(segmentSize)
+, m_syncBatchSize(syncBatchSize > 0 ? syncBatchSize : 1)
+, m_syncInterval(syncInterval)
+, m_open(false)
+, m_nextSequence(1)
+, m_stateFd(-1)
+, m_stateSize(0)
+, m_unsyncedRecords(0)
+, m_lastSync(std::chrono::steady_clock::now())
+, m_stopping(false)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_open = open();
+    if (!m_open)
+        LOG(ERROR) << "Failed to open file persistence in '" << m_directory << "'.";
+    // Every write is synced right away when the batch size is 1, so there is never anything for the timer to do
+    else if (m_syncBatchSize > 1 && m_syncInterval.count() > 0)
+        m_syncThread = std::thread{&FilePersistence::runSyncTimer, this};
+}
+
+FilePersistence::~FilePersistence()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stopping = true;
+    }
+    m_syncCondition.notify_one();
+    if (m_syncThread.joinable())
+        m_syncThread.join();
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_open)
+        syncLocked();
+    if (m_stateFd >= 0)
+        ::close(m_stateFd);
+}
+
+bool FilePersistence::putReading(const std::string& key, const Reading& reading)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (!m_open)
+        return false;
+
+    const auto sequence = m_nextSequence;
+    auto location = Location{0, 0, sequence};
+    if (!appendReadingFrame(makeFrame(serializeReading(sequence, key, reading)), location))
+    {
+        LOG(ERROR) << "Failed to persist reading -> '" << std::strerror(errno) << "'.";
+        return false;
+    }
+    ++m_nextSequence;
+    m_readings[key].emplace_back(location);
+    recordWritten();
+    return true;
+}
+
+bool FilePersistence::putReadings(const std::string& key, std::vector<Reading>&& readings)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (!m_open)
+        return false;
+
+    // The frames are collected into chunks that fit into a segment, and every chunk is written at once
+    auto chunk = std::string{};
+    auto pending = std::vector<Location>{};
+    const auto flush = [&]() -> bool {
+        if (pending.empty())
+            return true;
+        auto base = Location{0, 0, 0};
+        if (!appendReadingFrames(chunk, pending.size(), base))
+            return false;
+        auto& locations = m_readings[key];
+        for (const auto& location : pending)
+            locations.emplace_back(Location{base.segment, base.offset + location.offset, location.sequence});
+        m_nextSequence = pending.back().sequence + 1;
+        recordWritten(pending.size());
+        chunk.clear();
+        pending.clear();
+        return true;
+    };
+
+    for (const auto& reading : readings)
+    {
+        const auto sequence = m_nextSequence + pending.size();
+        const auto frame = makeFrame(serializeReading(sequence, key, reading));
+        if (!chunk.empty() && chunk.size() + frame.size() > m_segmentSize)
+        {
+            if (!flush())
+            {
+                LOG(ERROR) << "Failed to persist readings -> '" << std::strerror(errno) << "'.";
+                return false;
+            }
+        }
+        pending.emplace_back(Location{0, chunk.size(), sequence});
+        chunk += frame;
+    }
+    if (!flush())
+    {
+        LOG(ERROR) << "Failed to persist readings -> '" << std::strerror(errno) << "'.";
+        return false;
+    }
+    return true;
+}
+
+bool FilePersistence::visitReadings(const std::string& key, const std::function<void(const Reading&)>& visitor)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto it = m_readings.find(key);
+    if (it == m_readings.cend())
+        return true;
+
+    for (const auto& location : it->second)
+    {
+        const auto reading = readReading(location);
+        if (reading == nullptr)
+            break;
+        visitor(*reading);
+    }
+    return true;
+}
+
+std::vector<std::shared_ptr<Reading>> FilePersistence::getReadings(const std::string& key, std::uint_fast64_t count)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto readings = std::vector<std::shared_ptr<Reading>>{};
+    const auto it = m_readings.find(key);
+    if (it == m_readings.cend())
+        return readings;
+
+    const auto size = std::min<std::uint64_t>(count, it->second.size());
+    readings.reserve(size);
+    for (std::uint64_t i = 0; i < size; ++i)
+    {
+        auto reading = readReading(it->second[i]);
+        if (reading == nullptr)
+            break;
+        readings.emplace_back(std::move(reading));
+    }
+    return readings;
+}
+
+void FilePersistence::removeReadings(const std::string& key, std::uint_fast64_t count)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto it = m_readings.find(key);
+    if (it == m_readings.cend())
+        return;
+
+    auto& locations = it->second;
+    const auto size = std::min<std::uint64_t>(count, locations.size());
+    if (size == 0)
+        return;
+    const auto watermark = locations[size - 1].sequence;
+    for (std::uint64_t i = 0; i < size; ++i)
+    {
+        const auto segment = m_segments.find(locations.front().segment);
+        if (segment != m_segments.cend() && segment->second->live > 0)
+            --segment->second->live;
+        locations.pop_front();
+    }
+    if (locations.empty())
+        m_readings.erase(it);
+
+    m_removedUpTo[key] = watermark;
+    if (!appendState(serializeWatermark(key, watermark)))
+        LOG(ERROR) << "Failed to persist removal of readings -> '" << std::strerror(errno) << "'.";
+    compact();
+}
+
+std::vector<std::string> FilePersistence::getReadingsKeys()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto keys = std::vector<std::string>{};
+    keys.reserve(m_readings.size());
+    for (const auto& pair : m_readings)
+        keys.emplace_back(pair.first);
+    return keys;
+}
+
+bool FilePersistence::putAttribute(const std::string& key, std::shared_ptr<Attribute> attribute)
+{
+    if (attribute == nullptr)
+        return false;
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (!m_open || !appendState(serializeAttribute(key, *attribute)))
+        return false;
+    m_attributes[key] = std::move(attribute);
+    return true;
+}
+
+std::map<std::string, std::shared_ptr<Attribute>> FilePersistence::getAttributes()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_attributes;
+}
+
+std::shared_ptr<Attribute> FilePersistence::getAttributeUnderKey(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto it = m_attributes.find(key);
+    return it != m_attributes.cend() ? it->second : nullptr;
+}
+
+void FilePersistence::removeAttributes()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_attributes.clear();
+    appendState(serializeKeyRecord(StateRecord::AttributesCleared, {}));
+}
+
+void FilePersistence::removeAttributes(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_attributes.erase(key) > 0)
+        appendState(serializeKeyRecord(StateRecord::AttributeRemoved, key));
+}
+
+std::vector<std::string> FilePersistence::getAttributeKeys()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto keys = std::vector<std::string>{};
+    for (const auto& pair : m_attributes)
+        keys.emplace_back(pair.first);
+    return keys;
+}
+
+bool FilePersistence::putParameter(const std::string& key, Parameter parameter)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (!m_open || !appendState(serializeParameter(key, parameter)))
+        return false;
+    m_parameters[key] = std::move(parameter);
+    return true;
+}
+
+std::map<std::string, Parameter> FilePersistence::getParameters()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_parameters;
+}
+
+Parameter FilePersistence::getParameterForKey(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto it = m_parameters.find(key);
+    return it != m_parameters.cend() ? it->second : Parameter{};
+}
+
+void FilePersistence::removeParameters()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_parameters.clear();
+    appendState(serializeKeyRecord(StateRecord::ParametersCleared, {}));
+}
+
+void FilePersistence::removeParameters(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_parameters.erase(key) > 0)
+        appendState(serializeKeyRecord(StateRecord::ParameterRemoved, key));
+}
+
+std::vector<std::string> FilePersistence::getParameterKeys()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto keys = std::vector<std::string>{};
+    for (const auto& pair : m_parameters)
+        keys.emplace_back(pair.first);
+    return keys;
+}
+
+bool FilePersistence::isEmpty()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_readings.empty() && m_attributes.empty() && m_parameters.empty();
+}
+
+bool FilePersistence::isOpen() const
+{
+    return m_open;
+}
+
+void FilePersistence::sync()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_open)
+        syncLocked();
+}
+
+std::size_t FilePersistence::getSegmentCount()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_segments.size();
+}
+
+bool FilePersistence::open()
+{
+    if (m_directory.empty() || !createDirectories(m_directory))
+    {
+        LOG(ERROR) << "Failed to create directory '" << m_directory << "' -> '" << std::strerror(errno) << "'.";
+        return false;
+    }
+    // The state has to be loaded first, as it contains the removal watermarks that filter the readings
+    return openState() && openSegments();
+}
+
+bool FilePersistence::openState()
+{
+    // A leftover temporary file is a snapshot that was interrupted before replacing the journal, so it is dropped
+    const auto temporaryPath = m_directory + "/" + STATE_TEMPORARY_FILE;
+    ::unlink(temporaryPath.c_str());
+
+    m_stateFd = ::open(statePath().c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_stateFd < 0)
+        return false;
+
+    // The journal is small, so it is simply read into memory
+    auto content = std::string{};
+    char buffer[64 * 1024];
+    ssize_t bytes = 0;
+    while ((bytes = ::pread(m_stateFd, buffer, sizeof(buffer), static_cast<off_t>(content.size()))) > 0)
+        content.append(buffer, static_cast<std::size_t>(bytes));
+
+    m_stateSize = scanFrames(content.data(), content.size(),
+                             [&](std::uint64_t, const char* payload, std::uint32_t size) {
+                                 applyStateRecord(payload, size);
+                             });
+    if (m_stateSize != content.size())
+    {
+        LOG(WARN) << "Discarding a torn write at the end of '" << statePath() << "'.";
+        if (::ftruncate(m_stateFd, static_cast<off_t>(m_stateSize)) != 0)
+            return false;
+    }
+
+    // The segments holding the removed readings may already be deleted, so new readings have to be numbered after the
+    // watermarks. Otherwise they would be taken as removed the next time the log is opened.
+    for (const auto& pair : m_removedUpTo)
+        m_nextSequence = std::max(m_nextSequence, pair.second + 1);
+    return true;
+}
+
+bool FilePersistence::openSegments()
+{
+    // Find all the segments in the directory
+    auto ids = std::vector<std::uint64_t>{};
+    auto directory = ::opendir(m_directory.c_str());
+    if (directory == nullptr)
+        return false;
+    while (const auto entry = ::readdir(directory))
+    {
+        const auto name = std::string{entry->d_name};
+        if (name.size() <= SEGMENT_PREFIX.size() + SEGMENT_SUFFIX.size() || name.find(SEGMENT_PREFIX) != 0 ||
+            name.compare(name.size() - SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX) != 0)
+            continue;
+        const auto id = name.substr(SEGMENT_PREFIX.size(), name.size() - SEGMENT_PREFIX.size() - SEGMENT_SUFFIX.size());
+        if (id.find_first_not_of("0123456789") != std::string::npos)
+            continue;
+        ids.emplace_back(std::stoull(id));
+    }
+    ::closedir(directory);
+    std::sort(ids.begin(), ids.end());
+
+    // Load the readings that were not removed yet
+    for (const auto id : ids)
+    {
+        auto segment = std::unique_ptr<Segment>{new Segment{id, segmentPath(id)}};
+        if (!segment->open())
+            return false;
+
+        auto& current = *segment;
+        const auto data = current.getSize() > 0 ? current.data() : nullptr;
+        if (current.getSize() > 0 && data == nullptr)
+            return false;
+        const auto validSize =
+          scanFrames(data, current.getSize(), [&](std::uint64_t offset, const char* payload, std::uint32_t size) {
+              auto reader = PayloadReader{payload, size};
+              const auto sequence = reader.readU64();
+              const auto key = reader.readString();
+              if (!reader.isValid())
+                  return;
+              ++current.records;
+              m_nextSequence = std::max(m_nextSequence, sequence + 1);
+              const auto removed = m_removedUpTo.find(key);
+              if (removed != m_removedUpTo.cend() && sequence <= removed->second)
+                  return;
+              ++current.live;
+              m_readings[key].emplace_back(Location{id, offset, sequence});
+          });
+        if (validSize != current.getSize())
+        {
+            LOG(WARN) << "Discarding a torn write at the end of '" << segmentPath(id) << "'.";
+            if (!current.truncate(validSize))
+                return false;
+        }
+        m_segments.emplace(id, std::move(segment));
+    }
+
+    // Segments were read in the order of their ids, but a compaction can move older readings into a newer segment.
+    // If a compaction was interrupted, a reading can also be found in both segments, so only one copy is kept.
+    for (auto& pair : m_readings)
+    {
+        auto& locations = pair.second;
+        std::stable_sort(locations.begin(), locations.end(),
+                         [](const Location& left, const Location& right) { return left.sequence < right.sequence; });
+        auto unique = std::deque<Location>{};
+        for (const auto& location : locations)
+        {
+            if (!unique.empty() && unique.back().sequence == location.sequence)
+            {
+                --m_segments[location.segment]->live;
+                continue;
+            }
+            unique.emplace_back(location);
+        }
+        locations.swap(unique);
+    }
+
+    compact();
+    return activeSegment() != nullptr;
+}
+
+void FilePersistence::applyStateRecord(const char* payload, std::uint32_t size)
+{
+    auto reader = PayloadReader{payload, size};
+    const auto type = static_cast<StateRecord>(reader.readU8());
+    const auto key = reader.readString();
+    switch (type)
+    {
+    case StateRecord::ReadingsRemoved:
+    {
+        const auto sequence = reader.readU64();
+        if (reader.isValid())
+            m_removedUpTo[key] = std::max(m_removedUpTo[key], sequence);
+        break;
+    }
+    case StateRecord::AttributePut:
+    {
+        auto name = reader.readString();
+        const auto dataType = static_cast<DataType>(reader.readU8());
+        auto value = reader.readString();
+        if (reader.isValid())
+            m_attributes[key] = std::make_shared<Attribute>(std::move(name), dataType, std::move(value));
+        break;
+    }
+    case StateRecord::AttributeRemoved:
+        m_attributes.erase(key);
+        break;
+    case StateRecord::AttributesCleared:
+        m_attributes.clear();
+        break;
+    case StateRecord::ParameterPut:
+    {
+        const auto name = static_cast<ParameterName>(reader.readU8());
+        auto value = reader.readString();
+        if (reader.isValid())
+            m_parameters[key] = Parameter{name, std::move(value)};
+        break;
+    }
+    case StateRecord::ParameterRemoved:
+        m_parameters.erase(key);
+        break;
+    case StateRecord::ParametersCleared:
+        m_parameters.clear();
+        break;
+    default:
+        LOG(WARN) << "Ignoring an unknown record in '" << statePath() << "'.";
+        break;
+    }
+}
+
+bool FilePersistence::appendState(const std::string& payload)
+{
+    if (m_stateFd < 0)
+        return false;
+
+    const auto frame = makeFrame(payload);
+    if (!writeFully(m_stateFd, frame.data(), frame.size()))
+    {
+        if (::ftruncate(m_stateFd, static_cast<off_t>(m_stateSize)) != 0)
+            LOG(ERROR) << "Failed to truncate the state journal -> '" << std::strerror(errno) << "'.";
+        return false;
+    }
+    m_stateSize += frame.size();
+    recordWritten();
+
+    if (m_stateSize > STATE_SNAPSHOT_THRESHOLD && !rewriteState())
+        LOG(ERROR) << "Failed to write a snapshot of the state -> '" << std::strerror(errno) << "'.";
+    return true;
+}
+
+bool FilePersistence::rewriteState()
+{
+    // Write the whole current state into a temporary file, and atomically replace the journal with it
+    auto content = std::string{};
+    for (const auto& pair : m_removedUpTo)
+        content += makeFrame(serializeWatermark(pair.first, pair.second));
+    for (const auto& pair : m_attributes)
+        content += makeFrame(serializeAttribute(pair.first, *pair.second));
+    for (const auto& pair : m_parameters)
+        content += makeFrame(serializeParameter(pair.first, pair.second));
+
+    const auto temporaryPath = m_directory + "/" + STATE_TEMPORARY_FILE;
+    const auto fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+    if (!writeFully(fd, content.data(), content.size()) || ::fsync(fd) != 0)
+    {
+        ::close(fd);
+        ::unlink(temporaryPath.c_str());
+        return false;
+    }
+    ::close(fd);
+    if (::rename(temporaryPath.c_str(), statePath().c_str()) != 0)
+        return false;
+
+    ::close(m_stateFd);
+    m_stateFd = ::open(statePath().c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+    m_stateSize = content.size();
+    return m_stateFd >= 0;
+}
+
+bool FilePersistence::appendReadingFrame(const std::string& frame, Location& location)
+{
+    return appendReadingFrames(frame, 1, location);
+}
+
+bool FilePersistence::appendReadingFrames(const std::string& frames, std::uint64_t count, Location& location)
+{
+    auto segment = activeSegment();
+    if (segment == nullptr)
+        return false;
+
+    // Seal the active segment if the frames don't fit in it anymore
+    if (segment->getSize() > 0 && segment->getSize() + frames.size() > m_segmentSize)
+    {
+        if (!segment->sync())
+            LOG(ERROR) << "Failed to sync segment -> '" << std::strerror(errno) << "'.";
+        const auto id = segment->getId() + 1;
+        auto next = std::unique_ptr<Segment>{new Segment{id, segmentPath(id)}};
+        if (!next->open())
+            return false;
+        segment = next.get();
+        m_segments.emplace(id, std::move(next));
+    }
+
+    auto offset = std::uint64_t{0};
+    if (!segment->append(frames, offset))
+        return false;
+    segment->records += count;
+    segment->live += count;
+    location.segment = segment->getId();
+    location.offset = offset;
+    return true;
+}
+
+FilePersistence::Segment* FilePersistence::activeSegment()
+{
+    if (m_segments.empty())
+    {
+        auto segment = std::unique_ptr<Segment>{new Segment{0, segmentPath(0)}};
+        if (!segment->open())
+            return nullptr;
+        m_segments.emplace(0, std::move(segment));
+    }
+    return m_segments.rbegin()->second.get();
+}
+
+std::shared_ptr<Reading> FilePersistence::readReading(const Location& location)
+{
+    const auto it = m_segments.find(location.segment);
+    if (it == m_segments.cend())
+        return nullptr;
+    auto& segment = *it->second;
+    const auto data = segment.data();
+    if (data == nullptr || location.offset + FRAME_HEADER_SIZE > segment.getSize())
+        return nullptr;
+
+    auto payloadSize = std::uint32_t{0};
+    std::memcpy(&payloadSize, data + location.offset, sizeof(payloadSize));
+    auto reader = PayloadReader{data + location.offset + FRAME_HEADER_SIZE, payloadSize};
+    reader.readU64();
+    reader.readString();
+    auto reference = reader.readString();
+    const auto timestamp = reader.readU64();
+    const auto multi = reader.readU8() != 0;
+    const auto count = reader.readU32();
+    auto values = std::vector<std::string>{};
+    for (std::uint32_t i = 0; i < count && reader.isValid(); ++i)
+        values.emplace_back(reader.readString());
+    if (!reader.isValid() || (!multi && values.size() != 1))
+    {
+        LOG(ERROR) << "Failed to read a reading from segment '" << segmentPath(location.segment) << "'.";
+        return nullptr;
+    }
+
+    if (multi)
+        return std::make_shared<Reading>(std::move(reference), std::move(values), timestamp);
+    return std::make_shared<Reading>(std::move(reference), std::move(values.front()), timestamp);
+}
+
+void FilePersistence::compact()
+{
+    if (m_segments.empty())
+        return;
+
+    const auto activeId = m_segments.rbegin()->first;
+    auto sealed = std::vector<std::uint64_t>{};
+    for (const auto& pair : m_segments)
+        if (pair.first != activeId)
+            sealed.emplace_back(pair.first);
+
+    for (const auto id : sealed)
+    {
+        auto& segment = *m_segments[id];
+        if (segment.live > 0 && segment.live * SPARSE_SEGMENT_RATIO < segment.records)
+            relocate(segment);
+        if (segment.live == 0)
+        {
+            // The relocated readings have to be on disk before the segment they came from is gone
+            syncLocked();
+            segment.remove();
+            m_segments.erase(id);
+        }
+    }
+}
+
+void FilePersistence::relocate(Segment& segment)
+{
+    // Copy the live frames to the end of the log, and point the index to them
+    for (auto& pair : m_readings)
+    {
+        for (auto& location : pair.second)
+        {
+            if (location.segment != segment.getId())
+                continue;
+            const auto data = segment.data();
+            if (data == nullptr)
+                return;
+            auto payloadSize = std::uint32_t{0};
+            std::memcpy(&payloadSize, data + location.offset, sizeof(payloadSize));
+            const auto frame = std::string{data + location.offset, FRAME_HEADER_SIZE + payloadSize};
+            auto relocated = location;
+            if (!appendReadingFrame(frame, relocated))
+            {
+                LOG(ERROR) << "Failed to compact segment '" << segmentPath(segment.getId()) << "'.";
+                return;
+            }
+            location = relocated;
+            --segment.live;
+        }
+    }
+}
+
+void FilePersistence::recordWritten(std::uint64_t count)
+{
+    const auto waiting = m_unsyncedRecords > 0;
+    m_unsyncedRecords += count;
+    if (m_unsyncedRecords >= m_syncBatchSize || std::chrono::steady_clock::now() - m_lastSync >= m_syncInterval)
+        syncLocked();
+    else if (!waiting)
+        m_syncCondition.notify_one();
+}
+
+void FilePersistence::syncLocked()
+{
+    if (!m_segments.empty() && !m_segments.rbegin()->second->sync())
+        LOG(ERROR) << "Failed to sync the active segment -> '" << std::strerror(errno) << "'.";
+    if (m_stateFd >= 0 && ::fdatasync(m_stateFd) != 0)
+        LOG(ERROR) << "Failed to sync the state journal -> '" << std::strerror(errno) << "'.";
+    m_unsyncedRecords = 0;
+    m_lastSync = std::chrono::steady_clock::now();
+}
+
+void FilePersistence::runSyncTimer()
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+    while (!m_stopping)
+    {
+        if (m_unsyncedRecords == 0)
+        {
+            m_syncCondition.wait(lock);
+            continue;
+        }
+
+        // The records are synced by a write in the meantime as well, which moves the deadline
+        const auto deadline = m_lastSync + m_syncInterval;
+        if (std::chrono::steady_clock::now() >= deadline)
+            syncLocked();
+        else
+            m_syncCondition.wait_until(lock, deadline);
+    }
+}
+
+std::string FilePersistence::segmentPath(std::uint64_t id) const
+{
+    return m_directory + "/" + SEGMENT_PREFIX + std::to_string(id) + SEGMENT_SUFFIX;
+}
+
+std::string FilePersistence::statePath() const
+{
+    return m_directory + "/" + STATE_FILE;
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,202 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_FILEPERSISTENCE_H
+#define WOLKABOUTCONNECTOR_FILEPERSISTENCE_H
+
+#include "core/persistence/Persistence.h"
+#include "wolk/persistence/BatchPersistence.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This is a durable `Persistence` implementation that keeps everything in a directory on disk, so the buffered data
+ * survives restarts and power cuts.
+ *
+ * Readings are appended to a segmented log (`segment-<id>.log`). Every record carries a checksum, so a torn write at
+ * the end of a segment is detected and cut off when the log is opened again. Readings are read back through a memory
+ * mapping of the segment. `removeReadings` only appends a removal watermark to the state journal. Once all readings of
+ * a segment are removed the segment file is deleted, and sparse segments are compacted by moving their remaining
+ * readings to the end of the log.
+ *
+ * Attributes, parameters and the removal watermarks are kept in a journal (`state.log`), which is periodically
+ * rewritten as a snapshot of the current state.
+ *
+ * Appends are synced to disk in batches, either when a count of records was written or when the sync interval has
+ * passed, whichever comes first. A background thread syncs the records that are still waiting once the interval
+ * passes, so they are not left unsynced when no more writes come. The files are written in the byte order of the host.
+ */
+class FilePersistence : public Persistence, public BatchPersistence
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param directory The directory in which the files will be kept. It is created if it doesn't exist.
+     * @param segmentSize The size of a log segment (in bytes) after which a new segment is started.
+     * @param syncBatchSize The count of written records after which the files are synced to disk. 1 syncs every write.
+     * @param syncInterval The maximum time written records are allowed to wait to be synced to disk.
+     */
+    explicit FilePersistence(std::string directory, std::uint64_t segmentSize = DEFAULT_SEGMENT_SIZE,
+                             std::uint64_t syncBatchSize = DEFAULT_SYNC_BATCH_SIZE,
+                             std::chrono::milliseconds syncInterval = DEFAULT_SYNC_INTERVAL);
+
+    ~FilePersistence() override;
+
+    FilePersistence(const FilePersistence&) = delete;
+    FilePersistence& operator=(const FilePersistence&) = delete;
+
+    bool putReading(const std::string& key, const Reading& reading) override;
+    bool putReadings(const std::string& key, std::vector<Reading>&& readings) override;
+    bool visitReadings(const std::string& key, const std::function<void(const Reading&)>& visitor) override;
+    std::vector<std::shared_ptr<Reading>> getReadings(const std::string& key, std::uint_fast64_t count) override;
+    void removeReadings(const std::string& key, std::uint_fast64_t count) override;
+    std::vector<std::string> getReadingsKeys() override;
+
+    bool putAttribute(const std::string& key, std::shared_ptr<Attribute> attribute) override;
+    std::map<std::string, std::shared_ptr<Attribute>> getAttributes() override;
+    std::shared_ptr<Attribute> getAttributeUnderKey(const std::string& key) override;
+    void removeAttributes() override;
+    void removeAttributes(const std::string& key) override;
+    std::vector<std::string> getAttributeKeys() override;
+
+    bool putParameter(const std::string& key, Parameter parameter) override;
+    std::map<std::string, Parameter> getParameters() override;
+    Parameter getParameterForKey(const std::string& key) override;
+    void removeParameters() override;
+    void removeParameters(const std::string& key) override;
+    std::vector<std::string> getParameterKeys() override;
+
+    bool isEmpty() override;
+
+    /**
+     * This method is used to check whether the directory was opened successfully. If it wasn't, every `put` will fail.
+     *
+     * @return Whether the persistence is usable.
+     */
+    bool isOpen() const;
+
+    /**
+     * This method syncs all written records to disk, regardless of the batching configuration.
+     */
+    void sync();
+
+    /**
+     * This is a getter for the count of log segments that are currently on disk.
+     *
+     * @return The count of segments.
+     */
+    std::size_t getSegmentCount();
+
+    static const constexpr std::uint64_t DEFAULT_SEGMENT_SIZE = 16 * 1024 * 1024;
+    static const constexpr std::uint64_t DEFAULT_SYNC_BATCH_SIZE = 256;
+    static const constexpr std::chrono::milliseconds DEFAULT_SYNC_INTERVAL = std::chrono::milliseconds{1000};
+
+private:
+    class Segment;
+
+    // Here is where a single reading can be found in the log
+    struct Location
+    {
+        std::uint64_t segment;
+        std::uint64_t offset;
+        std::uint64_t sequence;
+    };
+
+    bool open();
+
+    bool openState();
+
+    bool openSegments();
+
+    void applyStateRecord(const char* payload, std::uint32_t size);
+
+    bool appendState(const std::string& payload);
+
+    bool rewriteState();
+
+    bool appendReadingFrame(const std::string& frame, Location& location);
+
+    bool appendReadingFrames(const std::string& frames, std::uint64_t count, Location& location);
+
+    Segment* activeSegment();
+
+    std::shared_ptr<Reading> readReading(const Location& location);
+
+    void compact();
+
+    void relocate(Segment& segment);
+
+    void recordWritten(std::uint64_t count = 1);
+
+    void syncLocked();
+
+    void runSyncTimer();
+
+    std::string segmentPath(std::uint64_t id) const;
+
+    std::string statePath() const;
+
+    // Here is the configuration
+    const std::string m_directory;
+    const std::uint64_t m_segmentSize;
+    const std::uint64_t m_syncBatchSize;
+    const std::chrono::milliseconds m_syncInterval;
+
+    std::mutex m_mutex;
+    bool m_open;
+
+    // Here are the log segments, ordered by their id. The last one is the one new readings are appended to.
+    std::map<std::uint64_t, std::unique_ptr<Segment>> m_segments;
+    std::uint64_t m_nextSequence;
+
+    // Here is the index of live readings for every key, and the sequence up to which the readings were removed
+    std::map<std::string, std::deque<Location>> m_readings;
+    std::map<std::string, std::uint64_t> m_removedUpTo;
+
+    // Here are the attributes and parameters, as they were last written to the state journal
+    std::map<std::string, std::shared_ptr<Attribute>> m_attributes;
+    std::map<std::string, Parameter> m_parameters;
+
+    int m_stateFd;
+    std::uint64_t m_stateSize;
+
+    // Here is the information used for batching the syncs
+    std::uint64_t m_unsyncedRecords;
+    std::chrono::steady_clock::time_point m_lastSync;
+
+    // Here is the thread that syncs the waiting records once the interval passes
+    bool m_stopping;
+    std::condition_variable m_syncCondition;
+    std::thread m_syncThread;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_FILEPERSISTENCE_H
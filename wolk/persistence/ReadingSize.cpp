@@ -0,0 +1,42 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/persistence/ReadingSize.h"
+
+namespace wolkabout
+{
+namespace connect
+{
+namespace
+{
+// The size of everything in the message that belongs to a reading, apart from its reference and values
+const std::uint64_t READING_OVERHEAD_SIZE = 32;
+}    // namespace
+
+std::uint64_t estimateReadingSize(const Reading& reading)
+{
+    auto size = READING_OVERHEAD_SIZE + reading.getReference().size();
+    if (reading.isMulti())
+    {
+        for (const auto& value : reading.getStringValues())
+            size += value.size();
+    }
+    else
+        size += reading.getStringValue().size();
+    return size;
+}
+}    // namespace connect
+}    // namespace wolkabout
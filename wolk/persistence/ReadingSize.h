@@ -0,0 +1,39 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_READINGSIZE_H
+#define WOLKABOUTCONNECTOR_READINGSIZE_H
+
+#include "core/model/Reading.h"
+
+#include <cstdint>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This function estimates how many bytes a reading takes up in an outgoing message. The same estimate is used to
+ * limit the buffered readings, to trigger the publishing of readings, and to fill up a batch of readings.
+ *
+ * @param reading The reading.
+ * @return The estimated size (in bytes).
+ */
+std::uint64_t estimateReadingSize(const Reading& reading);
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_READINGSIZE_H
@@ -0,0 +1,98 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/protocol/CompressedDataProtocol.h"
+
+#include "core/model/Message.h"
+#include "core/utilities/Logger.h"
+
+#include <zlib.h>
+
+#include <limits>
+
+namespace wolkabout
+{
+namespace connect
+{
+const constexpr std::uint64_t CompressedDataProtocol::DEFAULT_MINIMUM_SIZE;
+const constexpr char* CompressedDataProtocol::COMPRESSED_CHANNEL_SUFFIX;
+
+CompressedDataProtocol::CompressedDataProtocol(std::uint64_t minimumSize, int level)
+: m_minimumSize{minimumSize}, m_level{level}
+{
+}
+
+std::unique_ptr<Message> CompressedDataProtocol::makeOutboundMessage(const std::string& deviceKey,
+                                                                     FeedValuesMessage message)
+{
+    auto outbound = WolkaboutDataProtocol::makeOutboundMessage(deviceKey, std::move(message));
+    if (outbound == nullptr || outbound->getContent().size() < m_minimumSize)
+        return outbound;
+
+    auto compressed = std::string{};
+    if (!compress(outbound->getContent(), compressed, m_level))
+    {
+        LOG(WARN) << "Failed to compress the outgoing 'FeedValuesMessage' - Sending it uncompressed.";
+        return outbound;
+    }
+    return std::unique_ptr<Message>{
+      new Message{std::move(compressed), outbound->getChannel() + COMPRESSED_CHANNEL_SUFFIX}};
+}
+
+bool CompressedDataProtocol::compress(const std::string& data, std::string& compressed, int level)
+{
+    if (data.size() > std::numeric_limits<uLong>::max())
+        return false;
+
+    auto size = compressBound(static_cast<uLong>(data.size()));
+    compressed.resize(size);
+    const auto result = compress2(reinterpret_cast<Bytef*>(&compressed[0]), &size,
+                                  reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size()), level);
+    if (result != Z_OK)
+        return false;
+    compressed.resize(size);
+    return true;
+}
+
+bool CompressedDataProtocol::decompress(const std::string& compressed, std::string& data)
+{
+    if (compressed.size() > std::numeric_limits<uInt>::max())
+        return false;
+
+    auto stream = z_stream{};
+    if (inflateInit(&stream) != Z_OK)
+        return false;
+
+    // The data is inflated in chunks, as the compressed data does not hold its original size
+    const auto chunkSize = std::size_t{4096};
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    data.clear();
+    auto result = Z_OK;
+    while (result == Z_OK)
+    {
+        const auto offset = data.size();
+        data.resize(offset + chunkSize);
+        stream.next_out = reinterpret_cast<Bytef*>(&data[offset]);
+        stream.avail_out = static_cast<uInt>(chunkSize);
+        result = inflate(&stream, Z_NO_FLUSH);
+        data.resize(offset + chunkSize - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,88 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_COMPRESSEDDATAPROTOCOL_H
+#define WOLKABOUTCONNECTOR_COMPRESSEDDATAPROTOCOL_H
+
+#include "core/protocol/wolkabout/WolkaboutDataProtocol.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This is a `WolkaboutDataProtocol` that compresses the payload of outgoing feed values messages with zlib (deflate),
+ * as their JSON repeats the same references and timestamp keys for every reading. Everything else is left as is.
+ *
+ * A compressed payload is always sent on the feed values channel with `COMPRESSED_CHANNEL_SUFFIX` appended, and only
+ * a compressed payload is sent there. Payloads smaller than the minimum size, and ones that fail to compress, are
+ * sent as plain JSON on the usual channel, exactly as `WolkaboutDataProtocol` sends them. A receiver should inflate
+ * everything that arrives on the suffixed channel, and can treat the rest as usual.
+ *
+ * This protocol is opt-in (`WolkBuilder::withDataProtocol`), and should only be used with a platform/broker that is
+ * set up to inflate the payloads.
+ */
+class CompressedDataProtocol : public WolkaboutDataProtocol
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param minimumSize The payloads smaller than this (in bytes) are sent uncompressed, as it is not worth it.
+     * @param level The zlib compression level, from 1 (fastest) to 9 (smallest), or -1 for the zlib default.
+     */
+    explicit CompressedDataProtocol(std::uint64_t minimumSize = DEFAULT_MINIMUM_SIZE, int level = -1);
+
+    using WolkaboutDataProtocol::makeOutboundMessage;
+
+    std::unique_ptr<Message> makeOutboundMessage(const std::string& deviceKey, FeedValuesMessage message) override;
+
+    /**
+     * This method compresses the data into the zlib format.
+     *
+     * @param data The data.
+     * @param compressed The string into which the compressed data is written.
+     * @param level The compression level.
+     * @return Whether the data was compressed.
+     */
+    static bool compress(const std::string& data, std::string& compressed, int level = -1);
+
+    /**
+     * This method decompresses data in the zlib format.
+     *
+     * @param compressed The compressed data.
+     * @param data The string into which the data is written.
+     * @return Whether the data was decompressed.
+     */
+    static bool decompress(const std::string& compressed, std::string& data);
+
+    static const constexpr std::uint64_t DEFAULT_MINIMUM_SIZE = 256;
+
+    // Here is what is appended to the channel of a message whose payload is compressed
+    static const constexpr char* COMPRESSED_CHANNEL_SUFFIX = "/zlib";
+
+private:
+    const std::uint64_t m_minimumSize;
+    const int m_level;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_COMPRESSEDDATAPROTOCOL_H
@@ -0,0 +1,396 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/protocol/MessagePack.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+// Here is the deepest nesting of arrays and maps that is decoded, to keep the recursion bounded
+const std::uint32_t MAX_DEPTH = 64;
+
+bool isInteger(const std::string& value)
+{
+    const auto start = std::size_t{!value.empty() && value.front() == '-' ? 1u : 0u};
+    if (value.size() == start || (value[start] == '0' && value.size() > start + 1) || value == "-0")
+        return false;
+    for (auto i = start; i < value.size(); ++i)
+        if (value[i] < '0' || value[i] > '9')
+            return false;
+    return true;
+}
+
+bool isDecimal(const std::string& value)
+{
+    if (value.empty() || value.find_first_not_of("0123456789+-.eE") != std::string::npos)
+        return false;
+    // Leading zeroes would not be written back
+    const auto start = std::size_t{value.front() == '-' ? 1u : 0u};
+    if (value.size() > start + 1 && value[start] == '0' && value[start + 1] >= '0' && value[start + 1] <= '9')
+        return false;
+    return value.find_first_of("0123456789") != std::string::npos;
+}
+}    // namespace
+
+namespace wolkabout
+{
+namespace connect
+{
+void MessagePackWriter::writeNil()
+{
+    m_buffer.push_back(static_cast<char>(0xc0));
+}
+
+void MessagePackWriter::writeBool(bool value)
+{
+    m_buffer.push_back(static_cast<char>(value ? 0xc3 : 0xc2));
+}
+
+void MessagePackWriter::writeInt(std::int64_t value)
+{
+    if (value >= 0)
+        return writeUInt(static_cast<std::uint64_t>(value));
+
+    if (value >= -32)
+        m_buffer.push_back(static_cast<char>(static_cast<std::uint8_t>(value)));
+    else if (value >= std::numeric_limits<std::int8_t>::min())
+    {
+        m_buffer.push_back(static_cast<char>(0xd0));
+        writeBigEndian(static_cast<std::uint8_t>(value), 1);
+    }
+    else if (value >= std::numeric_limits<std::int16_t>::min())
+    {
+        m_buffer.push_back(static_cast<char>(0xd1));
+        writeBigEndian(static_cast<std::uint16_t>(value), 2);
+    }
+    else if (value >= std::numeric_limits<std::int32_t>::min())
+    {
+        m_buffer.push_back(static_cast<char>(0xd2));
+        writeBigEndian(static_cast<std::uint32_t>(value), 4);
+    }
+    else
+    {
+        m_buffer.push_back(static_cast<char>(0xd3));
+        writeBigEndian(static_cast<std::uint64_t>(value), 8);
+    }
+}
+
+void MessagePackWriter::writeUInt(std::uint64_t value)
+{
+    if (value < 0x80)
+        m_buffer.push_back(static_cast<char>(value));
+    else if (value <= std::numeric_limits<std::uint8_t>::max())
+    {
+        m_buffer.push_back(static_cast<char>(0xcc));
+        writeBigEndian(value, 1);
+    }
+    else if (value <= std::numeric_limits<std::uint16_t>::max())
+    {
+        m_buffer.push_back(static_cast<char>(0xcd));
+        writeBigEndian(value, 2);
+    }
+    else if (value <= std::numeric_limits<std::uint32_t>::max())
+    {
+        m_buffer.push_back(static_cast<char>(0xce));
+        writeBigEndian(value, 4);
+    }
+    else
+    {
+        m_buffer.push_back(static_cast<char>(0xcf));
+        writeBigEndian(value, 8);
+    }
+}
+
+void MessagePackWriter::writeDouble(double value)
+{
+    auto bits = std::uint64_t{0};
+    static_assert(sizeof(bits) == sizeof(value), "The double type must be 64 bits wide.");
+    std::memcpy(&bits, &value, sizeof(bits));
+    m_buffer.push_back(static_cast<char>(0xcb));
+    writeBigEndian(bits, 8);
+}
+
+void MessagePackWriter::writeString(const std::string& value)
+{
+    const auto size = value.size();
+    if (size < 32)
+        m_buffer.push_back(static_cast<char>(0xa0 | size));
+    else if (size <= std::numeric_limits<std::uint8_t>::max())
+    {
+        m_buffer.push_back(static_cast<char>(0xd9));
+        writeBigEndian(size, 1);
+    }
+    else if (size <= std::numeric_limits<std::uint16_t>::max())
+    {
+        m_buffer.push_back(static_cast<char>(0xda));
+        writeBigEndian(size, 2);
+    }
+    else
+    {
+        m_buffer.push_back(static_cast<char>(0xdb));
+        writeBigEndian(size, 4);
+    }
+    m_buffer.append(value);
+}
+
+void MessagePackWriter::writeArrayHeader(std::uint32_t size)
+{
+    if (size < 16)
+        m_buffer.push_back(static_cast<char>(0x90 | size));
+    else if (size <= std::numeric_limits<std::uint16_t>::max())
+    {
+        m_buffer.push_back(static_cast<char>(0xdc));
+        writeBigEndian(size, 2);
+    }
+    else
+    {
+        m_buffer.push_back(static_cast<char>(0xdd));
+        writeBigEndian(size, 4);
+    }
+}
+
+void MessagePackWriter::writeMapHeader(std::uint32_t size)
+{
+    if (size < 16)
+        m_buffer.push_back(static_cast<char>(0x80 | size));
+    else if (size <= std::numeric_limits<std::uint16_t>::max())
+    {
+        m_buffer.push_back(static_cast<char>(0xde));
+        writeBigEndian(size, 2);
+    }
+    else
+    {
+        m_buffer.push_back(static_cast<char>(0xdf));
+        writeBigEndian(size, 4);
+    }
+}
+
+void MessagePackWriter::writeValue(const std::string& value, DataType dataType)
+{
+    if (dataType == DataType::BOOLEAN && (value == "true" || value == "false"))
+        return writeBool(value == "true");
+    if (dataType != DataType::NUMERIC)
+        return writeString(value);
+
+    if (isInteger(value))
+    {
+        errno = 0;
+        if (value.front() == '-')
+        {
+            const auto number = std::strtoll(value.c_str(), nullptr, 10);
+            if (errno == 0)
+                return writeInt(number);
+        }
+        else
+        {
+            const auto number = std::strtoull(value.c_str(), nullptr, 10);
+            if (errno == 0)
+                return writeUInt(number);
+        }
+    }
+    else if (isDecimal(value))
+    {
+        char* end = nullptr;
+        const auto number = std::strtod(value.c_str(), &end);
+        if (end == value.c_str() + value.size() && std::isfinite(number))
+            return writeDouble(number);
+    }
+    writeString(value);
+}
+
+const std::string& MessagePackWriter::getBuffer() const
+{
+    return m_buffer;
+}
+
+std::string MessagePackWriter::release()
+{
+    auto buffer = std::string{};
+    buffer.swap(m_buffer);
+    return buffer;
+}
+
+void MessagePackWriter::writeBigEndian(std::uint64_t value, std::uint8_t bytes)
+{
+    for (auto shift = static_cast<int>(bytes - 1) * 8; shift >= 0; shift -= 8)
+        m_buffer.push_back(static_cast<char>((value >> shift) & 0xff));
+}
+
+const MessagePackValue* MessagePackValue::find(const std::string& key) const
+{
+    if (type != Type::Map)
+        return nullptr;
+    for (const auto& pair : mapValue)
+        if (pair.first.type == Type::String && pair.first.stringValue == key)
+            return &pair.second;
+    return nullptr;
+}
+
+bool MessagePackReader::read(const std::string& data, MessagePackValue& value)
+{
+    auto reader = MessagePackReader{data};
+    return reader.readValue(value, 0) && reader.m_position == data.size();
+}
+
+MessagePackReader::MessagePackReader(const std::string& data) : m_data(data), m_position(0) {}
+
+bool MessagePackReader::readValue(MessagePackValue& value, std::uint32_t depth)
+{
+    if (m_position >= m_data.size() || depth > MAX_DEPTH)
+        return false;
+
+    value = MessagePackValue{};
+    const auto marker = static_cast<std::uint8_t>(m_data[m_position++]);
+    if (marker < 0x80)
+    {
+        value.type = MessagePackValue::Type::UInt;
+        value.uintValue = marker;
+        return true;
+    }
+    if (marker >= 0xe0)
+    {
+        value.type = MessagePackValue::Type::Int;
+        value.intValue = static_cast<std::int8_t>(marker);
+        return true;
+    }
+    if ((marker & 0xf0) == 0x80)
+        return readMap(marker & 0x0f, value, depth);
+    if ((marker & 0xf0) == 0x90)
+        return readArray(marker & 0x0f, value, depth);
+    if ((marker & 0xe0) == 0xa0)
+        return readString(marker & 0x1f, value);
+
+    auto number = std::uint64_t{0};
+    switch (marker)
+    {
+    case 0xc0:
+        value.type = MessagePackValue::Type::Nil;
+        return true;
+    case 0xc2:
+    case 0xc3:
+        value.type = MessagePackValue::Type::Bool;
+        value.boolValue = marker == 0xc3;
+        return true;
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+        value.type = MessagePackValue::Type::UInt;
+        return readBigEndian(static_cast<std::uint8_t>(1u << (marker - 0xcc)), value.uintValue);
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3:
+    {
+        const auto bytes = static_cast<std::uint8_t>(1u << (marker - 0xd0));
+        if (!readBigEndian(bytes, number))
+            return false;
+        value.type = MessagePackValue::Type::Int;
+        value.intValue = bytes == 1   ? static_cast<std::int8_t>(number)
+                         : bytes == 2 ? static_cast<std::int16_t>(number)
+                         : bytes == 4 ? static_cast<std::int32_t>(number)
+                                      : static_cast<std::int64_t>(number);
+        return true;
+    }
+    case 0xca:
+    {
+        if (!readBigEndian(4, number))
+            return false;
+        auto bits = static_cast<std::uint32_t>(number);
+        auto single = float{0};
+        std::memcpy(&single, &bits, sizeof(single));
+        value.type = MessagePackValue::Type::Double;
+        value.doubleValue = static_cast<double>(single);
+        return true;
+    }
+    case 0xcb:
+        if (!readBigEndian(8, number))
+            return false;
+        value.type = MessagePackValue::Type::Double;
+        std::memcpy(&value.doubleValue, &number, sizeof(value.doubleValue));
+        return true;
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+        return readBigEndian(static_cast<std::uint8_t>(1u << (marker - 0xd9)), number) && readString(number, value);
+    case 0xdc:
+    case 0xdd:
+        return readBigEndian(static_cast<std::uint8_t>(2u << (marker - 0xdc)), number) &&
+               readArray(number, value, depth);
+    case 0xde:
+    case 0xdf:
+        return readBigEndian(static_cast<std::uint8_t>(2u << (marker - 0xde)), number) &&
+               readMap(number, value, depth);
+    default:
+        return false;
+    }
+}
+
+bool MessagePackReader::readBigEndian(std::uint8_t bytes, std::uint64_t& value)
+{
+    if (m_data.size() - m_position < bytes)
+        return false;
+
+    value = 0;
+    for (auto i = 0; i < bytes; ++i)
+        value = (value << 8) | static_cast<std::uint8_t>(m_data[m_position++]);
+    return true;
+}
+
+bool MessagePackReader::readString(std::uint64_t size, MessagePackValue& value)
+{
+    if (m_data.size() - m_position < size)
+        return false;
+
+    value.type = MessagePackValue::Type::String;
+    value.stringValue = m_data.substr(m_position, static_cast<std::size_t>(size));
+    m_position += static_cast<std::size_t>(size);
+    return true;
+}
+
+bool MessagePackReader::readArray(std::uint64_t size, MessagePackValue& value, std::uint32_t depth)
+{
+    // Every element takes up at least a byte, so a larger size can only come from invalid data
+    if (m_data.size() - m_position < size)
+        return false;
+
+    value.type = MessagePackValue::Type::Array;
+    value.arrayValue.resize(static_cast<std::size_t>(size));
+    for (auto& element : value.arrayValue)
+        if (!readValue(element, depth + 1))
+            return false;
+    return true;
+}
+
+bool MessagePackReader::readMap(std::uint64_t size, MessagePackValue& value, std::uint32_t depth)
+{
+    if ((m_data.size() - m_position) / 2 < size)
+        return false;
+
+    value.type = MessagePackValue::Type::Map;
+    value.mapValue.resize(static_cast<std::size_t>(size));
+    for (auto& pair : value.mapValue)
+        if (!readValue(pair.first, depth + 1) || !readValue(pair.second, depth + 1))
+            return false;
+    return true;
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,145 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_MESSAGEPACK_H
+#define WOLKABOUTCONNECTOR_MESSAGEPACK_H
+
+#include "core/Types.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This is the writer that encodes values in the MessagePack format into a buffer. Every value is written in its
+ * smallest encoding. Arrays and maps are written as a header with the count of elements, followed by the elements.
+ */
+class MessagePackWriter
+{
+public:
+    void writeNil();
+
+    void writeBool(bool value);
+
+    void writeInt(std::int64_t value);
+
+    void writeUInt(std::uint64_t value);
+
+    void writeDouble(double value);
+
+    void writeString(const std::string& value);
+
+    void writeArrayHeader(std::uint32_t size);
+
+    void writeMapHeader(std::uint32_t size);
+
+    /**
+     * This method writes a value that is held as a string in the type declared for it. A `NUMERIC` value is written as
+     * an integer or a decimal number, and a `BOOLEAN` value as a boolean. Everything else, including values that do not
+     * parse as their declared type, is written as a string.
+     *
+     * @param value The value.
+     * @param dataType The declared type of the value.
+     */
+    void writeValue(const std::string& value, DataType dataType);
+
+    const std::string& getBuffer() const;
+
+    std::string release();
+
+private:
+    void writeBigEndian(std::uint64_t value, std::uint8_t bytes);
+
+    std::string m_buffer;
+};
+
+/**
+ * This is a decoded MessagePack value. It is used as the stand-in for the platform side decoder, to verify what
+ * `MessagePackDataProtocol` sends out.
+ */
+struct MessagePackValue
+{
+    enum class Type
+    {
+        Nil,
+        Bool,
+        Int,
+        UInt,
+        Double,
+        String,
+        Array,
+        Map
+    };
+
+    Type type = Type::Nil;
+    bool boolValue = false;
+    std::int64_t intValue = 0;
+    std::uint64_t uintValue = 0;
+    double doubleValue = 0;
+    std::string stringValue;
+    std::vector<MessagePackValue> arrayValue;
+    std::vector<std::pair<MessagePackValue, MessagePackValue>> mapValue;
+
+    /**
+     * This method looks up a value in a map by a string key.
+     *
+     * @param key The key.
+     * @return The value under the key, or `nullptr` if this is not a map, or the key is not in it.
+     */
+    const MessagePackValue* find(const std::string& key) const;
+};
+
+/**
+ * This is the reader that decodes a buffer in the MessagePack format. Extension types and binary data are not
+ * supported, as they are never written by `MessagePackWriter`.
+ */
+class MessagePackReader
+{
+public:
+    /**
+     * This method decodes a single value, that must take up the entire buffer.
+     *
+     * @param data The buffer.
+     * @param value The value into which the data is decoded.
+     * @return Whether the buffer held a single valid value.
+     */
+    static bool read(const std::string& data, MessagePackValue& value);
+
+private:
+    explicit MessagePackReader(const std::string& data);
+
+    bool readValue(MessagePackValue& value, std::uint32_t depth);
+
+    bool readBigEndian(std::uint8_t bytes, std::uint64_t& value);
+
+    bool readString(std::uint64_t size, MessagePackValue& value);
+
+    bool readArray(std::uint64_t size, MessagePackValue& value, std::uint32_t depth);
+
+    bool readMap(std::uint64_t size, MessagePackValue& value, std::uint32_t depth);
+
+    const std::string& m_data;
+    std::size_t m_position;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_MESSAGEPACK_H
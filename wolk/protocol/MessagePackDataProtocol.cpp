@@ -0,0 +1,135 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/protocol/MessagePackDataProtocol.h"
+
+#include "core/model/Message.h"
+#include "wolk/protocol/MessagePack.h"
+
+namespace wolkabout
+{
+namespace connect
+{
+namespace
+{
+const std::string TIMESTAMP_KEY = "timestamp";
+const std::string NAME_KEY = "name";
+const std::string DATA_TYPE_KEY = "dataType";
+const std::string VALUE_KEY = "value";
+}    // namespace
+
+std::unique_ptr<Message> MessagePackDataProtocol::makeOutboundMessage(const std::string& deviceKey,
+                                                                      FeedValuesMessage message)
+{
+    const auto& readings = message.getReadings();
+    if (readings.empty() || readings.begin()->second.empty())
+        return WolkaboutDataProtocol::makeOutboundMessage(deviceKey, std::move(message));
+
+    // The channel is taken from the JSON message of a single reading, as it doesn't depend on the content
+    auto channelMessage = WolkaboutDataProtocol::makeOutboundMessage(
+      deviceKey, FeedValuesMessage{std::vector<Reading>{readings.begin()->second.front()}});
+    if (channelMessage == nullptr)
+        return nullptr;
+
+    auto writer = MessagePackWriter{};
+    writer.writeArrayHeader(static_cast<std::uint32_t>(readings.size()));
+    for (const auto& pair : readings)
+    {
+        writer.writeMapHeader(static_cast<std::uint32_t>(pair.second.size() + 1));
+        for (const auto& reading : pair.second)
+        {
+            const auto dataType = getFeedDataType(deviceKey, reading.getReference());
+            writer.writeString(reading.getReference());
+            if (reading.isMulti())
+            {
+                const auto values = reading.getStringValues();
+                writer.writeArrayHeader(static_cast<std::uint32_t>(values.size()));
+                for (const auto& value : values)
+                    writer.writeValue(value, dataType);
+            }
+            else
+                writer.writeValue(reading.getStringValue(), dataType);
+        }
+        writer.writeString(TIMESTAMP_KEY);
+        writer.writeUInt(pair.first);
+    }
+    return std::unique_ptr<Message>{new Message{writer.release(), channelMessage->getChannel()}};
+}
+
+std::unique_ptr<Message> MessagePackDataProtocol::makeOutboundMessage(const std::string& deviceKey,
+                                                                      AttributeRegistrationMessage message)
+{
+    const auto& attributes = message.getAttributes();
+    if (attributes.empty())
+        return WolkaboutDataProtocol::makeOutboundMessage(deviceKey, std::move(message));
+
+    auto channelMessage = WolkaboutDataProtocol::makeOutboundMessage(
+      deviceKey, AttributeRegistrationMessage{std::vector<Attribute>{attributes.front()}});
+    if (channelMessage == nullptr)
+        return nullptr;
+
+    auto writer = MessagePackWriter{};
+    writer.writeArrayHeader(static_cast<std::uint32_t>(attributes.size()));
+    for (const auto& attribute : attributes)
+    {
+        writer.writeMapHeader(3);
+        writer.writeString(NAME_KEY);
+        writer.writeString(attribute.getName());
+        writer.writeString(DATA_TYPE_KEY);
+        writer.writeString(toString(attribute.getDataType()));
+        writer.writeString(VALUE_KEY);
+        writer.writeString(attribute.getValue());
+    }
+    return std::unique_ptr<Message>{new Message{writer.release(), channelMessage->getChannel()}};
+}
+
+std::unique_ptr<Message> MessagePackDataProtocol::makeOutboundMessage(const std::string& deviceKey,
+                                                                      ParametersUpdateMessage message)
+{
+    const auto& parameters = message.getParameters();
+    if (parameters.empty())
+        return WolkaboutDataProtocol::makeOutboundMessage(deviceKey, std::move(message));
+
+    auto channelMessage = WolkaboutDataProtocol::makeOutboundMessage(
+      deviceKey, ParametersUpdateMessage{std::vector<Parameter>{parameters.front()}});
+    if (channelMessage == nullptr)
+        return nullptr;
+
+    auto writer = MessagePackWriter{};
+    writer.writeMapHeader(static_cast<std::uint32_t>(parameters.size()));
+    for (const auto& parameter : parameters)
+    {
+        writer.writeString(toString(parameter.first));
+        writer.writeString(parameter.second);
+    }
+    return std::unique_ptr<Message>{new Message{writer.release(), channelMessage->getChannel()}};
+}
+
+void MessagePackDataProtocol::setFeedDataType(const std::string& deviceKey, const std::string& reference,
+                                              DataType dataType)
+{
+    std::lock_guard<std::mutex> lock{m_feedDataTypesMutex};
+    m_feedDataTypes[{deviceKey, reference}] = dataType;
+}
+
+DataType MessagePackDataProtocol::getFeedDataType(const std::string& deviceKey, const std::string& reference)
+{
+    std::lock_guard<std::mutex> lock{m_feedDataTypesMutex};
+    const auto it = m_feedDataTypes.find({deviceKey, reference});
+    return it != m_feedDataTypes.cend() ? it->second : DataType::STRING;
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,76 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_MESSAGEPACKDATAPROTOCOL_H
+#define WOLKABOUTCONNECTOR_MESSAGEPACKDATAPROTOCOL_H
+
+#include "core/protocol/wolkabout/WolkaboutDataProtocol.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This is a `WolkaboutDataProtocol` that encodes the outgoing readings, attributes and parameters in the binary
+ * MessagePack format instead of JSON. The messages keep their channels and layout, so the feed values are an array
+ * of maps from references (and `timestamp`) to values, the attributes an array of maps with the `name`, `dataType`
+ * and `value`, and the parameters a map from names to values. The values of feeds declared as `NUMERIC` or `BOOLEAN`
+ * (`setFeedDataType`) are written in their native type, while the values of other feeds, the attributes and the
+ * parameters are written as strings. Inbound messages are still parsed as JSON.
+ *
+ * This protocol is opt-in (`WolkBuilder::withDataProtocol`), and should only be used with a platform/broker that is
+ * set up to decode MessagePack payloads.
+ */
+class MessagePackDataProtocol : public WolkaboutDataProtocol
+{
+public:
+    using WolkaboutDataProtocol::makeOutboundMessage;
+
+    std::unique_ptr<Message> makeOutboundMessage(const std::string& deviceKey, FeedValuesMessage message) override;
+
+    std::unique_ptr<Message> makeOutboundMessage(const std::string& deviceKey,
+                                                 AttributeRegistrationMessage message) override;
+
+    std::unique_ptr<Message> makeOutboundMessage(const std::string& deviceKey,
+                                                 ParametersUpdateMessage message) override;
+
+    /**
+     * This method declares the type of values of a feed. The values of feeds that are not declared are written as
+     * strings.
+     *
+     * @param deviceKey The key of the device the feed belongs to.
+     * @param reference The reference of the feed.
+     * @param dataType The type of the feed values.
+     */
+    void setFeedDataType(const std::string& deviceKey, const std::string& reference, DataType dataType);
+
+private:
+    DataType getFeedDataType(const std::string& deviceKey, const std::string& reference);
+
+    // Here are the declared types of feed values, under the device key and the feed reference
+    std::mutex m_feedDataTypesMutex;
+    std::map<std::pair<std::string, std::string>, DataType> m_feedDataTypes;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_MESSAGEPACKDATAPROTOCOL_H
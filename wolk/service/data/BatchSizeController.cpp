@@ -0,0 +1,121 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/service/data/BatchSizeController.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+namespace connect
+{
+const constexpr std::uint64_t BatchSizeController::DEFAULT_BATCH_SIZE;
+
+BatchSizeController::BatchSizeController(std::uint64_t batchSize)
+: m_adaptive{false}
+, m_minimumBatchSize{std::max<std::uint64_t>(batchSize, 1)}
+, m_maximumBatchSize{std::max<std::uint64_t>(batchSize, 1)}
+, m_maxPacketSize{0}
+, m_batchSize{std::max<std::uint64_t>(batchSize, 1)}
+{
+}
+
+BatchSizeController::BatchSizeController(std::uint64_t initialBatchSize, std::uint64_t minimumBatchSize,
+                                         std::uint64_t maximumBatchSize, std::uint64_t maxPacketSize)
+: m_adaptive{true}
+, m_minimumBatchSize{std::max<std::uint64_t>(minimumBatchSize, 1)}
+, m_maximumBatchSize{std::max(maximumBatchSize, m_minimumBatchSize)}
+, m_maxPacketSize{maxPacketSize}
+, m_batchSize{std::min(std::max(initialBatchSize, m_minimumBatchSize), m_maximumBatchSize)}
+{
+}
+
+BatchSizeController::BatchSizeController(const BatchSizeController& other) noexcept
+: m_adaptive{other.m_adaptive}
+, m_minimumBatchSize{other.m_minimumBatchSize}
+, m_maximumBatchSize{other.m_maximumBatchSize}
+, m_maxPacketSize{other.m_maxPacketSize}
+, m_batchSize{other.getBatchSize()}
+{
+}
+
+BatchSizeController& BatchSizeController::operator=(const BatchSizeController& other) noexcept
+{
+    m_adaptive = other.m_adaptive;
+    m_minimumBatchSize = other.m_minimumBatchSize;
+    m_maximumBatchSize = other.m_maximumBatchSize;
+    m_maxPacketSize = other.m_maxPacketSize;
+    m_batchSize = other.getBatchSize();
+    return *this;
+}
+
+std::uint64_t BatchSizeController::getBatchSize() const
+{
+    return m_batchSize.load();
+}
+
+std::uint64_t BatchSizeController::getMaxPacketSize() const
+{
+    return m_maxPacketSize;
+}
+
+bool BatchSizeController::isAdaptive() const
+{
+    return m_adaptive;
+}
+
+void BatchSizeController::reportSuccess(std::uint64_t readingsCount, std::uint64_t payloadSize)
+{
+    if (!m_adaptive)
+        return;
+
+    // Only a full batch tells us that a larger one could have been used
+    const auto current = m_batchSize.load();
+    if (readingsCount < current)
+        return;
+    auto batchSize = std::min(current * 2, m_maximumBatchSize);
+    batchSize = std::min(batchSize, fitIntoPacket(readingsCount, payloadSize));
+    m_batchSize = std::max(batchSize, m_minimumBatchSize);
+}
+
+void BatchSizeController::reportFailure()
+{
+    if (!m_adaptive)
+        return;
+
+    m_batchSize = std::max(m_batchSize.load() / 2, m_minimumBatchSize);
+}
+
+void BatchSizeController::reportOversized(std::uint64_t readingsCount, std::uint64_t payloadSize)
+{
+    if (!m_adaptive)
+        return;
+
+    auto batchSize = std::min(fitIntoPacket(readingsCount, payloadSize), readingsCount / 2);
+    m_batchSize = std::max(batchSize, m_minimumBatchSize);
+}
+
+std::uint64_t BatchSizeController::fitIntoPacket(std::uint64_t readingsCount, std::uint64_t payloadSize) const
+{
+    if (m_maxPacketSize == 0 || readingsCount == 0 || payloadSize == 0)
+        return m_maximumBatchSize;
+
+    // Assume the readings are of the average size of the readings in the last message
+    const auto averageSize = std::max<std::uint64_t>(payloadSize / readingsCount, 1);
+    return std::max<std::uint64_t>(m_maxPacketSize / averageSize, 1);
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,123 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_BATCHSIZECONTROLLER_H
+#define WOLKABOUTCONNECTOR_BATCHSIZECONTROLLER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This is the class that decides how many readings are taken from persistence for a single outgoing message.
+ * In fixed mode the batch size never changes. In adaptive mode the batch size grows while full batches are published
+ * successfully, shrinks when publishing fails, and is kept under the maximum packet size the broker accepts.
+ */
+class BatchSizeController
+{
+public:
+    /**
+     * Constructor for the fixed batch size mode.
+     *
+     * @param batchSize The count of readings taken for a single message.
+     */
+    explicit BatchSizeController(std::uint64_t batchSize = DEFAULT_BATCH_SIZE);
+
+    /**
+     * Constructor for the adaptive batch size mode.
+     *
+     * @param initialBatchSize The batch size used before any feedback was received.
+     * @param minimumBatchSize The batch size will never shrink under this value.
+     * @param maximumBatchSize The batch size will never grow over this value.
+     * @param maxPacketSize The maximum size of a message payload the broker accepts (in bytes). 0 means unlimited.
+     */
+    BatchSizeController(std::uint64_t initialBatchSize, std::uint64_t minimumBatchSize,
+                        std::uint64_t maximumBatchSize, std::uint64_t maxPacketSize);
+
+    /**
+     * Copy constructor. The copy receives the current batch size of the other controller.
+     */
+    BatchSizeController(const BatchSizeController& other) noexcept;
+
+    /**
+     * Copy assignment operator. Takes over the configuration and the current batch size of the other controller.
+     */
+    BatchSizeController& operator=(const BatchSizeController& other) noexcept;
+
+    /**
+     * This is a getter for the current batch size.
+     *
+     * @return The count of readings that should be taken for the next message.
+     */
+    std::uint64_t getBatchSize() const;
+
+    /**
+     * This is a getter for the maximum packet size.
+     *
+     * @return The maximum packet size (in bytes). 0 means unlimited.
+     */
+    std::uint64_t getMaxPacketSize() const;
+
+    /**
+     * This is a getter for the mode of the controller.
+     *
+     * @return Whether the controller is adapting the batch size.
+     */
+    bool isAdaptive() const;
+
+    /**
+     * This method is used to notify the controller that a message was published.
+     *
+     * @param readingsCount The count of readings that were in the message.
+     * @param payloadSize The size of the message payload (in bytes).
+     */
+    void reportSuccess(std::uint64_t readingsCount, std::uint64_t payloadSize);
+
+    /**
+     * This method is used to notify the controller that a message failed to publish.
+     */
+    void reportFailure();
+
+    /**
+     * This method is used to notify the controller that a message was larger than the maximum packet size.
+     *
+     * @param readingsCount The count of readings that were in the message.
+     * @param payloadSize The size of the message payload (in bytes).
+     */
+    void reportOversized(std::uint64_t readingsCount, std::uint64_t payloadSize);
+
+    static const constexpr std::uint64_t DEFAULT_BATCH_SIZE = 50;
+
+private:
+    // Calculates how many readings of the given average size fit into a packet
+    std::uint64_t fitIntoPacket(std::uint64_t readingsCount, std::uint64_t payloadSize) const;
+
+    // Here is the place for the configuration
+    bool m_adaptive;
+    std::uint64_t m_minimumBatchSize;
+    std::uint64_t m_maximumBatchSize;
+    std::uint64_t m_maxPacketSize;
+
+    // Here is the current batch size. Feedback is reported from the thread that publishes, so no locking is necessary.
+    std::atomic<std::uint64_t> m_batchSize;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_BATCHSIZECONTROLLER_H
@@ -25,6 +25,8 @@
 #include "core/persistence/Persistence.h"
 #include "core/protocol/DataProtocol.h"
 #include "core/utilities/Logger.h"
+#include "wolk/persistence/BatchPersistence.h"
+#include "wolk/persistence/ReadingSize.h"
 
 #include <algorithm>
 #include <cassert>
@@ -34,61 +36,169 @@ namespace
 {
 const std::uint16_t RETRY_COUNT = 3;
 const std::chrono::milliseconds RETRY_TIMEOUT{5000};
+const std::chrono::milliseconds PARAMETER_SUBSCRIPTION_TIMEOUT{60000};
+// The details callbacks wait for as long as the request is retried, and one more retry timeout for the last response
+const std::chrono::milliseconds DETAILS_CALLBACK_TIMEOUT = RETRY_TIMEOUT * (RETRY_COUNT + 1);
+
+bool isSameReading(const wolkabout::Reading& left, const wolkabout::Reading& right)
+{
+    if (left.getReference() != right.getReference() || left.getTimestamp() != right.getTimestamp() ||
+        left.isMulti() != right.isMulti())
+        return false;
+    return left.isMulti() ? left.getStringValues() == right.getStringValues() :
+                            left.getStringValue() == right.getStringValue();
+}
 }    // namespace
 
 namespace wolkabout
 {
 namespace connect
 {
-const std::string DataService::PERSISTENCE_KEY_DELIMITER = "+";
-
 DataService::DataService(DataProtocol& protocol, Persistence& persistence, ConnectivityService& connectivityService,
                          OutboundRetryMessageHandler& outboundRetryMessageHandler,
                          FeedUpdateSetHandler feedUpdateHandler, ParameterSyncHandler parameterSyncHandler,
                          DetailsSyncHandler detailsSyncHandler)
 : m_protocol{protocol}
 , m_persistence{persistence}
+, m_batchPersistence{dynamic_cast<BatchPersistence*>(&persistence)}
 , m_connectivityService{connectivityService}
 , m_outboundRetryMessageHandler{outboundRetryMessageHandler}
 , m_feedUpdateHandler{std::move(feedUpdateHandler)}
 , m_parameterSyncHandler{std::move(parameterSyncHandler)}
 , m_detailsSyncHandler{std::move(detailsSyncHandler)}
+, m_readingsPublishMode{ReadingsPublishMode::PerFeed}
+, m_readingsBudget{0}
+, m_bytesBudget{0}
+, m_readingsIndexSeeded{false}
+, m_attributeBucketsSeeded{false}
+, m_parameterBucketsSeeded{false}
 , m_iterator(0)
+, m_subscriptionTimeout{PARAMETER_SUBSCRIPTION_TIMEOUT}
+, m_detailsIterator(0)
 {
 }
 
 void DataService::addReading(const std::string& deviceKey, const std::string& reference, const std::string& value,
                              std::uint64_t rtc)
 {
-    m_persistence.putReading(makePersistenceKey(deviceKey, reference), Reading{reference, value, rtc});
+    addReading(deviceKey, Reading{reference, value, rtc});
 }
 
 void DataService::addReading(const std::string& deviceKey, const std::string& reference,
                              const std::vector<std::string>& value, std::uint64_t rtc)
 {
-    m_persistence.putReading(makePersistenceKey(deviceKey, reference), Reading{reference, value, rtc});
+    addReading(deviceKey, Reading{reference, value, rtc});
 }
 
 void DataService::addReading(const std::string& deviceKey, const Reading& reading)
 {
-    m_persistence.putReading(makePersistenceKey(deviceKey, reading.getReference()), reading);
+    const auto& persistenceKey = persistenceKeyOf(deviceKey, reading.getReference());
+    if (isAggregated(persistenceKey))
+    {
+        addReadings(deviceKey, std::vector<Reading>{reading});
+        return;
+    }
+    if (!passesFeedFilter(persistenceKey, reading))
+        return;
+    indexReadingsKey(deviceKey, persistenceKey);
+    {
+        std::lock_guard<std::mutex> lock{m_readingsMutex};
+        m_persistence.putReading(persistenceKey, reading);
+    }
+    notifyReadingsAdded(1, estimateReadingSize(reading));
 }
 
 void DataService::addReadings(const std::string& deviceKey, const std::vector<Reading>& readings)
 {
-    for (const auto& reading : readings)
-        m_persistence.putReading(makePersistenceKey(deviceKey, reading.getReference()), reading);
+    addReadings(deviceKey, std::vector<Reading>{readings});
+}
+
+void DataService::addReadings(const std::string& deviceKey, std::vector<Reading>&& readings)
+{
+    // Group the readings by reference, keeping the order in which the references first appear
+    auto groups = std::vector<std::pair<std::string, std::vector<Reading>>>{};
+    auto groupOfReference = std::map<std::string, std::size_t>{};
+    for (auto& reading : readings)
+    {
+        const auto it = groupOfReference.emplace(reading.getReference(), groups.size());
+        if (it.second)
+            groups.emplace_back(reading.getReference(), std::vector<Reading>{});
+        groups[it.first->second].second.emplace_back(std::move(reading));
+    }
+    readings.clear();
+
+    auto count = std::uint64_t{0};
+    auto bytes = std::uint64_t{0};
+    for (auto& group : groups)
+    {
+        const auto& persistenceKey = persistenceKeyOf(deviceKey, group.first);
+        aggregateReadings(persistenceKey, group.second, count, bytes);
+        storeReadings(deviceKey, persistenceKey, group.second, count, bytes);
+    }
+    if (count > 0)
+        notifyReadingsAdded(count, bytes);
+}
+
+void DataService::storeReadings(const std::string& deviceKey, const std::string& persistenceKey,
+                                std::vector<Reading>& groupReadings, std::uint64_t& count, std::uint64_t& bytes)
+{
+    groupReadings.erase(
+      std::remove_if(groupReadings.begin(), groupReadings.end(),
+                     [&](const Reading& reading) { return !passesFeedFilter(persistenceKey, reading); }),
+      groupReadings.end());
+    if (groupReadings.empty())
+        return;
+    count += groupReadings.size();
+    for (const auto& reading : groupReadings)
+        bytes += estimateReadingSize(reading);
+
+    indexReadingsKey(deviceKey, persistenceKey);
+    std::lock_guard<std::mutex> lock{m_readingsMutex};
+    if (m_batchPersistence != nullptr)
+    {
+        if (!m_batchPersistence->putReadings(persistenceKey, std::move(groupReadings)))
+            LOG(ERROR) << "Failed to store readings -> '" << persistenceKey << "'.";
+        return;
+    }
+    for (const auto& reading : groupReadings)
+        m_persistence.putReading(persistenceKey, reading);
 }
 
 void DataService::addAttribute(const std::string& deviceKey, const Attribute& attribute)
 {
-    m_persistence.putAttribute(makePersistenceKey(deviceKey, attribute.getName()),
-                               std::make_shared<Attribute>(attribute));
+    const auto& persistenceKey = persistenceKeyOf(deviceKey, attribute.getName());
+    auto value = std::make_shared<Attribute>(attribute);
+    {
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        m_attributeBuckets[deviceKey][persistenceKey] = value;
+    }
+    m_persistence.putAttribute(persistenceKey, std::move(value));
 }
 
 void DataService::updateParameter(const std::string& deviceKey, const Parameter& parameter)
 {
-    m_persistence.putParameter(makePersistenceKey(deviceKey, toString(parameter.first)), parameter);
+    const auto& persistenceKey = persistenceKeyOf(deviceKey, toString(parameter.first));
+    auto unchanged = false;
+    auto pending = false;
+    {
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        const auto sent = m_sentParameters.find(persistenceKey);
+        unchanged = sent != m_sentParameters.cend() && sent->second == parameter.second;
+        if (!unchanged)
+            m_parameterBuckets[deviceKey][persistenceKey] = parameter;
+        else
+        {
+            // The platform already has this value, so a different value that is still waiting is no longer needed
+            const auto bucket = m_parameterBuckets.find(deviceKey);
+            pending = bucket != m_parameterBuckets.cend() && bucket->second.erase(persistenceKey) > 0;
+            if (pending && bucket->second.empty())
+                m_parameterBuckets.erase(bucket);
+        }
+    }
+    if (!unchanged)
+        m_persistence.putParameter(persistenceKey, parameter);
+    else if (pending)
+        m_persistence.removeParameters(persistenceKey);
 }
 
 void DataService::registerFeed(const std::string& deviceKey, Feed feed)
@@ -107,6 +217,63 @@ void DataService::registerFeeds(const std::string& deviceKey, std::vector<Feed>
         LOG(ERROR) << "Failed to register feeds -> Failed to publish the outgoing 'FeedRegistrationMessage'.";
 }
 
+void DataService::setFeedFilter(const std::string& deviceKey, const std::string& reference, const FeedFilter& filter)
+{
+    const auto& persistenceKey = persistenceKeyOf(deviceKey, reference);
+    std::lock_guard<std::mutex> lock{m_feedFiltersMutex};
+    m_feedFilters.erase(persistenceKey);
+    if (!filter.isDisabled())
+        m_feedFilters.emplace(persistenceKey, FeedFilterState{filter});
+}
+
+void DataService::setFeedAggregation(const std::string& deviceKey, const std::string& reference,
+                                     const FeedAggregation& aggregation)
+{
+    const auto& persistenceKey = persistenceKeyOf(deviceKey, reference);
+    auto closed = std::vector<Reading>{};
+    {
+        std::lock_guard<std::mutex> lock{m_aggregationsMutex};
+        const auto it = m_aggregationWindows.find(persistenceKey);
+        if (it != m_aggregationWindows.end())
+        {
+            // The readings collected so far are not lost, the window is closed early
+            it->second.close(0, closed, true);
+            m_aggregationWindows.erase(it);
+        }
+        if (!aggregation.isDisabled())
+            m_aggregationWindows.emplace(persistenceKey, AggregationWindow{aggregation});
+    }
+
+    auto count = std::uint64_t{0};
+    auto bytes = std::uint64_t{0};
+    storeReadings(deviceKey, persistenceKey, closed, count, bytes);
+    if (count > 0)
+        notifyReadingsAdded(count, bytes);
+}
+
+void DataService::closeAggregationWindows()
+{
+    const auto now = currentTimestamp();
+    auto closedWindows = std::vector<std::pair<std::string, std::vector<Reading>>>{};
+    {
+        std::lock_guard<std::mutex> lock{m_aggregationsMutex};
+        for (auto& window : m_aggregationWindows)
+        {
+            auto closed = std::vector<Reading>{};
+            if (window.second.close(now, closed))
+                closedWindows.emplace_back(window.first, std::move(closed));
+        }
+    }
+
+    auto count = std::uint64_t{0};
+    auto bytes = std::uint64_t{0};
+    for (auto& closedWindow : closedWindows)
+        storeReadings(resolvePersistenceKey(closedWindow.first).first, closedWindow.first, closedWindow.second, count,
+                      bytes);
+    if (count > 0)
+        notifyReadingsAdded(count, bytes);
+}
+
 void DataService::removeFeed(const std::string& deviceKey, std::string reference)
 {
     removeFeeds(deviceKey, {std::move(reference)});
@@ -115,6 +282,16 @@ void DataService::removeFeed(const std::string& deviceKey, std::string reference
 void DataService::removeFeeds(const std::string& deviceKey, std::vector<std::string> feeds)
 {
     LOG(TRACE) << METHOD_INFO;
+    {
+        std::lock_guard<std::mutex> lock{m_feedFiltersMutex};
+        for (const auto& reference : feeds)
+            m_feedFilters.erase(persistenceKeyOf(deviceKey, reference));
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_aggregationsMutex};
+        for (const auto& reference : feeds)
+            m_aggregationWindows.erase(persistenceKeyOf(deviceKey, reference));
+    }
     auto message =
       std::shared_ptr<Message>(m_protocol.makeOutboundMessage(deviceKey, FeedRemovalMessage(std::move(feeds))));
     if (message == nullptr)
@@ -164,10 +341,7 @@ bool DataService::synchronizeParameters(const std::string& deviceKey, const std:
         return false;
     }
     if (callback)
-    {
-        std::lock_guard<std::mutex> lockGuard{m_subscriptionMutex};
-        m_parameterSubscriptions.emplace(m_iterator++, ParameterSubscription{parameters, std::move(callback)});
-    }
+        addParameterSubscription(deviceKey, parameters, std::move(callback));
     return true;
 }
 
@@ -195,190 +369,220 @@ bool DataService::detailsSynchronizationAsync(
        },
        RETRY_COUNT, RETRY_TIMEOUT});
     if (callback)
-    {
-        std::lock_guard<std::mutex> lock{m_detailsMutex};
-        m_detailsCallbacks.push(std::move(callback));
-    }
+        addDetailsCallback(deviceKey, std::move(callback));
     return true;
 }
 
 void DataService::publishReadings()
 {
-    for (const auto& key : m_persistence.getReadingsKeys())
-    {
-        publishReadingsForPersistenceKey(key);
-    }
+    publishReadingsSlice(PublishBudget{});
 }
 
 void DataService::publishReadings(const std::string& deviceKey)
 {
-    publishReadingsForPersistenceKey(deviceKey);
+    LOG(TRACE) << METHOD_INFO;
+    closeAggregationWindows();
+
+    const auto persistenceKeys = getIndexedReadingsKeys(deviceKey);
+    if (persistenceKeys.empty())
+        return;
+    publishReadingsGroups(groupReadingsKeys(persistenceKeys), PublishBudget{});
 }
 
-void DataService::publishAttributes()
+PublishSliceResult DataService::publishReadingsSlice(const PublishBudget& budget)
 {
     LOG(TRACE) << METHOD_INFO;
+    closeAggregationWindows();
 
-    // Extract all attributes for all devices and group them up by device
-    auto attributes = std::map<std::string, std::vector<Attribute>>{};
-    for (const auto& attributeFromPersistence : m_persistence.getAttributes())
+    // Since we're looking at all the keys anyway, make sure the index holds all of them
+    const auto persistenceKeys = m_persistence.getReadingsKeys();
     {
-        // Extract everything about the attribute
-        auto deviceKey = std::string{};
-        auto reference = std::string{};
-        std::tie(deviceKey, reference) = parsePersistenceKey(attributeFromPersistence.first);
-
-        // Check if there is already an array for the device
-        auto it = attributes.find(deviceKey);
-        if (it == attributes.cend())
-            it = attributes.emplace(deviceKey, std::vector<Attribute>{}).first;
-        it->second.emplace_back(*attributeFromPersistence.second);
+        std::lock_guard<std::mutex> lock{m_readingsIndexMutex};
+        for (const auto& key : persistenceKeys)
+            m_readingsIndex[resolvePersistenceKey(key).first].emplace(key);
+        m_readingsIndexSeeded = true;
     }
-    if (attributes.empty())
-        return;
+    return publishReadingsGroups(groupReadingsKeys(persistenceKeys), budget);
+}
 
-    // Send a message out for all devices
-    for (const auto& deviceAttributes : attributes)
+PublishSliceResult DataService::publishReadingsGroups(
+  const std::vector<std::pair<std::string, std::vector<std::string>>>& groups, const PublishBudget& budget)
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto result = PublishSliceResult{};
+    auto budgetSpent = [&]() {
+        return (budget.messages != 0 && result.sentMessages >= budget.messages) ||
+               (budget.bytes != 0 && result.sentBytes >= budget.bytes) ||
+               (budget.time.count() != 0 && std::chrono::steady_clock::now() - start >= budget.time);
+    };
+
+    // Go around all the groups, sending out a batch from each one, until all of them are empty
+    auto pending = std::vector<bool>(groups.size(), true);
+    auto pendingCount = groups.size();
+    while (pendingCount > 0)
     {
-        // Make a lambda that will delete all these attributes from persistence
-        const auto& deviceKey = deviceAttributes.first;
-        auto deleteAllAttributes = [&]() {
-            for (const auto& attribute : deviceAttributes.second)
-                m_persistence.removeAttributes(makePersistenceKey(deviceKey, attribute.getName()));
-        };
-
-        // Form the message
-        auto outboundMessage = std::shared_ptr<Message>(
-          m_protocol.makeOutboundMessage(deviceKey, AttributeRegistrationMessage(deviceAttributes.second)));
-        if (!outboundMessage)
+        for (std::size_t i = 0; i < groups.size(); ++i)
         {
-            LOG(ERROR) << "Unable to create message from attributes";
-            deleteAllAttributes();
-            return;
+            if (!pending[i])
+                continue;
+            if (budgetSpent())
+            {
+                result.backlogRemaining = true;
+                return result;
+            }
+            if (!publishReadingsBatch(groups[i].first, groups[i].second, result))
+            {
+                pending[i] = false;
+                --pendingCount;
+            }
         }
-        if (m_connectivityService.publish(outboundMessage))
-            deleteAllAttributes();
     }
+    return result;
 }
 
-void DataService::publishAttributes(const std::string& deviceKey)
+void DataService::publishAttributes()
 {
     LOG(TRACE) << METHOD_INFO;
 
-    // Extract all the attributes for this device key
-    auto attributes = std::vector<Attribute>{};
-    for (const auto& attribute : m_persistence.getAttributes())
+    // Take the attributes of all devices from their buckets
+    auto attributes = std::map<std::string, std::map<std::string, std::shared_ptr<Attribute>>>{};
     {
-        // Check the device key
-        auto attributeDeviceKey = std::string{};
-        auto reference = std::string{};
-        std::tie(attributeDeviceKey, reference) = parsePersistenceKey(attribute.first);
-        if (attributeDeviceKey == deviceKey)
-            attributes.emplace_back(*attribute.second);
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        seedAttributeBuckets();
+        attributes = m_attributeBuckets;
     }
-    if (attributes.empty())
-        return;
 
-    // Make a lambda that will delete all these attributes from persistence
-    auto deleteAllAttributes = [&]() {
-        for (const auto& attribute : attributes)
-            m_persistence.removeAttributes(makePersistenceKey(deviceKey, attribute.getName()));
-    };
+    // Send a message out for all devices
+    for (const auto& deviceAttributes : attributes)
+        if (!publishAttributeBucket(deviceAttributes.first, deviceAttributes.second))
+            return;
+}
 
-    // Form the message
-    auto message = AttributeRegistrationMessage(attributes);
-    auto outboundMessage = std::shared_ptr<Message>(m_protocol.makeOutboundMessage(deviceKey, message));
-    if (!outboundMessage)
+void DataService::publishAttributes(const std::string& deviceKey)
+{
+    LOG(TRACE) << METHOD_INFO;
+
+    // Take the attributes only from the bucket of this device
+    auto attributes = std::map<std::string, std::shared_ptr<Attribute>>{};
     {
-        LOG(ERROR) << "Unable to create message from attributes";
-        deleteAllAttributes();
-        return;
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        seedAttributeBuckets();
+        const auto it = m_attributeBuckets.find(deviceKey);
+        if (it != m_attributeBuckets.cend())
+            attributes = it->second;
     }
-    if (m_connectivityService.publish(outboundMessage))
-        deleteAllAttributes();
+    publishAttributeBucket(deviceKey, attributes);
 }
 
 void DataService::publishParameters()
 {
     LOG(TRACE) << METHOD_INFO;
 
-    // Extract all attributes for all devices and group them up by device
-    auto parameters = std::map<std::string, std::vector<Parameter>>{};
-    for (const auto& parameterFromPersistence : m_persistence.getParameters())
+    // Take the parameters of all devices from their buckets
+    auto parameters = std::map<std::string, std::map<std::string, Parameter>>{};
     {
-        // Extract everything about the parameter
-        auto deviceKey = std::string{};
-        auto reference = std::string{};
-        std::tie(deviceKey, reference) = parsePersistenceKey(parameterFromPersistence.first);
-
-        // Check if there is already an array for the device
-        auto it = parameters.find(deviceKey);
-        if (it == parameters.cend())
-            it = parameters.emplace(deviceKey, std::vector<Parameter>{}).first;
-        it->second.emplace_back(parameterFromPersistence.second);
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        seedParameterBuckets();
+        parameters = m_parameterBuckets;
     }
-    if (parameters.empty())
-        return;
 
     // Send a message out for all devices
     for (const auto& deviceParameters : parameters)
-    {
-        // Make a lambda that will delete all these parameters from persistence
-        const auto& deviceKey = deviceParameters.first;
-        auto deleteAllParameters = [&]() {
-            for (const auto& parameter : deviceParameters.second)
-                m_persistence.removeParameters(makePersistenceKey(deviceKey, toString(parameter.first)));
-        };
-
-        // Form the message
-        auto message = ParametersUpdateMessage(deviceParameters.second);
-        auto outboundMessage = std::shared_ptr<Message>(m_protocol.makeOutboundMessage(deviceKey, message));
-        if (!outboundMessage)
-        {
-            LOG(ERROR) << "Unable to create message from parameters";
-            deleteAllParameters();
+        if (!publishParameterBucket(deviceParameters.first, deviceParameters.second))
             return;
-        }
-        if (m_connectivityService.publish(outboundMessage))
-            deleteAllParameters();
-    }
 }
 
 void DataService::publishParameters(const std::string& deviceKey)
 {
     LOG(TRACE) << METHOD_INFO;
 
-    // Extract all the attributes for this device key
-    auto parameters = std::vector<Parameter>{};
-    for (const auto& parameter : m_persistence.getParameters())
+    // Take the parameters only from the bucket of this device
+    auto parameters = std::map<std::string, Parameter>{};
     {
-        // Check the device key
-        auto parameterDeviceKey = std::string{};
-        auto reference = std::string{};
-        std::tie(parameterDeviceKey, reference) = parsePersistenceKey(parameter.first);
-        if (parameterDeviceKey == deviceKey)
-            parameters.emplace_back(parameter.second);
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        seedParameterBuckets();
+        const auto it = m_parameterBuckets.find(deviceKey);
+        if (it != m_parameterBuckets.cend())
+            parameters = it->second;
     }
-    if (parameters.empty())
-        return;
+    publishParameterBucket(deviceKey, parameters);
+}
 
-    // Make a lambda that will delete all these parameters from persistence
-    auto deleteAllParameters = [&]() {
-        for (const auto& parameter : parameters)
-            m_persistence.removeParameters(makePersistenceKey(deviceKey, toString(parameter.first)));
-    };
+void DataService::setBatchSizeController(const BatchSizeController& controller)
+{
+    m_batchSizeController = controller;
+}
 
-    // Form the message
-    auto message = ParametersUpdateMessage(parameters);
-    auto outboundMessage = std::shared_ptr<Message>(m_protocol.makeOutboundMessage(deviceKey, message));
-    if (!outboundMessage)
-    {
-        LOG(ERROR) << "Unable to create message from parameters";
-        deleteAllParameters();
+void DataService::setReadingsAddedListener(ReadingsAddedListener listener)
+{
+    m_readingsAddedListener = std::move(listener);
+}
+
+void DataService::setParameterSubscriptionTimeout(std::chrono::milliseconds timeout)
+{
+    std::lock_guard<std::mutex> lockGuard{m_subscriptionMutex};
+    m_subscriptionTimeout = timeout;
+}
+
+bool DataService::passesFeedFilter(const std::string& persistenceKey, const Reading& reading)
+{
+    std::lock_guard<std::mutex> lock{m_feedFiltersMutex};
+    const auto it = m_feedFilters.find(persistenceKey);
+    if (it == m_feedFilters.end())
+        return true;
+    return it->second.accept(reading, currentTimestamp());
+}
+
+bool DataService::isAggregated(const std::string& persistenceKey)
+{
+    std::lock_guard<std::mutex> lock{m_aggregationsMutex};
+    return m_aggregationWindows.find(persistenceKey) != m_aggregationWindows.end();
+}
+
+void DataService::aggregateReadings(const std::string& persistenceKey, std::vector<Reading>& readings,
+                                    std::uint64_t& count, std::uint64_t& bytes)
+{
+    std::lock_guard<std::mutex> lock{m_aggregationsMutex};
+    const auto it = m_aggregationWindows.find(persistenceKey);
+    if (it == m_aggregationWindows.end())
         return;
+
+    // The readings are replaced with the readings of the windows they closed, and the readings that can't be aggregated
+    const auto now = currentTimestamp();
+    auto output = std::vector<Reading>{};
+    // The aggregated readings are counted too, so the publish scheduler knows a window has something to publish
+    for (auto& reading : readings)
+    {
+        if (it->second.add(reading, now, output))
+        {
+            ++count;
+            bytes += estimateReadingSize(reading);
+        }
+        else
+            output.emplace_back(std::move(reading));
     }
-    if (m_connectivityService.publish(outboundMessage))
-        deleteAllParameters();
+    readings.swap(output);
+}
+
+std::uint64_t DataService::currentTimestamp()
+{
+    return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count());
+}
+
+void DataService::notifyReadingsAdded(std::uint64_t count, std::uint64_t bytes)
+{
+    if (m_readingsAddedListener)
+        m_readingsAddedListener(count, bytes);
+}
+
+void DataService::setReadingsPublishMode(ReadingsPublishMode mode, std::uint64_t readingsBudget,
+                                         std::uint64_t bytesBudget)
+{
+    m_readingsPublishMode = mode;
+    m_readingsBudget = readingsBudget;
+    m_bytesBudget = bytesBudget;
 }
 
 const Protocol& DataService::getProtocol()
@@ -405,19 +609,23 @@ void DataService::messageReceived(std::shared_ptr<Message> message)
     {
     case MessageType::FEED_VALUES:
     {
-        auto feedValuesMessage = m_protocol.parseFeedValues(message);
+        auto feedValuesMessage = std::shared_ptr<const FeedValuesMessage>{m_protocol.parseFeedValues(message)};
         if (feedValuesMessage == nullptr)
             LOG(WARN) << "Unable to parse message: " << message->getChannel();
         else if (m_feedUpdateHandler)
-            m_feedUpdateHandler(deviceKey, feedValuesMessage->getReadings());
+            m_feedUpdateHandler(deviceKey, SharedFeedValues{feedValuesMessage, &feedValuesMessage->getReadings()});
         return;
     }
     case MessageType::PARAMETER_SYNC:
     {
         auto parameterMessage = m_protocol.parseParameters(message);
         if (parameterMessage == nullptr)
+        {
             LOG(WARN) << "Unable to parse message: " << message->getChannel();
-        else if (checkIfSubscriptionIsWaiting(*parameterMessage))    // It's important to first check this
+            return;
+        }
+        rememberParameters(deviceKey, parameterMessage->getParameters());
+        if (checkIfSubscriptionIsWaiting(deviceKey, *parameterMessage))    // It's important to first check this
             return;
         else if (m_parameterSyncHandler)
             m_parameterSyncHandler(deviceKey, parameterMessage->getParameters());
@@ -429,7 +637,7 @@ void DataService::messageReceived(std::shared_ptr<Message> message)
         auto detailsSynchronization = m_protocol.parseDetails(message);
         if (detailsSynchronization == nullptr)
             LOG(WARN) << "Unable to parse message: " << message->getChannel();
-        else if (checkIfCallbackIsWaiting(*detailsSynchronization))
+        else if (checkIfCallbackIsWaiting(deviceKey, *detailsSynchronization))
             return;
         else if (m_detailsSyncHandler)
             m_detailsSyncHandler(deviceKey, detailsSynchronization->getFeeds(),
@@ -443,122 +651,481 @@ void DataService::messageReceived(std::shared_ptr<Message> message)
     }
 }
 
-std::string DataService::makePersistenceKey(const std::string& deviceKey, const std::string& reference)
+const std::string& DataService::persistenceKeyOf(const std::string& deviceKey, const std::string& reference)
 {
-    return deviceKey + PERSISTENCE_KEY_DELIMITER + reference;
+    return m_persistenceKeys.intern(deviceKey, reference).getKey();
 }
 
-std::pair<std::string, std::string> DataService::parsePersistenceKey(const std::string& key)
+std::pair<std::string, std::string> DataService::resolvePersistenceKey(const std::string& key)
 {
-    auto pos = key.find(PERSISTENCE_KEY_DELIMITER);
-    if (pos == std::string::npos)
-    {
+    const auto persistenceKey = m_persistenceKeys.resolve(key);
+    if (persistenceKey == nullptr)
         return {"", ""};
-    }
+    return {persistenceKey->getDeviceKey(), persistenceKey->getReference()};
+}
+
+std::string DataService::makeSubscriptionKey(const std::string& deviceKey, std::vector<ParameterName> parameters)
+{
+    // The device key is prefixed with its length, so no device key and parameter names can make up the same key
+    std::sort(parameters.begin(), parameters.end());
+    parameters.erase(std::unique(parameters.begin(), parameters.end()), parameters.end());
+    auto key = std::to_string(deviceKey.size()) + ":" + deviceKey;
+    for (const auto& parameter : parameters)
+        key += "," + std::to_string(static_cast<int>(parameter));
+    return key;
+}
+
+void DataService::addParameterSubscription(const std::string& deviceKey, const std::vector<ParameterName>& parameters,
+                                           std::function<void(std::vector<Parameter>)> callback)
+{
+    const auto now = std::chrono::steady_clock::now();
+    auto key = makeSubscriptionKey(deviceKey, parameters);
+
+    std::lock_guard<std::mutex> lockGuard{m_subscriptionMutex};
+    removeExpiredSubscriptions(now);
+    const auto id = m_iterator++;
+    const auto deadline = now + m_subscriptionTimeout;
+    m_parameterSubscriptions[key].emplace_back(ParameterSubscription{id, std::move(callback), deadline});
+    m_subscriptionDeadlines.emplace(deadline, std::make_pair(std::move(key), id));
+}
 
-    auto deviceKey = key.substr(0, pos);
-    auto reference = key.substr(pos + PERSISTENCE_KEY_DELIMITER.size(), std::string::npos);
-    return {deviceKey, reference};
+void DataService::removeExpiredSubscriptions(std::chrono::steady_clock::time_point now)
+{
+    while (!m_subscriptionDeadlines.empty() && m_subscriptionDeadlines.begin()->first <= now)
+    {
+        const auto& entry = m_subscriptionDeadlines.begin()->second;
+        const auto it = m_parameterSubscriptions.find(entry.first);
+        if (it != m_parameterSubscriptions.cend())
+        {
+            auto& subscriptions = it->second;
+            subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                               [&](const ParameterSubscription& subscription) {
+                                                   return subscription.id == entry.second;
+                                               }),
+                                subscriptions.end());
+            if (subscriptions.empty())
+                m_parameterSubscriptions.erase(it);
+            LOG(WARN) << "Parameter synchronization has timed out - Dropping the callback.";
+        }
+        m_subscriptionDeadlines.erase(m_subscriptionDeadlines.begin());
+    }
 }
 
-bool DataService::checkIfSubscriptionIsWaiting(const ParametersUpdateMessage& parameterMessage)
+bool DataService::checkIfSubscriptionIsWaiting(const std::string& deviceKey,
+                                               const ParametersUpdateMessage& parameterMessage)
 {
     LOG(TRACE) << METHOD_INFO;
 
-    // Check if there's a subscription waiting for those parameters
+    const auto& values = parameterMessage.getParameters();
+    auto names = std::vector<ParameterName>{};
+    names.reserve(values.size());
+    for (const auto& parameter : values)
+        names.emplace_back(parameter.first);
+    const auto key = makeSubscriptionKey(deviceKey, std::move(names));
+
+    // Check if there's a subscription waiting for those parameters, and take the oldest one
+    auto callback = std::function<void(std::vector<Parameter>)>{};
     {
         std::lock_guard<std::mutex> lockGuard{m_subscriptionMutex};
-        for (const auto& subscription : m_parameterSubscriptions)
+        removeExpiredSubscriptions(std::chrono::steady_clock::now());
+        const auto it = m_parameterSubscriptions.find(key);
+        if (it == m_parameterSubscriptions.cend())
+            return false;
+
+        auto subscription = std::move(it->second.front());
+        it->second.pop_front();
+        if (it->second.empty())
+            m_parameterSubscriptions.erase(it);
+        const auto range = m_subscriptionDeadlines.equal_range(subscription.deadline);
+        for (auto deadline = range.first; deadline != range.second; ++deadline)
         {
-            // Check if the list of parameters is the same length, and then content
-            const auto& parameters = subscription.second.parameters;
-            const auto& values = parameterMessage.getParameters();
-            if (parameterMessage.getParameters().size() != parameters.size())
+            if (deadline->second.second == subscription.id)
             {
-                continue;
-            }
-            auto allNamesMatching = std::all_of(parameters.cbegin(), parameters.cend(), [&](const ParameterName& name) {
-                return std::find_if(values.begin(), values.end(), [&](const Parameter& parameter) {
-                           return parameter.first == name;
-                       }) != values.cend();
-            });
-            if (!allNamesMatching)
-            {
-                continue;
+                m_subscriptionDeadlines.erase(deadline);
+                break;
             }
+        }
+        callback = std::move(subscription.callback);
+    }
 
-            // Then we found the ones for the subscription!
-            const auto callback = std::move(subscription.second.callback);
+    // Invoke the subscription
+    if (callback)
+    {
+        m_commandBuffer.pushCommand(
+          std::make_shared<std::function<void()>>([callback, values]() { callback(values); }));
+        return true;
+    }
+    return false;
+}
 
-            // And we can clear the subscription
-            m_parameterSubscriptions.erase(subscription.first);
+void DataService::addDetailsCallback(const std::string& deviceKey,
+                                     std::function<void(std::vector<std::string>, std::vector<std::string>)> callback)
+{
+    const auto now = std::chrono::steady_clock::now();
 
-            // Invoke the subscription
-            if (callback)
-            {
-                m_commandBuffer.pushCommand(
-                  std::make_shared<std::function<void()>>([callback, values]() { callback(values); }));
-                return true;
-            }
-            return false;
+    std::lock_guard<std::mutex> lock{m_detailsMutex};
+    removeExpiredDetailsCallbacks(now);
+    const auto id = m_detailsIterator++;
+    const auto deadline = now + DETAILS_CALLBACK_TIMEOUT;
+    m_detailsCallbacks[deviceKey].emplace_back(DetailsCallback{id, std::move(callback), deadline});
+    m_detailsDeadlines.emplace(deadline, std::make_pair(deviceKey, id));
+}
+
+void DataService::removeExpiredDetailsCallbacks(std::chrono::steady_clock::time_point now)
+{
+    while (!m_detailsDeadlines.empty() && m_detailsDeadlines.begin()->first <= now)
+    {
+        const auto& entry = m_detailsDeadlines.begin()->second;
+        const auto it = m_detailsCallbacks.find(entry.first);
+        if (it != m_detailsCallbacks.cend())
+        {
+            auto& callbacks = it->second;
+            callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(),
+                                           [&](const DetailsCallback& details) { return details.id == entry.second; }),
+                            callbacks.end());
+            if (callbacks.empty())
+                m_detailsCallbacks.erase(it);
+            LOG(WARN) << "Details synchronization for device '" << entry.first
+                      << "' has timed out - Dropping the callback.";
         }
+        m_detailsDeadlines.erase(m_detailsDeadlines.begin());
     }
-    return false;
 }
 
-bool DataService::checkIfCallbackIsWaiting(const DetailsSynchronizationResponseMessage& synchronizationResponseMessage)
+bool DataService::checkIfCallbackIsWaiting(const std::string& deviceKey,
+                                           const DetailsSynchronizationResponseMessage& synchronizationResponseMessage)
 {
     LOG(TRACE) << METHOD_INFO;
 
+    // The responses of a device arrive in the order of requests, so they are handed to its oldest callback
+    auto callback = std::function<void(std::vector<std::string>, std::vector<std::string>)>{};
     {
         std::lock_guard<std::mutex> lock{m_detailsMutex};
-        if (!m_detailsCallbacks.empty())
+        removeExpiredDetailsCallbacks(std::chrono::steady_clock::now());
+        const auto it = m_detailsCallbacks.find(deviceKey);
+        if (it == m_detailsCallbacks.cend())
+            return false;
+
+        auto details = std::move(it->second.front());
+        it->second.pop_front();
+        if (it->second.empty())
+            m_detailsCallbacks.erase(it);
+        const auto range = m_detailsDeadlines.equal_range(details.deadline);
+        for (auto deadline = range.first; deadline != range.second; ++deadline)
+        {
+            if (deadline->second.second == details.id)
+            {
+                m_detailsDeadlines.erase(deadline);
+                break;
+            }
+        }
+        callback = std::move(details.callback);
+    }
+
+    m_commandBuffer.pushCommand(std::make_shared<std::function<void()>>([callback, synchronizationResponseMessage] {
+        callback(synchronizationResponseMessage.getFeeds(), synchronizationResponseMessage.getAttributes());
+    }));
+    return true;
+}
+
+std::vector<std::pair<std::string, std::vector<std::string>>> DataService::groupReadingsKeys(
+  const std::vector<std::string>& persistenceKeys)
+{
+    auto groups = std::vector<std::pair<std::string, std::vector<std::string>>>{};
+    if (m_readingsPublishMode == ReadingsPublishMode::PerFeed)
+    {
+        for (const auto& key : persistenceKeys)
+            groups.emplace_back(resolvePersistenceKey(key).first, std::vector<std::string>{key});
+        return groups;
+    }
+
+    // Group up all the persistence keys by the device they belong to
+    auto keysByDevice = std::map<std::string, std::vector<std::string>>{};
+    for (const auto& key : persistenceKeys)
+    {
+        auto deviceKey = resolvePersistenceKey(key).first;
+        if (deviceKey.empty())
         {
-            const auto callback = m_detailsCallbacks.front();
-            m_commandBuffer.pushCommand(
-              std::make_shared<std::function<void()>>([callback, synchronizationResponseMessage] {
-                  callback(synchronizationResponseMessage.getFeeds(), synchronizationResponseMessage.getAttributes());
-              }));
-            m_detailsCallbacks.pop();
-            return true;
+            LOG(ERROR) << "Unable to create message from readings: The device key is empty.";
+            continue;
         }
+        keysByDevice[deviceKey].emplace_back(key);
     }
-    return false;
+    for (auto& deviceKeys : keysByDevice)
+        groups.emplace_back(deviceKeys.first, std::move(deviceKeys.second));
+    return groups;
 }
 
-void DataService::publishReadingsForPersistenceKey(const std::string& persistenceKey)
+bool DataService::publishReadingsBatch(const std::string& deviceKey, const std::vector<std::string>& persistenceKeys,
+                                       PublishSliceResult& result)
 {
     LOG(TRACE) << METHOD_INFO;
 
-    // Read all information from persistence
+    // Take readings from the persistence keys, until we run out of readings or the budget is spent. Only taking and
+    // removing them is done under the lock, so storing readings is not held up while the message is being published.
+    const auto batchSize = m_batchSizeController.getBatchSize();
     auto readings = std::vector<Reading>{};
-    for (const auto& readingFromPersistence : m_persistence.getReadings(persistenceKey, PUBLISH_BATCH_ITEMS_COUNT))
-        readings.emplace_back(*readingFromPersistence);
+    auto takenReadings = std::vector<std::pair<std::string, std::uint64_t>>{};
+    auto size = std::uint64_t{0};
+    std::unique_lock<std::mutex> lock{m_readingsMutex};
+    for (const auto& persistenceKey : persistenceKeys)
+    {
+        const auto readingsFromPersistence = m_persistence.getReadings(persistenceKey, batchSize);
+        if (readingsFromPersistence.empty())
+            unindexReadingsKey(deviceKey, persistenceKey);
+        auto taken = std::uint64_t{0};
+        for (const auto& readingFromPersistence : readingsFromPersistence)
+        {
+            const auto readingSize = estimateReadingSize(*readingFromPersistence);
+            if (!readings.empty() && ((m_readingsBudget != 0 && readings.size() >= m_readingsBudget) ||
+                                      (m_bytesBudget != 0 && size + readingSize > m_bytesBudget)))
+                break;
+            readings.emplace_back(*readingFromPersistence);
+            size += readingSize;
+            ++taken;
+        }
+        if (taken > 0)
+            takenReadings.emplace_back(persistenceKey, taken);
+        if (taken < readingsFromPersistence.size())
+            break;
+    }
+    lock.unlock();
     if (readings.empty())
-        return;
-    auto deviceKey = std::string{};
-    auto reference = std::string{};
-    std::tie(deviceKey, reference) = parsePersistenceKey(persistenceKey);
+        return false;
 
-    // Check the device key and the reference
+    // Check the device key
     if (deviceKey.empty())
     {
         LOG(ERROR) << "Unable to create message from readings: The device key is empty.";
-        return;
+        return false;
     }
-    // Create the message
-    const auto outboundMessage =
+
+    // Make a lambda that will delete all the taken readings from persistence, which are in the order they were taken
+    auto deleteTakenReadings = [&]() {
+        std::lock_guard<std::mutex> removeLock{m_readingsMutex};
+        auto first = readings.cbegin();
+        for (const auto& keyAndCount : takenReadings)
+        {
+            removeTakenReadings(keyAndCount.first, first, keyAndCount.second);
+            first += static_cast<std::ptrdiff_t>(keyAndCount.second);
+        }
+    };
+
+    // Create the message, and if it does not fit in a packet, send out less readings
+    auto outboundMessage =
       std::shared_ptr<Message>{m_protocol.makeOutboundMessage(deviceKey, FeedValuesMessage{readings})};
+    const auto maxPacketSize = m_batchSizeController.getMaxPacketSize();
+    while (outboundMessage != nullptr && maxPacketSize != 0 && outboundMessage->getContent().size() > maxPacketSize &&
+           readings.size() > 1)
+    {
+        const auto payloadSize = static_cast<std::uint64_t>(outboundMessage->getContent().size());
+        m_batchSizeController.reportOversized(readings.size(), payloadSize);
+        auto keep = std::max<std::uint64_t>(readings.size() * maxPacketSize / payloadSize, 1);
+        keep = std::min<std::uint64_t>(keep, readings.size() - 1);
+        readings.erase(readings.begin() + static_cast<std::ptrdiff_t>(keep), readings.end());
+        for (auto it = takenReadings.begin(); it != takenReadings.end();)
+        {
+            it->second = std::min(it->second, keep);
+            keep -= it->second;
+            it = it->second == 0 ? takenReadings.erase(it) : it + 1;
+        }
+        outboundMessage =
+          std::shared_ptr<Message>{m_protocol.makeOutboundMessage(deviceKey, FeedValuesMessage{readings})};
+    }
     if (!outboundMessage)
     {
-        LOG(ERROR) << "Unable to create message from readings: " << persistenceKey;
-        m_persistence.removeReadings(persistenceKey, PUBLISH_BATCH_ITEMS_COUNT);
+        LOG(ERROR) << "Unable to create message from readings for device: " << deviceKey;
+        deleteTakenReadings();
+        return false;
+    }
+    if (!m_connectivityService.publish(outboundMessage))
+    {
+        m_batchSizeController.reportFailure();
+        ++result.failedMessages;
+        return false;
+    }
+    deleteTakenReadings();
+    m_batchSizeController.reportSuccess(readings.size(), outboundMessage->getContent().size());
+    ++result.sentMessages;
+    result.sentBytes += outboundMessage->getContent().size();
+    result.sentReadings += readings.size();
+    return true;
+}
+
+void DataService::removeTakenReadings(const std::string& persistenceKey, std::vector<Reading>::const_iterator taken,
+                                      std::uint64_t count)
+{
+    // In the usual case, nothing was evicted since the readings were taken, and they are still at the front
+    const auto front = m_persistence.getReadings(persistenceKey, 1);
+    if (front.empty())
+        return;
+    if (isSameReading(*front.front(), *taken))
+    {
+        m_persistence.removeReadings(persistenceKey, count);
+        return;
+    }
+
+    // Evictions only drop the oldest readings, so the taken readings that are left are the front of the key
+    const auto stored = m_persistence.getReadings(persistenceKey, count);
+    for (auto evicted = std::uint64_t{1}; evicted < count; ++evicted)
+    {
+        const auto left = count - evicted;
+        if (stored.size() < left)
+            continue;
+        auto matches = true;
+        for (auto i = std::uint64_t{0}; i < left && matches; ++i)
+            matches = isSameReading(*stored[static_cast<std::size_t>(i)],
+                                    *(taken + static_cast<std::ptrdiff_t>(evicted + i)));
+        if (matches)
+        {
+            m_persistence.removeReadings(persistenceKey, left);
+            return;
+        }
+    }
+}
+
+void DataService::indexReadingsKey(const std::string& deviceKey, const std::string& persistenceKey)
+{
+    // Insert only makes a copy of the key if it's not already in the set
+    std::lock_guard<std::mutex> lock{m_readingsIndexMutex};
+    m_readingsIndex[deviceKey].insert(persistenceKey);
+}
+
+void DataService::unindexReadingsKey(const std::string& deviceKey, const std::string& persistenceKey)
+{
+    std::lock_guard<std::mutex> lock{m_readingsIndexMutex};
+    auto it = m_readingsIndex.find(deviceKey);
+    if (it == m_readingsIndex.cend())
+        return;
+    it->second.erase(persistenceKey);
+    if (it->second.empty())
+        m_readingsIndex.erase(it);
+}
+
+std::vector<std::string> DataService::getIndexedReadingsKeys(const std::string& deviceKey)
+{
+    std::lock_guard<std::mutex> lock{m_readingsIndexMutex};
+
+    // The persistence might already hold readings from before, so it needs to be looked through once
+    if (!m_readingsIndexSeeded)
+    {
+        for (const auto& key : m_persistence.getReadingsKeys())
+            m_readingsIndex[resolvePersistenceKey(key).first].emplace(key);
+        m_readingsIndexSeeded = true;
+    }
+
+    auto it = m_readingsIndex.find(deviceKey);
+    if (it == m_readingsIndex.cend())
+        return {};
+    return {it->second.cbegin(), it->second.cend()};
+}
+
+void DataService::seedAttributeBuckets()
+{
+    if (m_attributeBucketsSeeded)
+        return;
+
+    // A value already in a bucket was added after the persistence was read, so it is the newer one
+    for (const auto& attribute : m_persistence.getAttributes())
+        m_attributeBuckets[resolvePersistenceKey(attribute.first).first].emplace(attribute.first, attribute.second);
+    m_attributeBucketsSeeded = true;
+}
+
+void DataService::seedParameterBuckets()
+{
+    if (m_parameterBucketsSeeded)
         return;
+
+    // A value already in a bucket was added after the persistence was read, so it is the newer one
+    for (const auto& parameter : m_persistence.getParameters())
+        m_parameterBuckets[resolvePersistenceKey(parameter.first).first].emplace(parameter.first, parameter.second);
+    m_parameterBucketsSeeded = true;
+}
+
+bool DataService::publishAttributeBucket(const std::string& deviceKey,
+                                         const std::map<std::string, std::shared_ptr<Attribute>>& attributes)
+{
+    if (attributes.empty())
+        return true;
+
+    // Make a lambda that will delete all these attributes from persistence and the bucket
+    auto deleteAllAttributes = [&]() {
+        for (const auto& attribute : attributes)
+            m_persistence.removeAttributes(attribute.first);
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        const auto it = m_attributeBuckets.find(deviceKey);
+        if (it == m_attributeBuckets.cend())
+            return;
+        for (const auto& attribute : attributes)
+            it->second.erase(attribute.first);
+        if (it->second.empty())
+            m_attributeBuckets.erase(it);
+    };
+
+    // Form the message
+    auto values = std::vector<Attribute>{};
+    for (const auto& attribute : attributes)
+        values.emplace_back(*attribute.second);
+    auto outboundMessage =
+      std::shared_ptr<Message>(m_protocol.makeOutboundMessage(deviceKey, AttributeRegistrationMessage(values)));
+    if (!outboundMessage)
+    {
+        LOG(ERROR) << "Unable to create message from attributes";
+        deleteAllAttributes();
+        return false;
+    }
+    if (m_connectivityService.publish(outboundMessage))
+        deleteAllAttributes();
+    return true;
+}
+
+bool DataService::publishParameterBucket(const std::string& deviceKey,
+                                         const std::map<std::string, Parameter>& parameters)
+{
+    if (parameters.empty())
+        return true;
+
+    // Make a lambda that will delete all these parameters from persistence and the bucket
+    auto deleteAllParameters = [&]() {
+        for (const auto& parameter : parameters)
+            m_persistence.removeParameters(parameter.first);
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        const auto it = m_parameterBuckets.find(deviceKey);
+        if (it == m_parameterBuckets.cend())
+            return;
+        for (const auto& parameter : parameters)
+            it->second.erase(parameter.first);
+        if (it->second.empty())
+            m_parameterBuckets.erase(it);
+    };
+
+    // Form the message
+    auto values = std::vector<Parameter>{};
+    for (const auto& parameter : parameters)
+        values.emplace_back(parameter.second);
+    auto outboundMessage =
+      std::shared_ptr<Message>(m_protocol.makeOutboundMessage(deviceKey, ParametersUpdateMessage(values)));
+    if (!outboundMessage)
+    {
+        LOG(ERROR) << "Unable to create message from parameters";
+        deleteAllParameters();
+        return false;
     }
     if (m_connectivityService.publish(outboundMessage))
     {
-        m_persistence.removeReadings(persistenceKey, PUBLISH_BATCH_ITEMS_COUNT);
-        publishReadingsForPersistenceKey(persistenceKey);
+        rememberParameters(deviceKey, values);
+        deleteAllParameters();
+    }
+    return true;
+}
+
+void DataService::rememberParameters(const std::string& deviceKey, const std::vector<Parameter>& parameters)
+{
+    for (const auto& parameter : parameters)
+    {
+        const auto& persistenceKey = persistenceKeyOf(deviceKey, toString(parameter.first));
+        std::lock_guard<std::mutex> lock{m_bucketsMutex};
+        m_sentParameters[persistenceKey] = parameter.second;
     }
 }
 }    // namespace connect
@@ -22,12 +22,23 @@
 #include "core/model/Attribute.h"
 #include "core/model/Feed.h"
 #include "core/model/Reading.h"
-#include "core/utilities/CommandBuffer.h"
+#include "wolk/WorkerPool.h"
+#include "wolk/service/data/BatchSizeController.h"
+#include "wolk/service/data/FeedAggregation.h"
+#include "wolk/service/data/FeedFilter.h"
+#include "wolk/service/data/PersistenceKey.h"
+#include "wolk/service/data/PublishBudget.h"
+#include "wolk/service/data/ReadingsPublishMode.h"
 
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace wolkabout
@@ -42,9 +53,15 @@ class OutboundRetryMessageHandler;
 
 namespace connect
 {
-using FeedUpdateSetHandler = std::function<void(std::string, std::map<std::uint64_t, std::vector<Reading>>)>;
+class BatchPersistence;
+
+// Here is a read-only view of inbound feed values, that shares the ownership of the message they were parsed from
+using SharedFeedValues = std::shared_ptr<const std::map<std::uint64_t, std::vector<Reading>>>;
+
+using FeedUpdateSetHandler = std::function<void(std::string, SharedFeedValues)>;
 using ParameterSyncHandler = std::function<void(std::string, std::vector<Parameter>)>;
 using DetailsSyncHandler = std::function<void(std::string, std::vector<std::string>, std::vector<std::string>)>;
+using ReadingsAddedListener = std::function<void(std::uint64_t, std::uint64_t)>;
 
 class DataService : public MessageListener
 {
@@ -61,12 +78,58 @@ public:
     virtual void addReading(const std::string& deviceKey, const Reading& reading);
     virtual void addReadings(const std::string& deviceKey, const std::vector<Reading>& readings);
 
+    /**
+     * This method stores many readings at once. The readings are grouped by reference, and every group is handed to
+     * the persistence in one call if it implements `BatchPersistence`.
+     *
+     * @param deviceKey The device key.
+     * @param readings The readings, which are moved from. The order of readings of a single reference is kept.
+     */
+    virtual void addReadings(const std::string& deviceKey, std::vector<Reading>&& readings);
+
     virtual void addAttribute(const std::string& deviceKey, const Attribute& attribute);
+
+    /**
+     * This method stores a parameter value to be published. A value that is the same as the last one published, or
+     * received from the platform, is not stored again, so only the parameters that changed are sent out.
+     *
+     * @param deviceKey The device key.
+     * @param parameter The parameter.
+     */
     virtual void updateParameter(const std::string& deviceKey, const Parameter& parameter);
 
     virtual void registerFeed(const std::string& deviceKey, Feed feed);
     virtual void registerFeeds(const std::string& deviceKey, std::vector<Feed> feed);
 
+    /**
+     * This method sets the filter that decides which readings of a feed are stored. It replaces the previous filter
+     * of the feed, and a filter with no rules removes it. The filter is also removed when the feed is removed.
+     *
+     * @param deviceKey The device key.
+     * @param reference The feed reference.
+     * @param filter The filter.
+     */
+    virtual void setFeedFilter(const std::string& deviceKey, const std::string& reference, const FeedFilter& filter);
+
+    /**
+     * This method sets the aggregation of a feed. Its numeric readings are then rolled up into time windows, and a
+     * single reading with the statistics is stored for every window, once the window is over. The window that is open
+     * is closed when the aggregation is replaced, and dropped when the feed is removed.
+     *
+     * @param deviceKey The device key.
+     * @param reference The feed reference.
+     * @param aggregation The aggregation. An aggregation without a window or statistics removes it.
+     */
+    virtual void setFeedAggregation(const std::string& deviceKey, const std::string& reference,
+                                    const FeedAggregation& aggregation);
+
+    /**
+     * This method stores the readings of all aggregation windows that are over. It is invoked before readings are
+     * published, and on the command buffer after every tick of the publish scheduler, for feeds that don't get a
+     * reading after every window.
+     */
+    virtual void closeAggregationWindows();
+
     virtual void removeFeed(const std::string& deviceKey, std::string reference);
     virtual void removeFeeds(const std::string& deviceKey, std::vector<std::string> feeds);
 
@@ -81,29 +144,129 @@ public:
     virtual void publishReadings();
     virtual void publishReadings(const std::string& deviceKey);
 
+    /**
+     * This method publishes readings from persistence until everything is sent out, or the budget is spent. Feeds
+     * (or devices in `PerDevice` mode) are served in round-robin fashion, one batch at a time, so a single large
+     * backlog can not starve the others.
+     *
+     * @param budget The limits for this slice.
+     * @return The outcome of the slice. If `backlogRemaining` is set, the caller should schedule another slice.
+     */
+    virtual PublishSliceResult publishReadingsSlice(const PublishBudget& budget);
+
     virtual void publishAttributes();
     virtual void publishAttributes(const std::string& deviceKey);
 
     virtual void publishParameters();
     virtual void publishParameters(const std::string& deviceKey);
 
+    /**
+     * This is the setter for the way the readings are packed into outgoing messages.
+     *
+     * @param mode The publish mode.
+     * @param readingsBudget The maximum count of readings in a single message. 0 means unlimited.
+     * @param bytesBudget The maximum estimated size of the readings in a single message. 0 means unlimited.
+     */
+    void setReadingsPublishMode(ReadingsPublishMode mode, std::uint64_t readingsBudget = 0,
+                                std::uint64_t bytesBudget = 0);
+
+    /**
+     * This is the setter for the controller that decides how many readings are taken from persistence for a message.
+     *
+     * @param controller The batch size controller, either in fixed or adaptive mode.
+     */
+    void setBatchSizeController(const BatchSizeController& controller);
+
+    /**
+     * This is the setter for the listener that is notified every time readings are stored into persistence. Readings
+     * that are taken into an aggregation window are reported as well, as they will be published through it.
+     *
+     * @param listener The listener, receiving the count and the estimated size of stored readings.
+     */
+    void setReadingsAddedListener(ReadingsAddedListener listener);
+
+    /**
+     * This is the setter for how long a parameter synchronization waits for its response. Once the time is up, the
+     * callback is dropped, and the response (if it ever arrives) is handled as a regular parameter update.
+     *
+     * @param timeout The timeout.
+     */
+    void setParameterSubscriptionTimeout(std::chrono::milliseconds timeout);
+
     const Protocol& getProtocol() override;
 
     void messageReceived(std::shared_ptr<Message> message) override;
 
 private:
-    static std::string makePersistenceKey(const std::string& deviceKey, const std::string& reference);
+    const std::string& persistenceKeyOf(const std::string& deviceKey, const std::string& reference);
+
+    std::pair<std::string, std::string> resolvePersistenceKey(const std::string& key);
+
+    static std::string makeSubscriptionKey(const std::string& deviceKey, std::vector<ParameterName> parameters);
+
+    void addParameterSubscription(const std::string& deviceKey, const std::vector<ParameterName>& parameters,
+                                  std::function<void(std::vector<Parameter>)> callback);
+
+    void removeExpiredSubscriptions(std::chrono::steady_clock::time_point now);
+
+    bool checkIfSubscriptionIsWaiting(const std::string& deviceKey, const ParametersUpdateMessage& parameterMessage);
+
+    void addDetailsCallback(const std::string& deviceKey,
+                            std::function<void(std::vector<std::string>, std::vector<std::string>)> callback);
+
+    void removeExpiredDetailsCallbacks(std::chrono::steady_clock::time_point now);
+
+    bool checkIfCallbackIsWaiting(const std::string& deviceKey,
+                                  const DetailsSynchronizationResponseMessage& synchronizationResponseMessage);
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> groupReadingsKeys(
+      const std::vector<std::string>& persistenceKeys);
+
+    PublishSliceResult publishReadingsGroups(
+      const std::vector<std::pair<std::string, std::vector<std::string>>>& groups, const PublishBudget& budget);
 
-    static std::pair<std::string, std::string> parsePersistenceKey(const std::string& key);
+    // Both are called with the buckets lock held, and read the persistence only the first time
+    void seedAttributeBuckets();
 
-    bool checkIfSubscriptionIsWaiting(const ParametersUpdateMessage& parameterMessage);
+    void seedParameterBuckets();
 
-    bool checkIfCallbackIsWaiting(const DetailsSynchronizationResponseMessage& synchronizationResponseMessage);
+    bool publishAttributeBucket(const std::string& deviceKey,
+                                const std::map<std::string, std::shared_ptr<Attribute>>& attributes);
 
-    void publishReadingsForPersistenceKey(const std::string& persistenceKey);
+    bool publishParameterBucket(const std::string& deviceKey, const std::map<std::string, Parameter>& parameters);
+
+    void rememberParameters(const std::string& deviceKey, const std::vector<Parameter>& parameters);
+
+    void indexReadingsKey(const std::string& deviceKey, const std::string& persistenceKey);
+
+    void unindexReadingsKey(const std::string& deviceKey, const std::string& persistenceKey);
+
+    std::vector<std::string> getIndexedReadingsKeys(const std::string& deviceKey);
+
+    bool publishReadingsBatch(const std::string& deviceKey, const std::vector<std::string>& persistenceKeys,
+                              PublishSliceResult& result);
+
+    void removeTakenReadings(const std::string& persistenceKey, std::vector<Reading>::const_iterator taken,
+                             std::uint64_t count);
+
+    void storeReadings(const std::string& deviceKey, const std::string& persistenceKey, std::vector<Reading>& readings,
+                       std::uint64_t& count, std::uint64_t& bytes);
+
+    bool passesFeedFilter(const std::string& persistenceKey, const Reading& reading);
+
+    bool isAggregated(const std::string& persistenceKey);
+
+    void aggregateReadings(const std::string& persistenceKey, std::vector<Reading>& readings, std::uint64_t& count,
+                           std::uint64_t& bytes);
+
+    static std::uint64_t currentTimestamp();
+
+    void notifyReadingsAdded(std::uint64_t count, std::uint64_t bytes);
 
     DataProtocol& m_protocol;
     Persistence& m_persistence;
+    // Here is the persistence as a `BatchPersistence`, if it is one
+    BatchPersistence* m_batchPersistence;
     ConnectivityService& m_connectivityService;
     OutboundRetryMessageHandler& m_outboundRetryMessageHandler;
 
@@ -111,21 +274,68 @@ private:
     ParameterSyncHandler m_parameterSyncHandler;
     DetailsSyncHandler m_detailsSyncHandler;
 
-    CommandBuffer m_commandBuffer;
+    ReadingsPublishMode m_readingsPublishMode;
+    std::uint64_t m_readingsBudget;
+    std::uint64_t m_bytesBudget;
+    BatchSizeController m_batchSizeController;
+    ReadingsAddedListener m_readingsAddedListener;
+
+    // Here are the interned persistence keys
+    PersistenceKeyRegistry m_persistenceKeys;
+
+    // Here is the lock held while readings are stored, and while a batch is taken, or removed once it is published
+    std::mutex m_readingsMutex;
+
+    // Here is the index of persistence keys that hold readings for every device
+    std::mutex m_readingsIndexMutex;
+    bool m_readingsIndexSeeded;
+    std::map<std::string, std::set<std::string>> m_readingsIndex;
+
+    // Here are the filters of feeds that have them, under their persistence keys
+    std::mutex m_feedFiltersMutex;
+    std::map<std::string, FeedFilterState> m_feedFilters;
+
+    // Here are the open aggregation windows of feeds that are aggregated, under their persistence keys
+    std::mutex m_aggregationsMutex;
+    std::map<std::string, AggregationWindow> m_aggregationWindows;
+
+    // Here are the attributes and parameters of every device, seeded once from persistence and kept in step with it
+    std::mutex m_bucketsMutex;
+    bool m_attributeBucketsSeeded;
+    bool m_parameterBucketsSeeded;
+    std::map<std::string, std::map<std::string, std::shared_ptr<Attribute>>> m_attributeBuckets;
+    std::map<std::string, std::map<std::string, Parameter>> m_parameterBuckets;
+    // Here are the values of parameters the platform is known to have, under their persistence keys
+    std::unordered_map<std::string, std::string> m_sentParameters;
+
+    SerialExecutor m_commandBuffer;
     struct ParameterSubscription
     {
-        std::vector<ParameterName> parameters;
+        std::uint64_t id;
         std::function<void(std::vector<Parameter>)> callback;
+        std::chrono::steady_clock::time_point deadline;
     };
     std::uint64_t m_iterator;
+    std::chrono::milliseconds m_subscriptionTimeout;
     std::mutex m_subscriptionMutex;
-    std::map<std::uint64_t, ParameterSubscription> m_parameterSubscriptions;
+    // Here are the subscriptions waiting for parameters, under the device key and the sorted parameter names
+    std::unordered_map<std::string, std::deque<ParameterSubscription>> m_parameterSubscriptions;
+    // Here are the keys and identifiers of subscriptions, in the order in which they time out
+    std::multimap<std::chrono::steady_clock::time_point, std::pair<std::string, std::uint64_t>>
+      m_subscriptionDeadlines;
 
+    struct DetailsCallback
+    {
+        std::uint64_t id;
+        std::function<void(std::vector<std::string>, std::vector<std::string>)> callback;
+        std::chrono::steady_clock::time_point deadline;
+    };
     std::mutex m_detailsMutex;
-    std::queue<std::function<void(std::vector<std::string>, std::vector<std::string>)>> m_detailsCallbacks;
-
-    static const std::string PERSISTENCE_KEY_DELIMITER;
-    static const constexpr unsigned int PUBLISH_BATCH_ITEMS_COUNT = 50;
+    std::uint64_t m_detailsIterator;
+    // Here are the callbacks waiting for details of every device, in the order in which they were requested
+    std::unordered_map<std::string, std::deque<DetailsCallback>> m_detailsCallbacks;
+    // Here are the device keys and identifiers of callbacks, in the order in which they time out
+    std::multimap<std::chrono::steady_clock::time_point, std::pair<std::string, std::uint64_t>> m_detailsDeadlines;
 };
 }    // namespace connect
 }    // namespace wolkabout
@@ -0,0 +1,102 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/service/data/FeedAggregation.h"
+
+#include "wolk/service/data/ReadingValue.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+namespace connect
+{
+AggregationWindow::AggregationWindow(const FeedAggregation& aggregation)
+: m_aggregation{aggregation}, m_start{0}, m_count{0}, m_sum{0.0}, m_min{0.0}, m_max{0.0}
+{
+}
+
+bool AggregationWindow::add(const Reading& reading, std::uint64_t fallbackTimestamp, std::vector<Reading>& closed)
+{
+    auto value = 0.0;
+    if (reading.isMulti() || !ReadingValue::parseNumber(reading.getStringValue(), value))
+        return false;
+
+    const auto length = static_cast<std::uint64_t>(m_aggregation.window.count());
+    const auto timestamp = reading.getTimestamp() != 0 ? reading.getTimestamp() : fallbackTimestamp;
+    const auto start = timestamp - timestamp % length;
+    if (m_count > 0 && start > m_start)
+        close(0, closed, true);
+
+    if (m_count == 0)
+    {
+        m_reference = reading.getReference();
+        m_start = start;
+        m_sum = 0.0;
+        m_min = value;
+        m_max = value;
+    }
+    ++m_count;
+    m_sum += value;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    return true;
+}
+
+bool AggregationWindow::close(std::uint64_t now, std::vector<Reading>& closed, bool force)
+{
+    if (m_count == 0 || (!force && now < m_start + static_cast<std::uint64_t>(m_aggregation.window.count())))
+        return false;
+
+    closed.emplace_back(makeReading());
+    m_count = 0;
+    return true;
+}
+
+const FeedAggregation& AggregationWindow::getAggregation() const
+{
+    return m_aggregation;
+}
+
+Reading AggregationWindow::makeReading() const
+{
+    auto values = std::vector<std::string>{};
+    values.reserve(m_aggregation.statistics.size());
+    for (const auto statistic : m_aggregation.statistics)
+    {
+        switch (statistic)
+        {
+        case AggregationStatistic::Min:
+            values.emplace_back(ReadingValue{m_min}.toString());
+            break;
+        case AggregationStatistic::Max:
+            values.emplace_back(ReadingValue{m_max}.toString());
+            break;
+        case AggregationStatistic::Average:
+            values.emplace_back(ReadingValue{m_sum / static_cast<double>(m_count)}.toString());
+            break;
+        case AggregationStatistic::Count:
+            values.emplace_back(ReadingValue{m_count}.toString());
+            break;
+        }
+    }
+
+    if (values.size() == 1)
+        return Reading{m_reference, values.front(), m_start};
+    return Reading{m_reference, values, m_start};
+}
+}    // namespace connect
+}    // namespace wolkabout
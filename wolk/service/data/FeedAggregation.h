@@ -0,0 +1,117 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_FEEDAGGREGATION_H
+#define WOLKABOUTCONNECTOR_FEEDAGGREGATION_H
+
+#include "core/model/Reading.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This enumeration describes the statistics that can be computed for a window of readings.
+ */
+enum class AggregationStatistic
+{
+    Min,
+    Max,
+    Average,
+    Count
+};
+
+/**
+ * This structure describes how the readings of a feed are rolled up into fixed time windows. For every window, a single
+ * reading is stored, holding the statistics in the order they are listed (or just the value, if there is only one).
+ */
+struct FeedAggregation
+{
+    FeedAggregation() = default;
+
+    FeedAggregation(std::chrono::milliseconds windowLength, std::vector<AggregationStatistic> windowStatistics)
+    : window{windowLength}, statistics{std::move(windowStatistics)}
+    {
+    }
+
+    bool isDisabled() const { return window.count() <= 0 || statistics.empty(); }
+
+    // The length of a window. Windows are aligned to multiples of the length since the epoch.
+    std::chrono::milliseconds window{0};
+    // The statistics stored for every window
+    std::vector<AggregationStatistic> statistics;
+};
+
+/**
+ * This is the window of a single feed of a device that is currently being aggregated. Adding a sample takes constant
+ * time, as only the count, sum, minimum and maximum are kept.
+ */
+class AggregationWindow
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param aggregation The aggregation this window belongs to.
+     */
+    explicit AggregationWindow(const FeedAggregation& aggregation);
+
+    /**
+     * This method adds a reading to the window. If the reading belongs to a later window, the current one is closed
+     * first. Readings that belong to an earlier window are counted in the current one.
+     *
+     * @param reading The reading.
+     * @param fallbackTimestamp The time used for readings without a timestamp (in milliseconds).
+     * @param closed The vector into which the reading of the closed window is added.
+     * @return Whether the reading was aggregated. Readings that are not single numeric values are not aggregated.
+     */
+    bool add(const Reading& reading, std::uint64_t fallbackTimestamp, std::vector<Reading>& closed);
+
+    /**
+     * This method closes the window, if it has ended.
+     *
+     * @param now The current time (in milliseconds).
+     * @param closed The vector into which the reading of the closed window is added.
+     * @param force Whether the window should be closed even if it has not ended yet.
+     * @return Whether the window was closed.
+     */
+    bool close(std::uint64_t now, std::vector<Reading>& closed, bool force = false);
+
+    const FeedAggregation& getAggregation() const;
+
+private:
+    Reading makeReading() const;
+
+    FeedAggregation m_aggregation;
+
+    // Here is the state of the open window
+    std::string m_reference;
+    std::uint64_t m_start;
+    std::uint64_t m_count;
+    double m_sum;
+    double m_min;
+    double m_max;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_FEEDAGGREGATION_H
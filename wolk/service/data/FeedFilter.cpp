@@ -0,0 +1,86 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/service/data/FeedFilter.h"
+
+#include "wolk/service/data/ReadingValue.h"
+
+#include <cmath>
+
+namespace wolkabout
+{
+namespace connect
+{
+FeedFilterState::FeedFilterState(const FeedFilter& filter)
+: m_filter{filter}, m_hasLast{false}, m_lastTimestamp{0}, m_lastIsNumber{false}, m_lastNumber{0.0}
+{
+}
+
+bool FeedFilterState::accept(const Reading& reading, std::uint64_t fallbackTimestamp)
+{
+    const auto timestamp = reading.getTimestamp() != 0 ? reading.getTimestamp() : fallbackTimestamp;
+    if (m_hasLast)
+    {
+        // Readings that come out of order are measured from the last stored one as if they came at the same time
+        const auto elapsed = timestamp > m_lastTimestamp ? timestamp - m_lastTimestamp : 0;
+        const auto heartbeatDue =
+          m_filter.heartbeat.count() > 0 && elapsed >= static_cast<std::uint64_t>(m_filter.heartbeat.count());
+        if (!heartbeatDue)
+        {
+            if (m_filter.minimumInterval.count() > 0 &&
+                elapsed < static_cast<std::uint64_t>(m_filter.minimumInterval.count()))
+                return false;
+            if (!isChangeSignificant(reading))
+                return false;
+        }
+    }
+
+    m_hasLast = true;
+    m_lastTimestamp = timestamp;
+    m_lastValues = reading.isMulti() ? reading.getStringValues() : std::vector<std::string>{reading.getStringValue()};
+    m_lastIsNumber = !reading.isMulti() && ReadingValue::parseNumber(m_lastValues.front(), m_lastNumber);
+    return true;
+}
+
+const FeedFilter& FeedFilterState::getFilter() const
+{
+    return m_filter;
+}
+
+bool FeedFilterState::isChangeSignificant(const Reading& reading) const
+{
+    const auto deadband = m_filter.absoluteDeadband > 0.0 || m_filter.percentDeadband > 0.0;
+    if (!deadband && !m_filter.reportOnChange)
+        return true;
+
+    // The deadbands only apply to single numeric values, other values are compared as they are
+    auto number = 0.0;
+    if (m_lastIsNumber && !reading.isMulti() && ReadingValue::parseNumber(reading.getStringValue(), number))
+    {
+        const auto difference = std::fabs(number - m_lastNumber);
+        if (m_filter.absoluteDeadband > 0.0 && difference < m_filter.absoluteDeadband)
+            return false;
+        if (m_filter.percentDeadband > 0.0 && difference < std::fabs(m_lastNumber) * m_filter.percentDeadband / 100.0)
+            return false;
+        return difference > 0.0;
+    }
+
+    if (reading.isMulti())
+        return reading.getStringValues() != m_lastValues;
+    return m_lastValues.size() != 1 || reading.getStringValue() != m_lastValues.front();
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,94 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_FEEDFILTER_H
+#define WOLKABOUTCONNECTOR_FEEDFILTER_H
+
+#include "core/model/Reading.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This structure describes which readings of a feed are worth storing. Every rule that is left at its default value
+ * is not used, and a filter with no rules lets every reading through.
+ */
+struct FeedFilter
+{
+    // A numeric reading is dropped if it differs from the last stored one by less than this
+    double absoluteDeadband = 0.0;
+    // A numeric reading is dropped if it differs from the last stored one by less than this percentage of it
+    double percentDeadband = 0.0;
+    // A reading is dropped if it comes sooner than this after the last stored one
+    std::chrono::milliseconds minimumInterval{0};
+    // A reading is dropped if its value is the same as the last stored one
+    bool reportOnChange = false;
+    // A reading is always stored if this much time has passed since the last stored one, even if it would be dropped
+    std::chrono::milliseconds heartbeat{0};
+
+    bool isDisabled() const
+    {
+        return absoluteDeadband <= 0.0 && percentDeadband <= 0.0 && minimumInterval.count() == 0 && !reportOnChange;
+    }
+};
+
+/**
+ * This is the state of a `FeedFilter` for a single feed of a device. It remembers the last reading that was let
+ * through.
+ */
+class FeedFilterState
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param filter The filter this state belongs to.
+     */
+    explicit FeedFilterState(const FeedFilter& filter);
+
+    /**
+     * This method decides whether a reading should be stored. If it should, the reading becomes the last stored one.
+     *
+     * @param reading The reading.
+     * @param fallbackTimestamp The time used for readings without a timestamp (in milliseconds).
+     * @return Whether the reading should be stored.
+     */
+    bool accept(const Reading& reading, std::uint64_t fallbackTimestamp);
+
+    const FeedFilter& getFilter() const;
+
+private:
+    bool isChangeSignificant(const Reading& reading) const;
+
+    FeedFilter m_filter;
+
+    // Here is what is known about the last stored reading
+    bool m_hasLast;
+    std::uint64_t m_lastTimestamp;
+    bool m_lastIsNumber;
+    double m_lastNumber;
+    std::vector<std::string> m_lastValues;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_FEEDFILTER_H
@@ -0,0 +1,149 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/service/data/PersistenceKey.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+namespace connect
+{
+const char PersistenceKeyRegistry::DELIMITER = '+';
+const char PersistenceKeyRegistry::ESCAPE = '\\';
+
+PersistenceKey::PersistenceKey(std::uint32_t deviceId, std::uint32_t referenceId, std::string deviceKey,
+                               std::string reference, std::string key)
+: m_deviceId{deviceId}
+, m_referenceId{referenceId}
+, m_deviceKey{std::move(deviceKey)}
+, m_reference{std::move(reference)}
+, m_key{std::move(key)}
+{
+}
+
+std::uint32_t PersistenceKey::getDeviceId() const
+{
+    return m_deviceId;
+}
+
+std::uint32_t PersistenceKey::getReferenceId() const
+{
+    return m_referenceId;
+}
+
+const std::string& PersistenceKey::getDeviceKey() const
+{
+    return m_deviceKey;
+}
+
+const std::string& PersistenceKey::getReference() const
+{
+    return m_reference;
+}
+
+const std::string& PersistenceKey::getKey() const
+{
+    return m_key;
+}
+
+const PersistenceKey& PersistenceKeyRegistry::intern(const std::string& deviceKey, const std::string& reference)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    // Look up the key without making any new strings
+    const auto device = m_keysByDevice.find(deviceKey);
+    if (device != m_keysByDevice.cend())
+    {
+        const auto key = device->second.find(reference);
+        if (key != device->second.cend())
+            return *key->second;
+    }
+    return emplace(deviceKey, reference, compose(deviceKey, reference));
+}
+
+const PersistenceKey* PersistenceKeyRegistry::resolve(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    const auto it = m_keys.find(key);
+    if (it != m_keys.cend())
+        return it->second.get();
+
+    auto deviceKey = std::string{};
+    auto reference = std::string{};
+    if (!decompose(key, deviceKey, reference))
+        return nullptr;
+    return &emplace(deviceKey, reference, key);
+}
+
+std::string PersistenceKeyRegistry::compose(const std::string& deviceKey, const std::string& reference)
+{
+    auto key = std::string{};
+    key.reserve(deviceKey.size() + reference.size() + 1);
+    for (const auto character : deviceKey)
+    {
+        if (character == DELIMITER || character == ESCAPE)
+            key.push_back(ESCAPE);
+        key.push_back(character);
+    }
+    key.push_back(DELIMITER);
+    key.append(reference);
+    return key;
+}
+
+bool PersistenceKeyRegistry::decompose(const std::string& key, std::string& deviceKey, std::string& reference)
+{
+    auto device = std::string{};
+    for (std::size_t i = 0; i < key.size(); ++i)
+    {
+        if (key[i] == ESCAPE && i + 1 < key.size())
+        {
+            device.push_back(key[++i]);
+        }
+        else if (key[i] == DELIMITER)
+        {
+            deviceKey = std::move(device);
+            reference = key.substr(i + 1);
+            return true;
+        }
+        else
+        {
+            device.push_back(key[i]);
+        }
+    }
+    return false;
+}
+
+const PersistenceKey& PersistenceKeyRegistry::emplace(const std::string& deviceKey, const std::string& reference,
+                                                      std::string key)
+{
+    auto deviceId = m_deviceIds.emplace(deviceKey, static_cast<std::uint32_t>(m_deviceIds.size())).first->second;
+    auto referenceId =
+      m_referenceIds.emplace(reference, static_cast<std::uint32_t>(m_referenceIds.size())).first->second;
+
+    auto it = m_keys.find(key);
+    if (it == m_keys.cend())
+    {
+        auto persistenceKey =
+          std::unique_ptr<PersistenceKey>{new PersistenceKey{deviceId, referenceId, deviceKey, reference, key}};
+        it = m_keys.emplace(std::move(key), std::move(persistenceKey)).first;
+    }
+    m_keysByDevice[deviceKey].emplace(reference, it->second.get());
+    return *it->second;
+}
+}    // namespace connect
+}    // namespace wolkabout
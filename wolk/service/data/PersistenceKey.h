@@ -0,0 +1,135 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_PERSISTENCEKEY_H
+#define WOLKABOUTCONNECTOR_PERSISTENCEKEY_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This class represents a key under which a device's data is stored in persistence. It holds the interned ids of the
+ * device and the reference, and the string key that is used with the `Persistence` interface, which is composed only
+ * once per key.
+ */
+class PersistenceKey
+{
+public:
+    /**
+     * Default parameter constructor.
+     *
+     * @param deviceId The interned id of the device key.
+     * @param referenceId The interned id of the reference.
+     * @param deviceKey The key of the device.
+     * @param reference The reference of the feed/attribute/parameter.
+     * @param key The string key used with persistence.
+     */
+    PersistenceKey(std::uint32_t deviceId, std::uint32_t referenceId, std::string deviceKey, std::string reference,
+                   std::string key);
+
+    std::uint32_t getDeviceId() const;
+
+    std::uint32_t getReferenceId() const;
+
+    const std::string& getDeviceKey() const;
+
+    const std::string& getReference() const;
+
+    const std::string& getKey() const;
+
+private:
+    std::uint32_t m_deviceId;
+    std::uint32_t m_referenceId;
+    std::string m_deviceKey;
+    std::string m_reference;
+    std::string m_key;
+};
+
+/**
+ * This class interns persistence keys, so the string keys are composed once per (device, reference) pair, and
+ * string keys obtained from persistence can be resolved without being parsed every time.
+ *
+ * The string key is the device key and the reference separated by the delimiter. Delimiters and escape characters in
+ * the device key are escaped, so no two pairs can map to the same string key, and keys of devices without those
+ * characters look exactly like they used to.
+ */
+class PersistenceKeyRegistry
+{
+public:
+    /**
+     * This method returns the interned key for the pair. The returned reference stays valid as long as the registry.
+     *
+     * @param deviceKey The key of the device.
+     * @param reference The reference of the feed/attribute/parameter.
+     * @return The interned key.
+     */
+    const PersistenceKey& intern(const std::string& deviceKey, const std::string& reference);
+
+    /**
+     * This method resolves a string key obtained from persistence into the interned key. Keys that have not been seen
+     * before (for example, keys stored by a previous run) are parsed once and interned.
+     *
+     * @param key The string key from persistence.
+     * @return The interned key. Nullptr if the key can not be parsed.
+     */
+    const PersistenceKey* resolve(const std::string& key);
+
+    /**
+     * This method composes the string key for a pair.
+     *
+     * @param deviceKey The key of the device.
+     * @param reference The reference of the feed/attribute/parameter.
+     * @return The composed string key.
+     */
+    static std::string compose(const std::string& deviceKey, const std::string& reference);
+
+    /**
+     * This method parses a string key into the device key and the reference.
+     *
+     * @param key The string key.
+     * @param deviceKey The output for the key of the device.
+     * @param reference The output for the reference.
+     * @return Whether the key could be parsed.
+     */
+    static bool decompose(const std::string& key, std::string& deviceKey, std::string& reference);
+
+    static const char DELIMITER;
+    static const char ESCAPE;
+
+private:
+    const PersistenceKey& emplace(const std::string& deviceKey, const std::string& reference, std::string key);
+
+    std::mutex m_mutex;
+
+    // Here are the ids given out to device keys and references
+    std::map<std::string, std::uint32_t> m_deviceIds;
+    std::map<std::string, std::uint32_t> m_referenceIds;
+
+    // Here are the interned keys, indexed by the string key, and by the device key and reference
+    std::map<std::string, std::unique_ptr<PersistenceKey>> m_keys;
+    std::map<std::string, std::map<std::string, const PersistenceKey*>> m_keysByDevice;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_PERSISTENCEKEY_H
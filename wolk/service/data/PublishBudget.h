@@ -0,0 +1,76 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_PUBLISHBUDGET_H
+#define WOLKABOUTCONNECTOR_PUBLISHBUDGET_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This structure describes how much work a single publish slice is allowed to do before it yields the thread back.
+ * Every limit that is set to 0 is considered unlimited.
+ */
+struct PublishBudget
+{
+    explicit PublishBudget(std::uint64_t messagesBudget = 0, std::uint64_t bytesBudget = 0,
+                           std::chrono::milliseconds timeBudget = std::chrono::milliseconds{0})
+    : messages{messagesBudget}, bytes{bytesBudget}, time{timeBudget}
+    {
+    }
+
+    bool isUnlimited() const { return messages == 0 && bytes == 0 && time.count() == 0; }
+
+    // The maximum count of messages sent out in a slice
+    std::uint64_t messages;
+    // The maximum count of payload bytes sent out in a slice
+    std::uint64_t bytes;
+    // The maximum time a slice is allowed to take
+    std::chrono::milliseconds time;
+};
+
+/**
+ * This structure describes the outcome of a single publish slice.
+ */
+struct PublishSliceResult
+{
+    std::uint64_t sentMessages = 0;
+    std::uint64_t sentBytes = 0;
+    std::uint64_t sentReadings = 0;
+    std::uint64_t failedMessages = 0;
+    // Whether there are readings left in persistence because the budget got spent
+    bool backlogRemaining = false;
+};
+
+/**
+ * This structure describes the outcome of a whole publish, as reported to the caller that waits for it.
+ */
+struct PublishResult
+{
+    std::uint64_t sentMessages = 0;
+    std::uint64_t sentReadings = 0;
+    std::uint64_t failedMessages = 0;
+    // The count of persistence keys (device and feed pairs) that still have readings waiting once the publish is done
+    std::uint64_t remainingFeedKeys = 0;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_PUBLISHBUDGET_H
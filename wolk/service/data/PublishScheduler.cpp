@@ -0,0 +1,140 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/service/data/PublishScheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wolkabout
+{
+namespace connect
+{
+const constexpr std::chrono::milliseconds PublishScheduler::DEFAULT_TICK_INTERVAL;
+
+PublishScheduler::PublishScheduler(const PublishSchedule& schedule, std::function<void()> publish)
+: m_schedule{schedule}
+, m_publish{std::move(publish)}
+, m_running{true}
+, m_pendingReadings{0}
+, m_pendingBytes{0}
+, m_deadline{std::chrono::steady_clock::time_point::max()}
+, m_tickInterval{0}
+, m_nextTick{std::chrono::steady_clock::time_point::max()}
+, m_thread{&PublishScheduler::run, this}
+{
+}
+
+PublishScheduler::~PublishScheduler()
+{
+    stop();
+}
+
+void PublishScheduler::readingsAdded(std::uint64_t count, std::uint64_t bytes)
+{
+    if (count == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto now = std::chrono::steady_clock::now();
+    if (m_pendingReadings == 0 && m_schedule.maxLatency.count() > 0)
+        m_deadline = now + m_schedule.maxLatency;
+    m_pendingReadings += count;
+    m_pendingBytes += bytes;
+
+    // The thread only needs to be woken up when the deadline is set, or a threshold is reached
+    if (m_pendingReadings == count || isDue(now))
+        m_condition.notify_one();
+}
+
+void PublishScheduler::setTick(std::chrono::milliseconds interval, std::function<void()> tick)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_tick = nullptr;
+        m_tickInterval = interval;
+        m_nextTick = std::chrono::steady_clock::time_point::max();
+        if (interval.count() > 0 && tick)
+        {
+            m_tick = std::move(tick);
+            m_nextTick = std::chrono::steady_clock::now() + interval;
+        }
+    }
+    m_condition.notify_one();
+}
+
+void PublishScheduler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_running = false;
+    }
+    m_condition.notify_one();
+    if (m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id())
+        m_thread.join();
+}
+
+std::uint64_t PublishScheduler::getPendingReadings()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_pendingReadings;
+}
+
+bool PublishScheduler::isDue(std::chrono::steady_clock::time_point now) const
+{
+    if (m_pendingReadings == 0)
+        return false;
+    return (m_schedule.readings > 0 && m_pendingReadings >= m_schedule.readings) ||
+           (m_schedule.bytes > 0 && m_pendingBytes >= m_schedule.bytes) || now >= m_deadline;
+}
+
+void PublishScheduler::run()
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+    while (m_running)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (m_tick && now >= m_nextTick)
+        {
+            // The tick can add readings, which takes the lock
+            m_nextTick = now + m_tickInterval;
+            const auto tick = m_tick;
+            lock.unlock();
+            tick();
+            lock.lock();
+            continue;
+        }
+
+        if (!isDue(now))
+        {
+            const auto wakeUp = m_pendingReadings > 0 ? std::min(m_deadline, m_nextTick) : m_nextTick;
+            if (wakeUp == std::chrono::steady_clock::time_point::max())
+                m_condition.wait(lock);
+            else
+                m_condition.wait_until(lock, wakeUp);
+            continue;
+        }
+
+        m_pendingReadings = 0;
+        m_pendingBytes = 0;
+        m_deadline = std::chrono::steady_clock::time_point::max();
+        lock.unlock();
+        m_publish();
+        lock.lock();
+    }
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,134 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_PUBLISHSCHEDULER_H
+#define WOLKABOUTCONNECTOR_PUBLISHSCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This structure describes when the readings added since the last publish should be published automatically. The
+ * readings are published as soon as any of the limits is reached. Every limit that is set to 0 is not used.
+ */
+struct PublishSchedule
+{
+    explicit PublishSchedule(std::uint64_t readingsThreshold = 0, std::uint64_t bytesThreshold = 0,
+                             std::chrono::milliseconds latencyThreshold = std::chrono::milliseconds{0})
+    : readings{readingsThreshold}, bytes{bytesThreshold}, maxLatency{latencyThreshold}
+    {
+    }
+
+    bool isDisabled() const { return readings == 0 && bytes == 0 && maxLatency.count() == 0; }
+
+    // The count of added readings that triggers a publish
+    std::uint64_t readings;
+    // The estimated size of added readings that triggers a publish
+    std::uint64_t bytes;
+    // The longest time the first added reading is allowed to wait for a publish
+    std::chrono::milliseconds maxLatency;
+};
+
+/**
+ * This is the object that triggers a publish once the readings added since the last publish reach the limits of a
+ * `PublishSchedule`. It keeps its own thread to wait for the latency deadline, so the publish callback should only
+ * schedule the publish, and not do it.
+ */
+class PublishScheduler
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param schedule The limits that trigger a publish.
+     * @param publish The callback that is invoked when the readings should be published.
+     */
+    PublishScheduler(const PublishSchedule& schedule, std::function<void()> publish);
+
+    PublishScheduler(const PublishScheduler&) = delete;
+    PublishScheduler& operator=(const PublishScheduler&) = delete;
+
+    /**
+     * Default destructor. Stops the scheduler.
+     */
+    ~PublishScheduler();
+
+    /**
+     * This method notifies the scheduler that readings have been added.
+     *
+     * @param count The count of added readings.
+     * @param bytes The estimated size of added readings.
+     */
+    void readingsAdded(std::uint64_t count, std::uint64_t bytes);
+
+    /**
+     * This method sets the tick, which the scheduler's thread invokes periodically, regardless of the added readings.
+     * It is used to close the aggregation windows that are over, which then report their readings as added.
+     *
+     * @param interval The time between two ticks. An interval of 0 stops the ticks.
+     * @param tick The callback that is invoked on every tick. It is invoked without holding the scheduler's lock.
+     */
+    void setTick(std::chrono::milliseconds interval, std::function<void()> tick);
+
+    /**
+     * This method stops the scheduler. Once stopped, it will not trigger publishing anymore.
+     */
+    void stop();
+
+    /**
+     * This is a getter for the count of readings added since the last publish was triggered.
+     *
+     * @return The count of readings.
+     */
+    std::uint64_t getPendingReadings();
+
+    static const constexpr std::chrono::milliseconds DEFAULT_TICK_INTERVAL = std::chrono::milliseconds{1000};
+
+private:
+    bool isDue(std::chrono::steady_clock::time_point now) const;
+
+    void run();
+
+    const PublishSchedule m_schedule;
+    std::function<void()> m_publish;
+
+    // Here is what was added since the last publish, and when the oldest of it was added
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_running;
+    std::uint64_t m_pendingReadings;
+    std::uint64_t m_pendingBytes;
+    std::chrono::steady_clock::time_point m_deadline;
+
+    // Here is the periodic tick, and when it is invoked next
+    std::function<void()> m_tick;
+    std::chrono::milliseconds m_tickInterval;
+    std::chrono::steady_clock::time_point m_nextTick;
+
+    std::thread m_thread;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_PUBLISHSCHEDULER_H
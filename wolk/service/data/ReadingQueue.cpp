@@ -0,0 +1,111 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/service/data/ReadingQueue.h"
+
+#include <cstdint>
+
+namespace wolkabout
+{
+namespace connect
+{
+namespace
+{
+std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+    auto result = std::size_t{2};
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+std::intptr_t difference(std::size_t left, std::size_t right)
+{
+    return static_cast<std::intptr_t>(left - right);
+}
+}    // namespace
+
+const constexpr std::size_t ReadingQueue::DEFAULT_CAPACITY;
+
+ReadingQueue::ReadingQueue(std::size_t capacity)
+: m_mask(roundUpToPowerOfTwo(capacity) - 1)
+, m_slots(new Slot[m_mask + 1])
+, m_enqueuePosition(0)
+, m_dequeuePosition(0)
+{
+    // Every slot starts as free for the producer that claims its position
+    for (std::size_t i = 0; i <= m_mask; ++i)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool ReadingQueue::push(ReadingRecord& record)
+{
+    auto position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    while (true)
+    {
+        slot = &m_slots[position & m_mask];
+        const auto sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto offset = difference(sequence, position);
+        if (offset == 0)
+        {
+            // The slot is free, try to claim the position
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (offset < 0)
+        {
+            // The slot still holds a record the consumer hasn't taken, so the queue is full
+            return false;
+        }
+        else
+        {
+            // Another producer claimed the position
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record = std::move(record);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool ReadingQueue::pop(ReadingRecord& record)
+{
+    const auto position = m_dequeuePosition.load(std::memory_order_relaxed);
+    auto& slot = m_slots[position & m_mask];
+    if (difference(slot.sequence.load(std::memory_order_acquire), position + 1) < 0)
+        return false;
+
+    record = std::move(slot.record);
+    slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+    m_dequeuePosition.store(position + 1, std::memory_order_relaxed);
+    return true;
+}
+
+std::size_t ReadingQueue::size() const
+{
+    const auto enqueued = m_enqueuePosition.load(std::memory_order_relaxed);
+    const auto dequeued = m_dequeuePosition.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+std::size_t ReadingQueue::getCapacity() const
+{
+    return m_mask + 1;
+}
+}    // namespace connect
+}    // namespace wolkabout
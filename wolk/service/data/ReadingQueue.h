@@ -0,0 +1,114 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_READINGQUEUE_H
+#define WOLKABOUTCONNECTOR_READINGQUEUE_H
+
+#include "wolk/service/data/ReadingValue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This is a single reading waiting in the `ReadingQueue`, in the plain form it was given to the Wolk object. The values
+ * are kept in their compact form, and converted into strings when the record is taken out of the queue.
+ */
+struct ReadingRecord
+{
+    std::string deviceKey;
+    std::string reference;
+    // Single value readings only use `value`, multi-value readings only use `values`
+    ReadingValue value;
+    std::vector<ReadingValue> values;
+    bool multi = false;
+    std::uint64_t rtc = 0;
+};
+
+/**
+ * This is a bounded, lock-free queue of reading records, that any count of threads can push into, while a single
+ * thread takes them out. The slots are allocated once, and records are moved in and out of them.
+ */
+class ReadingQueue
+{
+public:
+    /**
+     * Default constructor.
+     *
+     * @param capacity The count of records the queue can hold. It is rounded up to a power of two.
+     */
+    explicit ReadingQueue(std::size_t capacity = DEFAULT_CAPACITY);
+
+    ReadingQueue(const ReadingQueue&) = delete;
+    ReadingQueue& operator=(const ReadingQueue&) = delete;
+
+    /**
+     * This method pushes a record into the queue. It is safe to call from multiple threads.
+     *
+     * @param record The record that will be moved into the queue.
+     * @return Whether the record was queued. It is not queued (and not moved from) if the queue is full.
+     */
+    bool push(ReadingRecord& record);
+
+    /**
+     * This method takes the oldest record out of the queue. It must only be called from a single thread at a time.
+     *
+     * @param record The record into which the oldest record will be moved.
+     * @return Whether there was a record in the queue.
+     */
+    bool pop(ReadingRecord& record);
+
+    /**
+     * This is a getter for the count of records in the queue. It is only an estimate while records are being pushed.
+     *
+     * @return The count of records.
+     */
+    std::size_t size() const;
+
+    /**
+     * This is a getter for the capacity of the queue.
+     *
+     * @return The count of records the queue can hold.
+     */
+    std::size_t getCapacity() const;
+
+    static const constexpr std::size_t DEFAULT_CAPACITY = 4096;
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        ReadingRecord record;
+    };
+
+    const std::size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // The positions are padded apart, so the producers and the consumer don't share a cache line
+    std::atomic<std::size_t> m_enqueuePosition;
+    char m_padding[64];
+    std::atomic<std::size_t> m_dequeuePosition;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_READINGQUEUE_H
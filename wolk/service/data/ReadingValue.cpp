@@ -0,0 +1,77 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wolk/service/data/ReadingValue.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+
+namespace wolkabout
+{
+namespace connect
+{
+ReadingValue::ReadingValue() : m_type(Type::String), m_int(0) {}
+
+ReadingValue::ReadingValue(std::string value) : m_type(Type::String), m_int(0), m_string(std::move(value)) {}
+
+ReadingValue::ReadingValue(const char* value) : m_type(Type::String), m_int(0), m_string(value != nullptr ? value : "")
+{
+}
+
+ReadingValue::Type ReadingValue::getType() const
+{
+    return m_type;
+}
+
+std::string ReadingValue::toString() const
+{
+    switch (m_type)
+    {
+    case Type::Bool:
+        return StringUtils::toString(m_bool);
+    case Type::Int:
+        return StringUtils::toString(m_int);
+    case Type::UInt:
+        return StringUtils::toString(m_uint);
+    case Type::Float:
+        return StringUtils::toString(m_float);
+    case Type::Double:
+        return StringUtils::toString(m_double);
+    case Type::String:
+    default:
+        return m_string;
+    }
+}
+
+std::string ReadingValue::takeString()
+{
+    if (m_type == Type::String)
+        return std::move(m_string);
+    return toString();
+}
+
+bool ReadingValue::parseNumber(const std::string& value, double& number)
+{
+    if (value.empty())
+        return false;
+    char* end = nullptr;
+    errno = 0;
+    number = std::strtod(value.c_str(), &end);
+    return errno == 0 && end == value.c_str() + value.size() && std::isfinite(number);
+}
+}    // namespace connect
+}    // namespace wolkabout
@@ -0,0 +1,165 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_READINGVALUE_H
+#define WOLKABOUTCONNECTOR_READINGVALUE_H
+
+#include "core/utilities/StringUtils.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This is a compact value of a reading waiting to be stored. Numeric and boolean values are kept in their own type,
+ * and are converted into a string only once the reading is handed over to the data service.
+ */
+class ReadingValue
+{
+public:
+    enum class Type : std::uint8_t
+    {
+        String,
+        Bool,
+        Int,
+        UInt,
+        Float,
+        Double
+    };
+
+    /**
+     * Default constructor. Creates an empty string value.
+     */
+    ReadingValue();
+
+    ReadingValue(std::string value);
+    ReadingValue(const char* value);
+
+    /**
+     * Constructor for boolean values.
+     */
+    template <typename T, typename std::enable_if<std::is_same<T, bool>::value, int>::type = 0>
+    ReadingValue(T value) : m_type(Type::Bool), m_bool(value)
+    {
+    }
+
+    /**
+     * Constructor for signed integers. Character types are left out, as they are printed as characters.
+     */
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value &&
+                                                    !std::is_same<T, char>::value &&
+                                                    !std::is_same<T, signed char>::value &&
+                                                    !std::is_same<T, wchar_t>::value,
+                                                  int>::type = 0>
+    ReadingValue(T value) : m_type(Type::Int), m_int(static_cast<long long>(value))
+    {
+    }
+
+    /**
+     * Constructor for unsigned integers. Character types are left out, as they are printed as characters.
+     */
+    template <typename T,
+              typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                                        !std::is_same<T, bool>::value && !std::is_same<T, char>::value &&
+                                        !std::is_same<T, unsigned char>::value && !std::is_same<T, wchar_t>::value &&
+                                        !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value,
+                                      int>::type = 0>
+    ReadingValue(T value) : m_type(Type::UInt), m_uint(static_cast<unsigned long long>(value))
+    {
+    }
+
+    /**
+     * Constructor for floating point values. `long double` is left out, as it doesn't fit.
+     */
+    template <typename T, typename std::enable_if<std::is_same<T, float>::value, int>::type = 0>
+    ReadingValue(T value) : m_type(Type::Float), m_float(value)
+    {
+    }
+
+    template <typename T, typename std::enable_if<std::is_same<T, double>::value, int>::type = 0>
+    ReadingValue(T value) : m_type(Type::Double), m_double(value)
+    {
+    }
+
+    /**
+     * This method creates the value for any type that can be added as a reading. Types that can not be held in
+     * their own form are converted into a string right away.
+     *
+     * @param value The value of the reading.
+     * @return The reading value.
+     */
+    template <typename T> static ReadingValue from(const T& value)
+    {
+        return from(value, std::is_constructible<ReadingValue, const T&>{});
+    }
+
+    /**
+     * This is a getter for the type in which the value is held.
+     *
+     * @return The type of the value.
+     */
+    Type getType() const;
+
+    /**
+     * This method converts the value into the string that is sent to the platform.
+     *
+     * @return The value as string.
+     */
+    std::string toString() const;
+
+    /**
+     * This method takes the value as string. String values are moved out, the others are converted.
+     *
+     * @return The value as string.
+     */
+    std::string takeString();
+
+    /**
+     * This method parses a value that was sent as a string, like the value of a stored reading, as a number.
+     *
+     * @param value The value as string.
+     * @param number The number into which the value is parsed.
+     * @return Whether the whole value is a finite number.
+     */
+    static bool parseNumber(const std::string& value, double& number);
+
+private:
+    template <typename T> static ReadingValue from(const T& value, std::true_type) { return ReadingValue(value); }
+
+    template <typename T> static ReadingValue from(const T& value, std::false_type)
+    {
+        return ReadingValue(StringUtils::toString(value));
+    }
+
+    Type m_type;
+    union
+    {
+        bool m_bool;
+        long long m_int;
+        unsigned long long m_uint;
+        float m_float;
+        double m_double;
+    };
+    std::string m_string;
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_READINGVALUE_H
@@ -0,0 +1,38 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKABOUTCONNECTOR_READINGSPUBLISHMODE_H
+#define WOLKABOUTCONNECTOR_READINGSPUBLISHMODE_H
+
+namespace wolkabout
+{
+namespace connect
+{
+/**
+ * This enumeration describes the way the readings held in persistence are packed into outgoing messages.
+ *
+ * `PerFeed` - every feed of a device is sent in its own `FeedValuesMessage`.
+ * `PerDevice` - all the pending feeds of a device are coalesced into as few `FeedValuesMessage`s as the budget allows.
+ */
+enum class ReadingsPublishMode
+{
+    PerFeed,
+    PerDevice
+};
+}    // namespace connect
+}    // namespace wolkabout
+
+#endif    // WOLKABOUTCONNECTOR_READINGSPUBLISHMODE_H
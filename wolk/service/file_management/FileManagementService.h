@@ -20,7 +20,7 @@
 #include "core/connectivity/ConnectivityService.h"
 #include "core/connectivity/InboundMessageHandler.h"
 #include "core/protocol/FileManagementProtocol.h"
-#include "core/utilities/CommandBuffer.h"
+#include "wolk/WorkerPool.h"
 #include "wolk/api/FileListener.h"
 #include "wolk/service/data/DataService.h"
 #include "wolk/service/file_management/FileDownloader.h"
@@ -189,7 +189,7 @@ private:
 
     // Make place for the listener pointer
     std::weak_ptr<FileListener> m_fileListener;
-    CommandBuffer m_commandBuffer;
+    SerialExecutor m_commandBuffer;
 };
 }    // namespace connect
 }    // namespace wolkabout
@@ -32,7 +32,7 @@ namespace connect
 {
 FileTransferSession::FileTransferSession(std::string deviceKey, const FileUploadInitiateMessage& message,
                                          std::function<void(FileTransferStatus, FileTransferError)> callback,
-                                         CommandBuffer& commandBuffer)
+                                         SerialExecutor& commandBuffer)
 : m_deviceKey(std::move(deviceKey))
 , m_name(message.getName())
 , m_retryCount(0)
@@ -48,7 +48,7 @@ FileTransferSession::FileTransferSession(std::string deviceKey, const FileUpload
 
 FileTransferSession::FileTransferSession(std::string deviceKey, const FileUrlDownloadInitMessage& message,
                                          std::function<void(FileTransferStatus, FileTransferError)> callback,
-                                         CommandBuffer& commandBuffer, std::shared_ptr<FileDownloader> fileDownloader)
+                                         SerialExecutor& commandBuffer, std::shared_ptr<FileDownloader> fileDownloader)
 : m_deviceKey(std::move(deviceKey))
 , m_url(message.getPath())
 , m_retryCount(0)
@@ -18,7 +18,7 @@
 #define WOLKABOUTCONNECTOR_FILETRANSFERSESSION_H
 
 #include "core/utilities/ByteUtils.h"
-#include "core/utilities/CommandBuffer.h"
+#include "wolk/WorkerPool.h"
 #include "wolk/service/file_management/FileDownloader.h"
 
 #include <memory>
@@ -61,7 +61,7 @@ public:
      */
     FileTransferSession(std::string deviceKey, const FileUploadInitiateMessage& message,
                         std::function<void(FileTransferStatus, FileTransferError)> callback,
-                        CommandBuffer& commandBuffer);
+                        SerialExecutor& commandBuffer);
 
     /**
      * Default constructor for the FileTransferSession in case of a url download transfer.
@@ -74,7 +74,7 @@ public:
      */
     FileTransferSession(std::string deviceKey, const FileUrlDownloadInitMessage& message,
                         std::function<void(FileTransferStatus, FileTransferError)> callback,
-                        CommandBuffer& commandBuffer, std::shared_ptr<FileDownloader> fileDownloader);
+                        SerialExecutor& commandBuffer, std::shared_ptr<FileDownloader> fileDownloader);
 
     /**
      * Default virtual destructor.
@@ -210,7 +210,7 @@ private:
     FileTransferStatus m_status;
     FileTransferError m_error;
     std::function<void(FileTransferStatus, FileTransferError)> m_callback;
-    CommandBuffer& m_commandBuffer;
+    SerialExecutor& m_commandBuffer;
 };
 }    // namespace connect
 }    // namespace wolkabout
@@ -18,7 +18,7 @@
 #define WOLKABOUTCONNECTOR_HTTPFILEDOWNLOADER_H
 
 #include "core/utilities/ByteUtils.h"
-#include "core/utilities/CommandBuffer.h"
+#include "wolk/WorkerPool.h"
 #include "wolk/service/file_management/FileDownloader.h"
 
 #include <memory>
@@ -144,7 +144,7 @@ private:
     std::string m_name;
     ByteArray m_bytes;
     std::function<void(FileTransferStatus, FileTransferError, std::string)> m_statusCallback;
-    CommandBuffer m_commandBuffer;
+    SerialExecutor m_commandBuffer;
 
     // Here we store the session so the session can be closed in case of abort
     std::mutex m_sessionMutex;
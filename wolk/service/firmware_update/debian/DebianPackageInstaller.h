@@ -133,7 +133,7 @@ protected:
     std::unordered_map<std::string, UpdateCallback> m_callbacks;
 
     // And the command buffer where to execute the callbacks
-    CommandBuffer m_commandBuffer;
+    SerialExecutor m_commandBuffer;
     std::mutex m_mapMutex;
     std::map<std::string, std::string> m_devicesInstallingFiles;
     std::map<std::string, InstallResponse> m_deviceInstallationResult;
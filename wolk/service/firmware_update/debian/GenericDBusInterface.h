@@ -17,7 +17,7 @@
 #ifndef WOLKABOUTCONNECTOR_GENERICDBUSINTERFACE_H
 #define WOLKABOUTCONNECTOR_GENERICDBUSINTERFACE_H
 
-#include "core/utilities/CommandBuffer.h"
+#include "wolk/WorkerPool.h"
 
 #include <functional>
 #include <gio/gio.h>
@@ -247,7 +247,7 @@ protected:
      */
     GDBusConnection* m_dbusConnection;
     GMainLoop* m_mainLoop;
-    wolkabout::CommandBuffer m_commandBuffer;
+    SerialExecutor m_commandBuffer;
 
     /**
      * Signal subscriptions.
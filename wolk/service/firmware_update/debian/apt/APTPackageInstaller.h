@@ -120,7 +120,7 @@ protected:
     std::unordered_map<std::string, InstallationCallback> m_callbacks;
 
     // And a command buffer where we execute callback
-    CommandBuffer m_commandBuffer;
+    SerialExecutor m_commandBuffer;
 
     // Thread where we run the main loop of the DBus connection
     std::thread m_thread;
@@ -18,7 +18,7 @@
 #define WOLKABOUTCONNECTOR_PLATFORMSTATUSSERVICE_H
 
 #include "core/MessageListener.h"
-#include "core/utilities/CommandBuffer.h"
+#include "wolk/WorkerPool.h"
 #include "wolk/api/PlatformStatusListener.h"
 
 #include <functional>
@@ -68,7 +68,7 @@ private:
     std::shared_ptr<PlatformStatusListener> m_listener;
 
     // Here we have the command buffer that will execute external calls.
-    CommandBuffer m_commandBuffer;
+    SerialExecutor m_commandBuffer;
 };
 }    // namespace connect
 }    // namespace wolkabout
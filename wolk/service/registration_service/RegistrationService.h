@@ -23,8 +23,8 @@
 #include "core/model/Attribute.h"
 #include "core/model/Feed.h"
 #include "core/protocol/RegistrationProtocol.h"
-#include "core/utilities/CommandBuffer.h"
 #include "core/utilities/Service.h"
+#include "wolk/WorkerPool.h"
 #include "wolk/service/error/ErrorService.h"
 
 #include <unordered_map>
@@ -259,7 +259,7 @@ private:
       m_deviceRegistrationResponses;
 
     // Have a command buffer for calling some callbacks
-    CommandBuffer m_commandBuffer;
+    SerialExecutor m_commandBuffer;
 };
 }    // namespace connect
 }    // namespace wolkabout